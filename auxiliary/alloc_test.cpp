@@ -0,0 +1,155 @@
+#include "../src/vmaware.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+/*
+ * Checks that the allocation-free part of the API really stays off the heap
+ * once the technique cache is warm. Every global operator new is counted
+ * while a probe is armed, so any hidden std::string or std::vector shows up.
+ *
+ * build: g++ -std=c++17 -O2 -pthread auxiliary/alloc_test.cpp -o alloc_test
+ */
+
+/* GCC can't tell these replacements pair malloc with free on purpose */
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<bool> armed(false);
+static std::atomic<std::size_t> allocations(0);
+
+void* operator new(std::size_t size) {
+    if (armed.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void* ptr = std::malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+static void check(bool condition, const char* label) {
+    if (condition) {
+        std::cout << "  PASS  " << label << "\n";
+        ++pass_count;
+    }
+    else {
+        std::cerr << "  FAIL  " << label << "\n";
+        ++fail_count;
+    }
+}
+
+/* Run the callable with the counter armed and return how many allocations it made */
+template <typename F>
+static std::size_t count_allocations(F&& fn) {
+    allocations.store(0);
+    armed.store(true);
+    fn();
+    armed.store(false);
+    return allocations.load();
+}
+
+int main() {
+    /* Warm up: run every technique once so the cache, the thread_local profile and any lazy statics are in place */
+    const bool is_vm = VM::detect();
+    const VM::brand_set warm_ranking = VM::brand_ranking();
+    const VM::flagset warm_detected = VM::detected_flags();
+    const std::uint8_t warm_percent = VM::percentage();
+    const char* warm_type = VM::type_name();
+
+    std::cout << "=== Allocation-free hot path ===\n";
+
+    bool detect_result = !is_vm;
+    check(count_allocations([&] { detect_result = VM::detect(); }) == 0, "VM::detect() does not allocate");
+
+    std::uint8_t percent = 0;
+    check(count_allocations([&] { percent = VM::percentage(); }) == 0, "VM::percentage() does not allocate");
+
+    VM::brand_set ranking;
+    check(count_allocations([&] { ranking = VM::brand_ranking(); }) == 0, "VM::brand_ranking() does not allocate");
+
+    VM::brand_enum id = VM::brand_enum::INVALID;
+    check(count_allocations([&] { id = VM::brand_id(); }) == 0, "VM::brand_id() does not allocate");
+
+    const char* name = nullptr;
+    check(count_allocations([&] { name = VM::brand_name(); }) == 0, "VM::brand_name() does not allocate");
+
+    const char* type = nullptr;
+    check(count_allocations([&] { type = VM::type_name(VM::MULTIPLE); }) == 0, "VM::type_name() does not allocate");
+
+    VM::flagset detected;
+    check(count_allocations([&] { detected = VM::detected_flags(); }) == 0, "VM::detected_flags() does not allocate");
+
+    char conclusion[512];
+    char dynamic[512];
+    std::size_t conclusion_length = 0;
+    check(count_allocations([&] {
+        conclusion_length = VM::conclusion_into(conclusion, sizeof(conclusion));
+        VM::conclusion_into(dynamic, sizeof(dynamic), VM::DYNAMIC, VM::MULTIPLE);
+    }) == 0, "VM::conclusion_into() does not allocate");
+
+    std::cout << "\n=== Same answers as the allocating API ===\n";
+
+    check(detect_result == is_vm, "VM::detect() matches the warm-up run");
+    check(percent == warm_percent, "VM::percentage() matches the warm-up run");
+    check(ranking.size() == warm_ranking.size(), "VM::brand_ranking() matches the warm-up run");
+    check(detected == warm_detected, "VM::detected_flags() matches the warm-up run");
+    check(std::string(name) == VM::brand(), "VM::brand_name() matches VM::brand()");
+    check(std::string(VM::type_name()) == VM::type(), "VM::type_name() matches VM::type()");
+    check(std::string(warm_type) == std::string(VM::type_name()), "VM::type_name() is stable");
+    check(id == ranking.front().first, "VM::brand_id() is the top of VM::brand_ranking()");
+    check(detected.count() == VM::detected_count(), "VM::detected_flags() agrees with VM::detected_count()");
+    check(std::string(conclusion) == VM::conclusion() && conclusion_length == VM::conclusion().size(), "VM::conclusion_into() matches VM::conclusion()");
+    check(std::string(dynamic) == VM::conclusion(VM::DYNAMIC, VM::MULTIPLE), "VM::conclusion_into() matches VM::conclusion() with VM::DYNAMIC and VM::MULTIPLE");
+
+    char short_buffer[8];
+    const std::size_t full_length = VM::conclusion_into(short_buffer, sizeof(short_buffer));
+    check(full_length == conclusion_length && std::string(short_buffer) == std::string(conclusion, sizeof(short_buffer) - 1), "VM::conclusion_into() cuts the message short to fit and still returns its whole length");
+
+    const VM::brand_list_t list = VM::brands::brand_list(VM::core::generate_default());
+    bool same_list = (list.size() == ranking.size());
+    for (std::size_t i = 0; same_list && i < list.size(); ++i) {
+        same_list = (list[i] == ranking[i]);
+    }
+    check(same_list, "VM::brand_ranking() matches the cached brand list");
+
+    std::cout << "\n-----------\n";
+    std::cout << "PASSED: " << pass_count << "\n";
+    if (fail_count > 0) {
+        std::cerr << "FAILED: " << fail_count << "\n";
+    }
+    else {
+        std::cout << "FAILED: " << fail_count << "\n";
+    }
+
+    return (fail_count > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
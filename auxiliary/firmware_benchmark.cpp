@@ -0,0 +1,168 @@
+#include "../src/vmaware.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/*
+ * Cost of looking for the FIRMWARE signatures in ACPI tables. "legacy" is the
+ * previous scan: one memchr + memcmp pass over the table per signature.
+ * "pattern_set" is util::pattern_set, which finds all of them in one sweep.
+ * Both must agree on which signatures each table contains.
+ *
+ * Tables are read from the files and directories given on the command line,
+ * e.g. the *.dat files of a recorded "acpidump -b", or from the live
+ * /sys/firmware/acpi/tables/ (root only) when none are given.
+ *
+ * build: g++ -std=c++17 -O2 -pthread auxiliary/firmware_benchmark.cpp -o firmware_benchmark
+ * usage: ./firmware_benchmark [iterations] [table files or directories...]
+ */
+
+static const std::vector<std::string>& signatures() {
+    static const std::vector<std::string> list = {
+        std::string("\x5B\x80\x44\x42\x47\x5F\x01\x0B\x02\x04\x01", 11),
+        "DBUG", "DBGB", "DRAC", "PNP0C01", "SMI resources", "SMI interface",
+        std::string("\x0C\x41\xD0\x0A\x06", 5),
+        "CPU Hotplug resources", "PCI Hotplug resources", "PRTP", "PRTA", "HPET",
+        std::string("\x91\x93\x61\x00\x94\x61\x0C\x00\xE1\xF5\x05", 11),
+        "LNKE", "LNKH", "GSIE", "GSIH", "GPER", "PNP0A06", "D0FA",
+        std::string("\x08\x5F\x41\x44\x52\x0C\x02\x00\x1F\x00", 10),
+        "PXEN", "BOCHS",
+        "Parallels Software", "Parallels(R)", "innotek", "Oracle", "VirtualBox", "vbox", "VBOX",
+        "VMware, Inc.", "VMware", "VMWARE", "VMW0003", "QEMU", "pc-q35", "Q35 +", "FWCF", "BOCHS",
+        "ovmf", "edk ii unknown", "WAET", "S3 Corp.", "Virtual Machine", "VS2005R2", "BXPC", "Xen"
+    };
+    return list;
+}
+
+static bool legacy_find(const std::uint8_t* buffer, const std::size_t buffer_len, const std::string& pattern) {
+    const std::size_t pattern_len = pattern.size();
+    if (pattern_len == 0 || pattern_len > buffer_len) {
+        return false;
+    }
+
+    const std::uint8_t* search_ptr = buffer;
+    std::size_t remaining_bytes = buffer_len;
+
+    while (remaining_bytes >= pattern_len) {
+        const void* match = std::memchr(search_ptr, static_cast<std::uint8_t>(pattern[0]), remaining_bytes);
+        if (!match) {
+            return false;
+        }
+        const std::uint8_t* match_ptr = static_cast<const std::uint8_t*>(match);
+        const std::size_t index = static_cast<std::size_t>(match_ptr - buffer);
+        if (index + pattern_len > buffer_len) {
+            return false;
+        }
+        if (std::memcmp(match_ptr, pattern.data(), pattern_len) == 0) {
+            return true;
+        }
+        search_ptr = match_ptr + 1;
+        remaining_bytes = buffer_len - static_cast<std::size_t>(search_ptr - buffer);
+    }
+    return false;
+}
+
+static std::uint64_t legacy_scan(const std::vector<std::uint8_t>& table) {
+    std::uint64_t found = 0;
+    for (std::size_t i = 0; i < signatures().size(); ++i) {
+        if (legacy_find(table.data(), table.size(), signatures()[i])) {
+            found |= 1ull << i;
+        }
+    }
+    return found;
+}
+
+static void add_tables(const std::string& path, std::vector<std::pair<std::string, std::vector<std::uint8_t>>>& tables) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        std::fprintf(stderr, "cannot stat %s\n", path.c_str());
+        return;
+    }
+
+    if (S_ISDIR(info.st_mode)) {
+        DIR* dir = opendir(path.c_str());
+        if (!dir) {
+            return;
+        }
+        while (const struct dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                add_tables(path + "/" + entry->d_name, tables);
+            }
+        }
+        closedir(dir);
+        return;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!data.empty()) {
+        tables.emplace_back(path, std::move(data));
+    }
+}
+
+template <typename F>
+static double ns_per_call(const int iterations, F&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+    const int iterations = (argc > 1) ? std::atoi(argv[1]) : 2000;
+
+    std::vector<std::pair<std::string, std::vector<std::uint8_t>>> tables;
+    for (int i = 2; i < argc; ++i) {
+        add_tables(argv[i], tables);
+    }
+    if (argc <= 2) {
+        add_tables("/sys/firmware/acpi/tables", tables);
+    }
+    if (tables.empty()) {
+        std::fprintf(stderr, "no tables to scan\n");
+        return 1;
+    }
+
+    VM::util::pattern_set set;
+    for (const std::string& signature : signatures()) {
+        set.add(signature.data(), signature.size());
+    }
+
+    std::printf("%-44s %10s %12s %12s %8s\n", "table", "bytes", "legacy ns", "pattern_set", "speedup");
+
+    volatile std::uint64_t sink = 0;
+    double legacy_total = 0, set_total = 0;
+    bool agree = true;
+
+    for (const auto& table : tables) {
+        std::size_t first[VM::util::pattern_set::max_patterns];
+        const std::uint64_t expected = legacy_scan(table.second);
+        const std::uint64_t found = set.scan(table.second.data(), table.second.size(), first);
+        if (expected != found) {
+            std::fprintf(stderr, "MISMATCH in %s: legacy %llx, pattern_set %llx\n", table.first.c_str(),
+                static_cast<unsigned long long>(expected), static_cast<unsigned long long>(found));
+            agree = false;
+        }
+
+        const double legacy = ns_per_call(iterations, [&] { sink = sink + legacy_scan(table.second); });
+        const double swept = ns_per_call(iterations, [&] { sink = sink + set.scan(table.second.data(), table.second.size(), first); });
+
+        legacy_total += legacy;
+        set_total += swept;
+
+        std::printf("%-44s %10zu %12.0f %12.0f %7.1fx\n", table.first.c_str(), table.second.size(), legacy, swept, legacy / swept);
+    }
+
+    std::printf("%-44s %10s %12.0f %12.0f %7.1fx\n", "total", "", legacy_total, set_total, legacy_total / set_total);
+
+    return agree ? 0 : 1;
+}
@@ -0,0 +1,390 @@
+#include "../src/vmaware.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Feeds the parsers and scanners hand-built inputs, so they can be checked on
+ * machines (and containers) that don't have the real files to parse.
+ *
+ * build: g++ -std=c++17 -O2 -pthread auxiliary/fixture_test.cpp -o fixture_test
+ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+static void check(bool condition, const char* label) {
+    if (condition) {
+        std::cout << "  PASS  " << label << "\n";
+        ++pass_count;
+    }
+    else {
+        std::cerr << "  FAIL  " << label << "\n";
+        ++fail_count;
+    }
+}
+
+#if defined(__linux__)
+/* Append one SMBIOS structure: its formatted area, then its strings and the double null */
+static void add_structure(std::vector<std::uint8_t>& table, std::vector<std::uint8_t> formatted, const std::vector<std::string>& strings) {
+    formatted[1] = static_cast<std::uint8_t>(formatted.size());
+    table.insert(table.end(), formatted.begin(), formatted.end());
+
+    for (const std::string& s : strings) {
+        table.insert(table.end(), s.begin(), s.end());
+        table.push_back(0);
+    }
+    if (strings.empty()) {
+        table.push_back(0);
+    }
+    table.push_back(0);
+}
+
+static std::vector<std::uint8_t> make_table(const bool vm_bit) {
+    std::vector<std::uint8_t> table;
+
+    /* Type 0, BIOS: vendor is string 1, version string 2, byte 0x13 holds the VM bit */
+    std::vector<std::uint8_t> bios(0x18, 0);
+    bios[0] = 0;
+    bios[0x04] = 1;
+    bios[0x05] = 2;
+    bios[0x13] = vm_bit ? 0x10 : 0x00;
+    add_structure(table, bios, { "SeaBIOS", "1.16.3" });
+
+    /* Type 1, system: manufacturer, product, then SKU at 0x19 and family at 0x1A */
+    std::vector<std::uint8_t> system(0x1B, 0);
+    system[0] = 1;
+    system[0x04] = 1;
+    system[0x05] = 2;
+    system[0x19] = 3;
+    system[0x1A] = 4;
+    add_structure(table, system, { "QEMU", "Standard PC (Q35 + ICH9, 2009)", "sku-1", "Virtual Machine" });
+
+    /* A structure the parser doesn't care about, with no strings at all */
+    std::vector<std::uint8_t> unrelated(0x08, 0);
+    unrelated[0] = 32;
+    add_structure(table, unrelated, {});
+
+    /* Type 2, board */
+    std::vector<std::uint8_t> board(0x08, 0);
+    board[0] = 2;
+    board[0x04] = 1;
+    board[0x05] = 2;
+    add_structure(table, board, { "Oracle Corporation", "VirtualBox" });
+
+    /* Type 3, chassis: type "Other" with the lock bit set, asset tag at 0x08 */
+    std::vector<std::uint8_t> chassis(0x09, 0);
+    chassis[0] = 3;
+    chassis[0x04] = 1;
+    chassis[0x05] = 0x81;
+    chassis[0x08] = 2;
+    add_structure(table, chassis, { "QEMU", "No Asset Tag" });
+
+    /* A second type 1 must not override the first */
+    std::vector<std::uint8_t> second(0x08, 0);
+    second[0] = 1;
+    second[0x04] = 1;
+    add_structure(table, second, { "Not the first one" });
+
+    std::vector<std::uint8_t> end(0x04, 0);
+    end[0] = 127;
+    add_structure(table, end, {});
+
+    return table;
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    (void)argc;
+    (void)argv;
+
+    std::cout << "=== Multi-pattern scanner ===\n";
+    {
+        VM::util::pattern_set set;
+        const std::size_t xen = set.add("Xen", 3);
+        const std::size_t bxpc = set.add("BXPC", 4);
+        const std::size_t missing = set.add("VMware", 6);
+        const std::uint8_t eisa[] = { 0x0C, 0x41, 0xD0, 0x0A, 0x06 };
+        const std::size_t binary = set.add(eisa, sizeof(eisa));
+
+        /* "BXPC" straddles the first 16-byte block, "Xen" shows up twice and ends the buffer */
+        std::string table(40, '.');
+        table.replace(14, 4, "BXPC");
+        table.replace(20, 3, "Xen");
+        table.append(reinterpret_cast<const char*>(eisa), sizeof(eisa));
+        table.append("Xen");
+
+        const auto* data = reinterpret_cast<const std::uint8_t*>(table.data());
+        std::size_t first[VM::util::pattern_set::max_patterns];
+        const std::uint64_t found = set.scan(data, table.size(), first);
+
+        check(found == ((1ull << xen) | (1ull << bxpc) | (1ull << binary)), "every pattern in the buffer is found, and only those");
+        check(first[bxpc] == 14 && first[xen] == 20 && first[binary] == 40, "offsets are those of the first match");
+        check(first[missing] == VM::util::pattern_set::npos, "a missing pattern has no offset");
+        check(set.scan(data + table.size() - 2, 2, first) == 0, "a buffer shorter than any pattern has no matches");
+        check(set.add("XY", 2) == VM::util::pattern_set::npos, "patterns shorter than the fingerprint are refused");
+    }
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    std::cout << "\n=== CPUID snapshot ===\n";
+    {
+        using snapshot = VM::memo::cpuid_snapshot;
+
+        std::vector<snapshot::record> live(snapshot::SLOTS);
+        const std::size_t live_count = snapshot::capture(live.data(), live.size());
+        live.resize(live_count);
+
+        unsigned a = 0, b = 0, c = 0, d = 0;
+        VM::cpu::cpuid_live(a, b, c, d, 0);
+        check(live_count > 0 && live[0].leaf == 0 && live[0].regs[0] == a && live[0].regs[1] == b, "capture() records what the CPU answers");
+
+        /* A KVM guest on an Intel host, as a test would record it */
+        const snapshot::record kvm[] = {
+            { 0x00000000, snapshot::default_subleaf, { 0x0D, 0x756E6547, 0x6C65746E, 0x49656E69 } }, /* GenuineIntel */
+            { 0x00000001, snapshot::default_subleaf, { 0x000906EA, 0, 0x80000000, 0 } },             /* hypervisor bit */
+            { 0x40000000, snapshot::default_subleaf, { 0x40000001, 0x4B4D564B, 0x564B4D56, 0x0000004D } } /* KVMKVMKVM */
+        };
+        snapshot::load(kvm, 3);
+
+        VM::cpu::cpuid(a, b, c, d, VM::cpu::leaf::features);
+        check((c >> 31) == 1, "loaded leaves replace the CPU");
+        check(VM::cpu::is_intel() && !VM::cpu::is_amd(), "vendor comes from the loaded leaf 0");
+        check(VM::cpu::is_leaf_supported(VM::cpu::leaf::ext_features) && !VM::cpu::is_leaf_supported(VM::cpu::leaf::hv_processors), "supported leaves follow the loaded maximums");
+        check(std::string(VM::cpu::cpu_manufacturer(VM::cpu::leaf::hypervisor)) == "KVMKVMKVM", "hypervisor vendor from the loaded 0x40000000");
+
+        VM::cpu::cpuid(a, b, c, d, VM::cpu::leaf::brand1);
+        check(a == 0 && b == 0 && c == 0 && d == 0, "leaves missing from a loaded snapshot read as zeros");
+
+        snapshot::reset();
+        VM::cpu::cpuid(a, b, c, d, 0);
+        check(a == live[0].regs[0] && b == live[0].regs[1], "reset() goes back to the real CPU");
+    }
+#endif
+
+#if defined(__linux__)
+    std::cout << "\n=== SMBIOS structure table ===\n";
+    {
+        const std::vector<std::uint8_t> table = make_table(true);
+        VM::util::smbios parsed;
+        const bool found = VM::util::smbios::parse(table.data(), table.size(), parsed);
+
+        check(found, "parse() finds the records");
+        check(parsed.bios.vendor == "SeaBIOS" && parsed.bios.version == "1.16.3", "type 0 strings");
+        check(parsed.bios.has_vm_bit && parsed.bios.vm_bit, "type 0 VM bit");
+        check(parsed.system.manufacturer == "QEMU" && parsed.system.product == "Standard PC (Q35 + ICH9, 2009)", "type 1 manufacturer and product");
+        check(parsed.system.sku == "sku-1" && parsed.system.family == "Virtual Machine", "type 1 SKU and family");
+        check(parsed.board.manufacturer == "Oracle Corporation" && parsed.board.product == "VirtualBox", "type 2 strings after a structure without strings");
+        check(parsed.chassis.has_type && parsed.chassis.type == 1, "type 3 chassis type without the lock bit");
+        check(parsed.chassis.manufacturer == "QEMU" && parsed.chassis.asset_tag == "No Asset Tag", "type 3 strings");
+
+        VM::util::smbios cleared;
+        const std::vector<std::uint8_t> no_bit = make_table(false);
+        VM::util::smbios::parse(no_bit.data(), no_bit.size(), cleared);
+        check(cleared.bios.has_vm_bit && !cleared.bios.vm_bit, "type 0 VM bit cleared");
+
+        VM::util::smbios truncated;
+        const bool truncated_found = VM::util::smbios::parse(table.data(), 45, truncated);
+        check(truncated_found && truncated.bios.vendor == "SeaBIOS" && truncated.system.manufacturer.empty(), "truncated table stops at the last whole structure");
+
+        VM::util::smbios empty;
+        check(!VM::util::smbios::parse(table.data(), 3, empty), "table shorter than a header has no records");
+
+        std::string entry_point3(0x18, '\0');
+        entry_point3.replace(0, 5, "_SM3_");
+        entry_point3[0x0C] = 0x34;
+        entry_point3[0x0D] = 0x12;
+        check(VM::util::smbios::table_length(entry_point3) == 0x1234, "SMBIOS 3 entry point table size");
+
+        std::string entry_point2(0x1F, '\0');
+        entry_point2.replace(0, 4, "_SM_");
+        entry_point2[0x16] = 0x00;
+        entry_point2[0x17] = 0x02;
+        check(VM::util::smbios::table_length(entry_point2) == 0x200, "SMBIOS 2 entry point table length");
+        check(VM::util::smbios::table_length("garbage") == 0, "unknown entry point");
+    }
+
+    std::cout << "\n=== Kernel log matcher ===\n";
+    {
+        const std::string dmesg =
+            "Linux version 6.8.0 (builder@host)\n"
+            "Hypervisor detected: KVM\n"
+            "kvm-clock: Using msrs 4b564d01 and 4b564d00\n"
+            "fw_cfg: QEMU configuration device found\n";
+
+        VM::util::kernel_log log;
+        log.scan_lines(dmesg.data(), dmesg.size());
+
+        check(log.hypervisor_detected, "\"Hypervisor detected\" is found");
+        check(log.kvm, "a hypervisor line naming KVM is found");
+        check(!log.qemu, "QEMU outside a hypervisor line doesn't count");
+
+        VM::util::kernel_log other;
+        const std::string lines = "xen: hypervisor reports QEMU-compatible timer\nhypervisor detected: none";
+        other.scan_lines(lines.data(), lines.size());
+
+        check(other.qemu && !other.kvm, "patterns are matched in any case");
+        check(!other.hypervisor_detected, "\"Hypervisor detected\" is case sensitive");
+
+        VM::util::kernel_log split;
+        const std::string halves = "hyper\nvisor kvm";
+        split.scan_lines(halves.data(), halves.size());
+        check(!split.kvm, "patterns don't match across lines");
+    }
+
+    std::cout << "\n=== systemd-detect-virt equivalent ===\n";
+    {
+        using sources = VM::util::virt_id::sources;
+        const auto id_is = [](const sources& s, const char* expected) {
+            return std::string(VM::util::virt_id::classify(s)) == expected;
+        };
+
+        /*
+         * Recorded: docker on a KVM host, where PID 1's environment isn't readable. These are
+         * the inputs that host had, and systemd 252 answered "docker" (and "kvm" with --vm)
+         */
+        sources docker_on_kvm;
+        docker_on_kvm.dockerenv = true;
+        docker_on_kvm.hypervisor_bit = true;
+        docker_on_kvm.cpuid_vendor = "KVMKVMKVM";
+        check(id_is(docker_on_kvm, "docker"), "docker with /.dockerenv");
+        check(std::string(VM::util::virt_id::vm_id(docker_on_kvm)) == "kvm", "KVM underneath it");
+
+        /*
+         * Not recorded: the rest are built by hand from the order of the checks in systemd's
+         * src/basic/virt.c (containers before VMs, DMI before CPUID, and so on). They pin that
+         * order down, they don't show that real systems of each kind come out the same
+         */
+
+        sources podman;
+        podman.container = "podman";
+        podman.container_known = true;
+        check(id_is(podman, "podman"), "podman from container=podman");
+
+        sources oci;
+        oci.container = "oci";
+        oci.container_known = true;
+        check(id_is(oci, "container-other"), "container=oci without well-known files");
+        oci.containerenv = true;
+        check(id_is(oci, "podman"), "container=oci with /run/.containerenv");
+
+        sources nspawn;
+        nspawn.container = "systemd-nspawn";
+        nspawn.container_known = true;
+        nspawn.hypervisor_bit = true;
+        nspawn.cpuid_vendor = "KVMKVMKVM";
+        check(id_is(nspawn, "systemd-nspawn"), "containers are reported before the VM");
+
+        sources wsl;
+        wsl.osrelease = "5.15.153.1-microsoft-standard-WSL2";
+        wsl.hypervisor_bit = true;
+        wsl.cpuid_vendor = "Microsoft Hv";
+        check(id_is(wsl, "wsl"), "WSL from osrelease");
+
+        sources openvz;
+        openvz.proc_vz = true;
+        check(id_is(openvz, "openvz"), "openvz with /proc/vz but no /proc/bc");
+        openvz.proc_bc = true;
+        check(id_is(openvz, "none"), "openvz host with /proc/bc is not a container");
+
+        sources vbox;
+        vbox.dmi[1] = "innotek GmbH";
+        vbox.hypervisor_bit = true;
+        vbox.cpuid_vendor = "KVMKVMKVM";
+        check(id_is(vbox, "oracle"), "VirtualBox DMI wins over its KVM paravirt interface");
+
+        sources azure;
+        azure.dmi[1] = "Microsoft Corporation";
+        azure.hypervisor_bit = true;
+        azure.cpuid_vendor = "Microsoft Hv";
+        check(id_is(azure, "microsoft"), "Hyper-V from CPUID");
+
+        sources qemu_tcg;
+        qemu_tcg.dmi[1] = "QEMU";
+        check(id_is(qemu_tcg, "qemu"), "QEMU from DMI without the hypervisor bit");
+
+        sources vmware;
+        vmware.dmi[0] = "VMware Virtual Platform";
+        vmware.hypervisor_bit = true;
+        vmware.cpuid_vendor = "VMwareVMware";
+        check(id_is(vmware, "vmware"), "VMware");
+
+        sources unknown;
+        unknown.hypervisor_bit = true;
+        unknown.cpuid_vendor = "SomeVisorXYZ";
+        check(id_is(unknown, "vm-other"), "unknown hypervisor");
+
+        sources zvm;
+        zvm.sysinfo = "VM00 Control Program: z/VM    7.2.0\n";
+        check(id_is(zvm, "zvm"), "z/VM from /proc/sysinfo");
+
+        check(id_is(sources(), "none"), "bare metal");
+    }
+
+    std::cout << "\n=== /proc scanner ===\n";
+    {
+        const VM::util::process_entry agent("qemu_ga", VM::brand_enum::QEMU);
+        check(agent.hash == VM::util::process_hash("qemu_ga", 7), "runtime hash matches the compile-time one");
+
+        /* This very test is a running process, under the basename of argv[0] */
+        std::string self(argv[0]);
+        self = self.substr(self.find_last_of('/') + 1);
+
+        const VM::util::process_entry entries[] = {
+            { "no-such-process-name", VM::brand_enum::QEMU },
+            { self.c_str(), VM::brand_enum::QEMU },
+            { "another-missing-one", VM::brand_enum::QEMU }
+        };
+        check(VM::util::find_processes(entries, 3) == 0x2, "only the running process is found, in one pass");
+        check(VM::util::is_proc_running(self.c_str()), "is_proc_running() finds this process");
+        check(!VM::util::is_proc_running("no-such-process-name"), "is_proc_running() doesn't find a missing one");
+    }
+
+    std::cout << "\n=== Per-boot disk cache ===\n";
+    {
+        using disk = VM::memo::disk_cache;
+
+        char dir[] = "/tmp/vmaware-cache-XXXXXX";
+        check(mkdtemp(dir) != nullptr, "temporary cache directory");
+
+        const bool hypervisor_bit = VM::check(VM::HYPERVISOR_BIT);
+        VM::check(VM::CGROUP);
+        check(disk::save(dir), "results are saved");
+
+        char path[PATH_MAX];
+        disk::file_path(dir, path);
+        struct stat info;
+        check(stat(path, &info) == 0 && (info.st_mode & 0777) == 0600 && info.st_size == sizeof(disk::file_image), "one private file of the expected size");
+
+        disk::file_header header;
+        disk::file_image image;
+        check(disk::make_header(header) && disk::read_image(path, header, image), "the file is read back for this boot");
+        check(image.records[VM::HYPERVISOR_BIT].cached && (image.records[VM::HYPERVISOR_BIT].result != 0) == hypervisor_bit, "a per-boot result is kept");
+        check(!image.records[VM::CGROUP].cached, "a per-process result is left out");
+        check(disk::load(dir) == 0, "slots that hold a result already aren't overwritten");
+
+        chmod(path, 0666);
+        check(!disk::read_image(path, header, image), "a file others can write is ignored");
+        chmod(path, 0600);
+
+        disk::file_header other_boot = header;
+        other_boot.boot_id[0] = (header.boot_id[0] == '0') ? '1' : '0';
+        check(!disk::read_image(path, other_boot, image), "a file from another boot is ignored");
+
+        unlink(path);
+        rmdir(dir);
+    }
+#endif
+
+    std::cout << "\n-----------\n";
+    std::cout << "PASSED: " << pass_count << "\n";
+    if (fail_count > 0) {
+        std::cerr << "FAILED: " << fail_count << "\n";
+    }
+    else {
+        std::cout << "FAILED: " << fail_count << "\n";
+    }
+
+    return (fail_count > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+#include "../src/vmaware.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+
+/*
+ * Per-file cost of the sysfs/procfs readers the Linux techniques go through.
+ * "legacy" is the previous util::read_file(): an exists() check, then an
+ * std::ifstream read line by line into a growing std::string.
+ *
+ * The second table is the cost of every file probe of one run, once with the
+ * plain syscalls and once batched through io_uring beforehand, which is only
+ * there when built with -DVMAWARE_IO_URING.
+ *
+ * build: g++ -std=c++17 -O2 -pthread auxiliary/io_benchmark.cpp -o io_benchmark
+ *        g++ -std=c++17 -O2 -pthread -DVMAWARE_IO_URING auxiliary/io_benchmark.cpp -o io_benchmark
+ * usage: ./io_benchmark [iterations]
+ */
+
+static std::string legacy_read_file(const char* path) {
+    struct stat buffer;
+    if (stat(path, &buffer) != 0) {
+        return "";
+    }
+
+    std::ifstream file(path);
+    std::string data;
+    std::string line;
+
+    while (std::getline(file, line)) {
+        data += line + "\n";
+    }
+
+    return data;
+}
+
+template <typename F>
+static double ns_per_call(const int iterations, F&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char* argv[]) {
+    const int iterations = (argc > 1) ? std::atoi(argv[1]) : 2000;
+
+    const char* files[] = {
+        "/sys/devices/virtual/dmi/id/sys_vendor",
+        "/sys/devices/virtual/dmi/id/chassis_type",
+        "/sys/devices/system/cpu/smt/control",
+        "/sys/hypervisor/type",
+        "/proc/self/status",
+        "/proc/self/cgroup",
+        "/proc/modules",
+        "/proc/cpuinfo",
+        "/this/file/does/not/exist"
+    };
+
+    std::printf("%-42s %12s %12s %12s\n", "file", "legacy ns", "read_file", "read_into");
+
+    volatile std::size_t sink = 0;
+    double legacy_total = 0, file_total = 0, into_total = 0;
+
+    for (const char* path : files) {
+        const double legacy = ns_per_call(iterations, [&] { sink = sink + legacy_read_file(path).size(); });
+        const double fast = ns_per_call(iterations, [&] { sink = sink + VM::util::read_file(path).size(); });
+        const double into = ns_per_call(iterations, [&] {
+            char buffer[4096];
+            sink = sink + static_cast<std::size_t>(VM::util::read_into(path, buffer, sizeof(buffer)) + 1);
+        });
+
+        legacy_total += legacy;
+        file_total += fast;
+        into_total += into;
+
+        std::printf("%-42s %12.0f %12.0f %12.0f\n", path, legacy, fast, into);
+    }
+
+    std::printf("%-42s %12.0f %12.0f %12.0f\n", "total", legacy_total, file_total, into_total);
+
+    static const VM::util::file_probe probes[] = {
+        { VM::DMI_SCAN, "/sys/devices/virtual/dmi/id/sys_vendor", true },
+        { VM::DMI_SCAN, "/sys/devices/virtual/dmi/id/board_vendor", true },
+        { VM::DMI_SCAN, "/sys/devices/virtual/dmi/id/bios_vendor", true },
+        { VM::CVENDOR, "/sys/devices/virtual/dmi/id/chassis_vendor", true },
+        { VM::CTYPE, "/sys/devices/virtual/dmi/id/chassis_type", true },
+        { VM::THREAD_MISMATCH, "/sys/devices/system/cpu/smt/control", true },
+        { VM::HYPERVISOR_DIR, "/sys/hypervisor/type", true },
+        { VM::CONTAINER_PID, "/proc/self/status", true },
+        { VM::CGROUP, "/proc/self/cgroup", true },
+        { VM::VBOX_MODULE, "/proc/modules", true },
+        { VM::UML_CPU, "/proc/cpuinfo", true },
+        { VM::DOCKERENV, "/.dockerenv", false },
+        { VM::PODMAN_FILE, "/run/.containerenv", false },
+        { VM::SYSTEMD, "/usr/bin/systemd-detect-virt", false },
+        { VM::DMESG, "/usr/bin/dmesg", false },
+        { VM::HWMON, "/sys/class/hwmon/", false },
+        { VM::PROCESSES, "/proc/xen", false },
+        { VM::QEMU_FW_CFG, "/sys/module/qemu_fw_cfg/", false }
+    };
+
+    const auto probe_all = [&] {
+        for (const auto& probe : probes) {
+            if (probe.read) {
+                sink = sink + VM::util::read_file(probe.path).size();
+            }
+            else {
+                sink = sink + VM::util::exists(probe.path);
+            }
+        }
+    };
+
+    const int run_iterations = (iterations / 10) + 1;
+
+    const double plain = ns_per_call(run_iterations, [&] {
+        const auto outer = VM::memo::file_cache::begin_run();
+        probe_all();
+        VM::memo::file_cache::end_run(outer);
+    });
+
+    std::printf("\n%-42s %12s\n", "one run, all probes", "ns");
+    std::printf("%-42s %12.0f\n", "syscalls", plain);
+
+#if (VMAWARE_IO_URING_SUPPORTED)
+    const VM::util::file_probe* batch[sizeof(probes) / sizeof(probes[0])];
+    for (std::size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); ++i) {
+        batch[i] = &probes[i];
+    }
+
+    bool batched = true;
+    const double uring = ns_per_call(run_iterations, [&] {
+        const auto outer = VM::memo::file_cache::begin_run();
+        batched = VM::util::uring_probe(batch, sizeof(probes) / sizeof(probes[0])) && batched;
+        probe_all();
+        VM::memo::file_cache::end_run(outer);
+    });
+
+    if (batched) {
+        std::printf("%-42s %12.0f\n", "io_uring", uring);
+    }
+    else {
+        std::printf("%-42s %12s\n", "io_uring", "unavailable");
+    }
+#else
+    std::printf("%-42s %12s\n", "io_uring", "not built");
+#endif
+
+    return 0;
+}
@@ -1,8 +1,14 @@
 #include "../src/vmaware.hpp"
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 static int pass_count = 0;
 static int fail_count = 0;
@@ -160,6 +166,356 @@ int main() {
         check(conc1 == conc3, "VM::conclusion() 3rd call matches 1st");
     }
 
+    // Phase 3: Several flag combinations in turn
+    //
+    // The result caches keep more than one flagset, so once each combination
+    // has been seen, going back and forth between them must never miss again.
+
+    std::cout << "\n=== Result cache: alternating flag combinations ===\n";
+    {
+        const VM::flagset flag_sets[] = {
+            VM::core::generate_default(),
+            VM::core::arg_handler(VM::MULTIPLE),
+            VM::core::arg_handler(VM::HIGH_THRESHOLD),
+            VM::core::arg_handler(VM::DYNAMIC)
+        };
+
+        for (const auto& flags : flag_sets) {
+            VM::type(flags);
+            VM::brand(flags);
+            VM::conclusion(flags);
+        }
+
+        const auto list_before = VM::memo::brand_list::stats();
+        const auto single_before = VM::memo::single_brand::stats();
+        const auto multi_before = VM::memo::multi_brand::stats();
+        const auto conclusion_before = VM::memo::conclusion::stats();
+
+        std::string first_round[4];
+        bool stable = true;
+
+        for (int round = 0; round < 3; ++round) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                VM::type(flag_sets[i]);
+                const std::string text = VM::brand(flag_sets[i]) + VM::conclusion(flag_sets[i]);
+
+                if (round == 0) {
+                    first_round[i] = text;
+                }
+                else if (first_round[i] != text) {
+                    stable = false;
+                }
+            }
+        }
+
+        const auto list_after = VM::memo::brand_list::stats();
+        const auto single_after = VM::memo::single_brand::stats();
+        const auto multi_after = VM::memo::multi_brand::stats();
+        const auto conclusion_after = VM::memo::conclusion::stats();
+
+        check(list_after.misses == list_before.misses, "brand_list cache never misses once warm");
+        check(list_after.hits == list_before.hits + 12, "brand_list cache hits on every alternating call");
+        check(single_after.misses == single_before.misses, "single_brand cache never misses once warm");
+        check(multi_after.misses == multi_before.misses, "multi_brand cache never misses once warm");
+        check(conclusion_after.misses == conclusion_before.misses, "conclusion cache never misses once warm");
+        check(stable, "alternating flag combinations return the same results every round");
+    }
+
+    {
+        // Settings flags are taken as such with a deadline too, not as a technique bitmask
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::hours(1);
+        const VM::budgeted_result high = VM::detect_within(deadline, VM::HIGH_THRESHOLD);
+        check(high.is_vm == VM::detect(VM::HIGH_THRESHOLD) && high.skipped.none(), "detect_within() with a deadline takes settings flags like detect()");
+    }
+
+    // Phase 4: Techniques picked at compile time
+    //
+    // VM::detect<...>() goes through the same technique cache as everything
+    // else, so its verdict must match the cached points of the same techniques.
+
+    std::cout << "\n=== VM::detect<...>() matches the technique cache ===\n";
+    {
+        const bool fixed = VM::detect<VM::HYPERVISOR_BIT, VM::HYPERVISOR_STR, VM::THREAD_MISMATCH>();
+        const bool fixed_high = VM::detect<VM::HYPERVISOR_BIT, VM::HIGH_THRESHOLD>();
+
+        unsigned points = 0;
+        for (const VM::enum_flags flag : { VM::HYPERVISOR_BIT, VM::HYPERVISOR_STR, VM::THREAD_MISMATCH }) {
+            if (VM::check(flag)) {
+                points += VM::memo::cache_fetch(flag).points;
+            }
+        }
+
+        check(fixed == (points >= VM::threshold_score), "VM::detect<...>() verdict agrees with the cached points");
+        check(!fixed_high || VM::memo::cache_fetch(VM::HYPERVISOR_BIT).points >= VM::high_threshold_score,
+            "VM::HIGH_THRESHOLD raises the bar of VM::detect<...>()");
+        check(fixed == VM::detect<VM::HYPERVISOR_BIT, VM::HYPERVISOR_STR, VM::THREAD_MISMATCH>(),
+            "VM::detect<...>() 2nd call matches 1st");
+    }
+
+    // Phase 5: Dropping cached results
+    //
+    // VM::invalidate() drops the named results (and the brand and conclusion
+    // caches built from them), VM::refresh() only drops time-varying ones.
+
+    std::cout << "\n=== VM::invalidate() and VM::refresh() ===\n";
+    {
+        const bool before = VM::check(VM::HYPERVISOR_BIT);
+        const std::string brand_before = VM::brand();
+        const auto list_before = VM::memo::brand_list::stats();
+
+        check(VM::invalidate(VM::HYPERVISOR_BIT) == 1 && !VM::memo::is_cached(VM::HYPERVISOR_BIT), "invalidate() drops the named result");
+        check(VM::invalidate(VM::HYPERVISOR_BIT) == 0, "invalidate() of a result that isn't cached drops nothing");
+        check(VM::check(VM::HYPERVISOR_BIT) == before && VM::memo::is_cached(VM::HYPERVISOR_BIT), "the technique runs again on the next call");
+        check(VM::brand() == brand_before && VM::memo::brand_list::stats().misses == list_before.misses + 1, "brand results are rebuilt after an invalidation");
+
+        VM::refresh();
+        check(VM::memo::is_cached(VM::HYPERVISOR_BIT), "refresh() keeps per-boot results");
+
+        bool threw = false;
+        try {
+            VM::invalidate(VM::MULTIPLE);
+        }
+        catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        check(threw, "invalidate() refuses settings flags");
+
+#if defined(__linux__)
+        VM::check(VM::CGROUP);
+        check(VM::refresh(std::chrono::hours(1)) == 0 && VM::memo::is_cached(VM::CGROUP), "refresh() keeps time-varying results younger than max_age");
+        check(VM::refresh() >= 1 && !VM::memo::is_cached(VM::CGROUP), "refresh() drops time-varying results");
+#endif
+        check(VM::invalidate() > 0 && !VM::memo::is_cached(VM::HYPERVISOR_BIT), "invalidate() with no flags drops everything");
+        check(VM::check(VM::HYPERVISOR_BIT) == before, "results come back the same after dropping everything");
+
+        VM::invalidate(VM::HYPERVISOR_BIT);
+        const VM::core::technique throwing(10, []() -> bool { throw std::runtime_error("technique"); });
+        bool escaped = false;
+        try {
+            VM::core::run_cached(VM::HYPERVISOR_BIT, throwing);
+        }
+        catch (const std::runtime_error&) {
+            escaped = true;
+        }
+        check(escaped && !VM::memo::is_cached(VM::HYPERVISOR_BIT) && VM::check(VM::HYPERVISOR_BIT) == before, "a technique that throws leaves its slot to the next call");
+    }
+
+    // Phase 6: Streaming a run
+    //
+    // VM::run_stream() hands every technique's record to the callback as it
+    // finishes, and stops the run as soon as the callback returns false.
+
+    std::cout << "\n=== VM::run_stream() ===\n";
+    {
+        VM::invalidate();
+
+        std::vector<VM::technique_profile> streamed;
+        const std::uint16_t points = VM::run_stream([&](const VM::technique_profile& entry) {
+            streamed.push_back(entry);
+            return true;
+        });
+
+        bool consistent = true;
+        std::uint32_t total = 0;
+        for (const auto& entry : streamed) {
+            consistent = consistent && !entry.from_cache && (VM::check(entry.id) == entry.result);
+            total += entry.result ? entry.points : 0;
+        }
+
+        check(!streamed.empty() && streamed.size() == VM::profile().size(), "every visited technique is streamed once");
+        check(consistent && total == points, "streamed records match the cache and add up to the returned points");
+
+        VM::invalidate();
+
+        std::size_t delivered = 0;
+        VM::technique_profile last{};
+        VM::run_stream([&](const VM::technique_profile& entry) {
+            last = entry;
+            return ++delivered < 2;
+        });
+
+        std::size_t cached = 0;
+        for (std::uint8_t i = VM::technique_begin; i < VM::technique_end; ++i) {
+            cached += VM::memo::is_cached(static_cast<VM::enum_flags>(i)) ? 1 : 0;
+        }
+        check(delivered == 2 && cached == 2 && VM::memo::is_cached(last.id), "returning false stops the run after that technique");
+
+        bool rethrown = false;
+        try {
+            VM::run_stream([](const VM::technique_profile&) -> bool { throw std::runtime_error("stop"); });
+        }
+        catch (const std::runtime_error&) {
+            rethrown = true;
+        }
+        check(rethrown && VM::core::stream == nullptr, "an exception from the callback is rethrown once the run ends, with the callback unhooked");
+
+        VM::invalidate();
+
+        std::size_t calls = 0;
+        int depth = 0;
+        int deepest = 0;
+        VM::run_stream([&](const VM::technique_profile&) {
+            ++calls;
+            deepest = (std::max)(deepest, ++depth);
+            VM::detect();
+            --depth;
+            return true;
+        });
+        check(deepest == 1 && calls == streamed.size() && VM::profile().size() == streamed.size(), "a run made from the callback isn't streamed and leaves the profile alone");
+
+        std::vector<VM::enum_flags> picked;
+        const auto collect = [&](const VM::technique_profile& entry) {
+            picked.push_back(entry.id);
+            return true;
+        };
+        VM::run_stream(VM::HYPERVISOR_BIT, collect);
+        const bool single = (picked.size() == 1 && picked.front() == VM::HYPERVISOR_BIT);
+        picked.clear();
+        VM::run_stream(VM::HYPERVISOR_BIT, VM::CPU_BRAND, collect);
+        check(single && picked.size() == 2, "flags given one by one before the callback pick the techniques");
+    }
+
+#if defined(__linux__)
+    // Phase 7: File contents shared within a run
+
+    std::cout << "\n=== File cache: one read per path and run ===\n";
+    {
+        const auto before = VM::memo::file_cache::stats();
+
+        const auto outer = VM::memo::file_cache::begin_run();
+        const std::string first = VM::util::read_file("/proc/self/status");
+        const std::string second = VM::util::read_file("/proc/self/status");
+        char buffer[64];
+        const auto length = VM::util::read_into("/proc/self/status", buffer, sizeof(buffer));
+        const bool missing = VM::util::exists("/this/path/does/not/exist");
+        const bool missing_again = VM::util::exists("/this/path/does/not/exist");
+        const auto during = VM::memo::file_cache::stats();
+        VM::memo::file_cache::end_run(outer);
+
+        const auto after = VM::memo::file_cache::stats();
+        const std::string outside = VM::util::read_file("/proc/self/status");
+
+        check(!first.empty() && first == second, "second read of a file in the same run returns the same content");
+        check(length == 63 && first.compare(0, 63, buffer) == 0, "read_into() is served from the same cached content");
+        check(!missing && !missing_again, "exists() result is cached for missing paths too");
+        check(during.hits == before.hits + 3, "every repeated lookup in a run is a cache hit");
+        check(during.syscalls_saved > before.syscalls_saved, "cache hits report saved syscalls");
+        check(VM::memo::file_cache::count == 0, "file cache is emptied when the run ends");
+        check(after.hits == during.hits && !outside.empty(), "reads outside a run bypass the file cache");
+    }
+
+    {
+        // Another run that stays up the whole time keeps the table from being emptied
+        std::thread([]() { VM::memo::file_cache::begin_run(); }).join();
+
+        const auto earlier = VM::memo::file_cache::begin_run();
+        char buffer[4096];
+        VM::util::read_into("/proc/self/status", buffer, sizeof(buffer));
+        VM::memo::file_cache::end_run(earlier);
+
+        const auto before = VM::memo::file_cache::stats();
+        const auto outer = VM::memo::file_cache::begin_run();
+        VM::util::read_into("/proc/self/status", buffer, sizeof(buffer));
+        VM::util::read_into("/proc/self/status", buffer, sizeof(buffer));
+        VM::memo::file_cache::end_run(outer);
+        const auto after = VM::memo::file_cache::stats();
+
+        check(after.misses == before.misses + 1 && after.hits == before.hits + 1, "a run doesn't take files read by an earlier run, even while other runs keep the cache alive");
+
+        // A run nested in another one on the same thread, like a VM::detect() from a run_stream() callback
+        const auto stale = VM::memo::file_cache::begin_run();
+        VM::util::read_into("/proc/self/stat", buffer, sizeof(buffer));
+        VM::memo::file_cache::end_run(stale);
+
+        const auto nesting_before = VM::memo::file_cache::stats();
+        const auto nesting = VM::memo::file_cache::begin_run();
+        const auto nested = VM::memo::file_cache::begin_run();
+        VM::memo::file_cache::end_run(nested);
+        VM::util::read_into("/proc/self/stat", buffer, sizeof(buffer));
+        VM::memo::file_cache::end_run(nesting);
+        const auto nesting_after = VM::memo::file_cache::stats();
+
+        std::thread([]() { VM::memo::file_cache::end_run(0); }).join();
+
+        check(nesting == 0 && nested != 0 && VM::memo::file_cache::run_generation == 0, "a nested run hands the outer run its generation back");
+        check(nesting_after.hits == nesting_before.hits, "the outer run still doesn't take older files once a nested run ends");
+    }
+
+#endif
+
+    // Phase 8: Concurrent VM::PARALLEL runs
+    //
+    // A pool that stops on the SHORTCUT or pruning threshold gives its unstarted
+    // techniques back right away, since another caller may be waiting on them.
+
+    std::cout << "\n=== Concurrent VM::PARALLEL runs ===\n";
+    {
+        const VM::enum_flags first = VM::parallel_techniques.at(0);
+        const VM::enum_flags second = VM::parallel_techniques.at(1);
+        VM::invalidate(first, second);
+
+        VM::core::parallel_run pool;
+        for (const VM::enum_flags id : { first, second }) {
+            if (VM::memo::try_claim(id)) {
+                pool.add(id);
+            }
+        }
+        pool.stop.store(true);
+        const bool started = pool.start();
+
+        // The pool isn't joined yet, so only the workers can give the slots back
+        bool given_back = false;
+        const auto wait_until = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!given_back && std::chrono::steady_clock::now() < wait_until) {
+            given_back = VM::memo::try_claim(first);
+            if (!given_back) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        if (given_back) {
+            VM::memo::release(first);
+        }
+        pool.join();
+
+        check(pool.count == 2 && started && given_back, "a stopped pool gives its unstarted techniques back before it's joined");
+    }
+    {
+        // VM::detect() stops on the pruning bound, VM::percentage() on the SHORTCUT threshold
+        std::atomic<int> finished{ 0 };
+        const auto run = [&finished](const bool prune) {
+            for (int i = 0; i < 50; ++i) {
+                if (prune) {
+                    VM::detect(VM::PARALLEL);
+                }
+                else {
+                    VM::percentage(VM::PARALLEL);
+                }
+                VM::invalidate();
+            }
+            ++finished;
+        };
+
+        std::thread prune_caller(run, true);
+        std::thread shortcut_caller(run, false);
+        std::thread other_prune_caller(run, true);
+
+        const auto wait_until = std::chrono::steady_clock::now() + std::chrono::seconds(300);
+        while (finished.load() < 3 && std::chrono::steady_clock::now() < wait_until) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        if (finished.load() < 3) {
+            check(false, "concurrent PARALLEL runs with SHORTCUT and pruning all return");
+            std::cout << "PASSED: " << pass_count << "\nFAILED: " << fail_count << "\n";
+            std::_Exit(1); // the callers are stuck, joining them would hang
+        }
+
+        prune_caller.join();
+        shortcut_caller.join();
+        other_prune_caller.join();
+        check(true, "concurrent PARALLEL runs with SHORTCUT and pruning all return");
+    }
+
     std::cout << "\n-----------\n";
     std::cout << "PASSED: " << pass_count << "\n";
     if (fail_count > 0) {
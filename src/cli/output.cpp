@@ -4,6 +4,8 @@
 #include "globals.hpp"
 #include "sha256.hpp" 
 
+#include <array>
+#include <bitset>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
@@ -227,6 +229,50 @@ const char* get_vm_description(const std::string& vm_brand) {
     return "";
 }
 
+/*
+ * Outcome of every technique that checker() reports, gathered by a single
+ * VM::run_stream() pass instead of one VM::check() call per technique
+ */
+static std::array<VM::technique_profile, VM::technique_end> streamed{};
+static std::bitset<VM::technique_end> streamed_set;
+
+static void run_techniques() {
+    VM::flagset flags;
+
+    for (u8 i = VM::technique_begin; i < static_cast<u8>(VM::technique_end); ++i) {
+        const VM::enum_flags flag = static_cast<VM::enum_flags>(i);
+
+        if (is_disabled(flag) || (is_unsupported(flag) && !arg_bitset.test(ALL))) {
+            continue;
+        }
+
+        flags.set(flag);
+    }
+
+    bool progress = false;
+
+    #if (CLI_LINUX)
+        progress = !arg_bitset.test(NO_ANSI) && isatty(STDERR_FILENO);
+    #endif
+
+    u32 done = 0;
+
+    VM::run_stream(flags, [&](const VM::technique_profile& entry) {
+        streamed[entry.id] = entry;
+        streamed_set.set(entry.id);
+
+        if (progress) {
+            std::cerr << "\r\x1B[K" << grey << "Checking techniques... " << ++done << " done (" << VM::flag_to_string(entry.id) << ")" << ansi_exit << std::flush;
+        }
+
+        return true;
+    });
+
+    if (progress) {
+        std::cerr << "\r\x1B[K" << std::flush;
+    }
+}
+
 static void checker(const VM::enum_flags flag, const char* message) {
     std::string enum_name;
 
@@ -258,13 +304,21 @@ static void checker(const VM::enum_flags flag, const char* message) {
 
     supported_count++;
 
-    auto start_time = std::chrono::high_resolution_clock::now();
+    bool result = false;
+    double ms = 0;
+
+    if (streamed_set.test(flag)) {
+        result = streamed[flag].result;
+        ms = static_cast<double>(streamed[flag].ns) / 1000000.0;
+    } else {
+        auto start_time = std::chrono::high_resolution_clock::now();
 
-    const bool result = VM::check(flag);
+        result = VM::check(flag);
 
-    auto end_time = std::chrono::high_resolution_clock::now();
+        auto end_time = std::chrono::high_resolution_clock::now();
 
-    const double ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    }
 
     if (arg_bitset.test(DETECTED_ONLY) && !result) {
         return;
@@ -529,6 +583,8 @@ void general(bool high_threshold, bool all, bool dynamic, const char* output_fil
 
     const auto t1 = std::chrono::high_resolution_clock::now();
 
+    run_techniques();
+
     checker(VM::VMID, "VMID");
     checker(VM::CPU_BRAND, "CPU brand");
     checker(VM::HYPERVISOR_BIT, "CPUID hypervisor bit");
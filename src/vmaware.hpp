@@ -311,6 +311,27 @@
     #define VMAWARE_SOURCE_LOCATION_SUPPORTED 0
 #endif
 
+/* Opt-in: define VMAWARE_IO_URING before including the header to batch the Linux file probes of a run through io_uring */
+#if (LINUX && defined(VMAWARE_IO_URING) && defined(__has_include))
+    #if __has_include(<linux/io_uring.h>)
+        #define VMAWARE_IO_URING_SUPPORTED 1
+    #endif
+#endif
+
+#ifndef VMAWARE_IO_URING_SUPPORTED
+    #define VMAWARE_IO_URING_SUPPORTED 0
+#endif
+
+/* Opt-in: define VMAWARE_PERSISTENT_CACHE before including the header to share technique results between the Linux processes of a boot, see memo::disk_cache */
+#if (LINUX && defined(VMAWARE_PERSISTENT_CACHE))
+    #define VMAWARE_PERSISTENT_CACHE_SUPPORTED 1
+    #ifndef VMAWARE_PERSISTENT_CACHE_DIR
+        #define VMAWARE_PERSISTENT_CACHE_DIR "/run/vmaware"
+    #endif
+#else
+    #define VMAWARE_PERSISTENT_CACHE_SUPPORTED 0
+#endif
+
 #if (VMAWARE_CPP >= 14)
     #define VMAWARE_DEPRECATED(msg) [[deprecated(msg)]]
 #elif (MSVC)
@@ -463,6 +484,7 @@
 #include <system_error>
 #include <ranges>
 #include <cstdio>
+#include <cstdlib>
 #include <functional>
 #include <cstring>
 #include <string>
@@ -480,9 +502,15 @@
 #include <bitset>
 #include <type_traits>
 #include <stdexcept>
+#include <exception>
 #include <numeric>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <random>
+#include <chrono>
+#include <memory>
+#include <new>
 
 #if (WINDOWS)
     #include <windows.h>
@@ -519,6 +547,7 @@
     #include <sys/ioctl.h>
     #include <sys/syscall.h>
     #include <sys/sysinfo.h>
+    #include <sys/klog.h>
     #include <net/if.h> 
     #include <netinet/in.h>
     #include <unistd.h>
@@ -532,6 +561,10 @@
     #include <pthread.h>     
     #include <sched.h>      
     #include <cerrno>   
+    #include <sys/mman.h>
+    #if (VMAWARE_IO_URING_SUPPORTED)
+        #include <linux/io_uring.h>
+    #endif
 #elif (APPLE)
     #if (x86)
         #include <cpuid.h>
@@ -842,7 +875,8 @@ public:
         HIGH_THRESHOLD,
         EXPERIMENTAL,
         DYNAMIC,
-        MULTIPLE
+        MULTIPLE,
+        PARALLEL
     };
 
     enum class brand_enum : u8 {
@@ -920,13 +954,14 @@ public:
         NULL_BRAND /* do not modify the placement for this, as it's used to count the number of brands here */
     };
 
-    static constexpr u8 enum_size = MULTIPLE; /* get enum size through value of last element */
-    static constexpr u8 settings_count = static_cast<u8>(MULTIPLE - HIGH_THRESHOLD + 1); /* get number of settings technique flags */
+    static constexpr u8 enum_size = PARALLEL; /* get enum size through value of last element */
+    static constexpr u8 settings_count = static_cast<u8>(PARALLEL - HIGH_THRESHOLD + 1); /* get number of settings technique flags */
     static constexpr u8 INVALID = 255; /* explicit invalid technique macro */
     static constexpr u16 base_technique_count = HIGH_THRESHOLD; /* original technique count, constant on purpose (can also be used as a base count value if custom techniques are added) */
     static constexpr u16 threshold_score = 150; /* standard threshold score */
     static constexpr u16 high_threshold_score = 300; /* new threshold score from 150 to 300 if VM::HIGH_THRESHOLD flag is enabled */
     static constexpr bool SHORTCUT = true; /* macro for whether VM::core::run_all() should take a shortcut by skipping the rest of the techniques if the threshold score is already met */
+    static constexpr bool PRUNE = true; /* macro for whether VM::core::run_all() should also stop once the threshold score can no longer be met */
     static constexpr size_t MAX_CUSTOM_TECHNIQUES = 256; /* specific to VM::add_custom(), where custom techniques will be stored here */
     static constexpr size_t MAX_BRANDS = static_cast<size_t>(brand_enum::NULL_BRAND) + 1; /* VM scoreboard table specifically for VM::brand() */
 
@@ -956,6 +991,18 @@ public:
     static std::vector<enum_flags> disabled_techniques;
     static constexpr std::array<enum_flags, 1> experimental_techniques{ { FIRMWARE } };
 
+    /*
+     * Techniques that are safe to run on a worker thread with VM::PARALLEL. These are
+     * I/O-bound probes that only share state with the engine through core::add(), so
+     * anything touching the memo caches or the CPU module is deliberately left out
+     */
+    static constexpr std::array<enum_flags, 25> parallel_techniques{ {
+        FIRMWARE, DEVICES, SMBIOS_VM_BIT, KMSG, CVENDOR, QEMU_FW_CFG, SYSTEMD, CTYPE, DOCKERENV,
+        DMIDECODE, DMESG, HWMON, QEMU_VIRTUAL_DMI, QEMU_USB, HYPERVISOR_DIR, VBOX_MODULE,
+        SYSINFO_PROC, DMI_SCAN, PODMAN_FILE, WSL_PROC, FILE_ACCESS_HISTORY, MAC, CONTAINER_PID,
+        CGROUP, PROCESSES
+    } };
+
 #if (WINDOWS)
     using brand_score_t = i32;
 #else
@@ -970,6 +1017,52 @@ public:
     using brand_list_t = std::vector<brand_element_t>;
     using brand_array_t = std::array<brand_element_t, MAX_BRANDS>;
 
+    /* Ranked brand list with a fixed capacity, so it can be handed out without touching the heap */
+    struct brand_set {
+        brand_array_t entries {};
+        u8 count = 0;
+
+        const brand_element_t* begin() const noexcept { return entries.data(); }
+        const brand_element_t* end() const noexcept { return entries.data() + count; }
+        std::size_t size() const noexcept { return count; }
+        bool empty() const noexcept { return count == 0; }
+        const brand_element_t& front() const noexcept { return entries[0]; }
+        const brand_element_t& operator[](const std::size_t i) const noexcept { return entries[i]; }
+    };
+
+    /* Specific to VM::profile() */
+    struct technique_profile {
+        enum_flags id;
+        u64 ns;           /* wall time spent on the technique, including waiting on another thread running it */
+        bool from_cache;  /* whether the result came from memo::cache_table instead of running the technique */
+        bool result;
+        u8 points;
+        brand_enum brand;
+    };
+    using profile_list_t = std::vector<technique_profile>;
+
+    /* Specific to VM::evaluate_many() */
+    struct evaluation {
+        flagset flags;
+        u16 points;
+        bool is_vm;
+        u8 percentage;
+        u8 detected_count;
+        flagset detected;
+        brand_list_t brands;
+        std::string brand;
+        std::string type;
+        std::string conclusion;
+    };
+
+    /* Specific to VM::detect_within() */
+    struct budgeted_result {
+        u16 points;       /* points scored by the techniques that did run */
+        bool is_vm;       /* same as VM::detect(), as far as the budget allowed */
+        u8 confidence;    /* 0-100, how much of the possible score was actually evaluated (100 if the skipped techniques couldn't change the verdict) */
+        flagset skipped;  /* techniques that didn't fit in the budget, their cache entries are left empty */
+    };
+
     /* Constructor stuff */
     VM() = delete;
     VM(const VM&) = delete;
@@ -987,7 +1080,7 @@ public:
 
     static_assert(std::is_integral<brand_score_t>::value, "brand_score_t must map to an integral type.");
 
-    static_assert(enum_size == MULTIPLE, "enum_size must match the terminal element of the enum_flags.");
+    static_assert(enum_size == PARALLEL, "enum_size must match the terminal element of the enum_flags.");
     static_assert(MAX_BRANDS == static_cast<size_t>(brand_enum::NULL_BRAND) + 1, "MAX_BRANDS must account for all elements including NULL_BRAND.");
     static_assert(enum_begin == 0, "enum_begin must start at 0.");
     static_assert(enum_end == enum_size + 1, "enum_end boundary calculation mismatch.");
@@ -1072,8 +1165,8 @@ public:
         #endif
         }
 
-        /* Cross-platform wrapper for linux and MSVC cpuid */
-        static void cpuid(u32& a, u32& b, u32& c, u32& d, const u32 a_leaf, const u32 c_leaf = 0xFF) noexcept {
+        /* Cross-platform wrapper for linux and MSVC cpuid, issuing the instruction on every call */
+        static void cpuid_live(u32& a, u32& b, u32& c, u32& d, const u32 a_leaf, const u32 c_leaf = 0xFF) noexcept {
         #if (x86)
             /* May be unmodified for older 32-bit processors, clearing just in case */
             a = 0;
@@ -1094,25 +1187,29 @@ public:
         #endif
         };
 
+        /* Same, but served from memo::cpuid_snapshot, so the hypervisor only sees each leaf once */
+        static void cpuid(u32& a, u32& b, u32& c, u32& d, const u32 a_leaf, const u32 c_leaf = 0xFF) noexcept {
+        #if (x86)
+            u32 regs[4] = { 0, 0, 0, 0 };
+            memo::cpuid_snapshot::read(a_leaf, c_leaf, regs);
+
+            a = regs[0];
+            b = regs[1];
+            c = regs[2];
+            d = regs[3];
+        #endif
+        };
+
         /* Same as above but for array type parameters (MSVC specific) */
         static void cpuid(i32 x[4], const u32 a_leaf, const u32 c_leaf = 0xFF) noexcept {
         #if (x86)
-            /* May be unmodified for older 32-bit processors, clearing just in case */
-            x[0] = 0;
-            x[1] = 0;
-            x[2] = 0;
-            x[3] = 0;
-
-            u32 aa = 0u;
-            u32 bb = 0u;
-            u32 cc = 0u;
-            u32 dd = 0u;
-            cpuid_count(a_leaf, c_leaf, &aa, &bb, &cc, &dd);
+            u32 regs[4] = { 0, 0, 0, 0 };
+            memo::cpuid_snapshot::read(a_leaf, c_leaf, regs);
 
-            x[0] = static_cast<i32>(aa);
-            x[1] = static_cast<i32>(bb);
-            x[2] = static_cast<i32>(cc);
-            x[3] = static_cast<i32>(dd);
+            x[0] = static_cast<i32>(regs[0]);
+            x[1] = static_cast<i32>(regs[1]);
+            x[2] = static_cast<i32>(regs[2]);
+            x[3] = static_cast<i32>(regs[3]);
         #endif
         };
 
@@ -1120,12 +1217,7 @@ public:
         #if (APPLE) 
             return false;
         #endif
-            bool cached = false;
-
-            if (memo::leaf_cache::fetch(p_leaf, cached)) {
-                return cached;
-            }
-
+            /* The maximum leaf of each range comes from the snapshot, so this never costs more than one VM exit per range */
             u32 eax = 0; 
             u32 unused = 0;
             bool supported = false;
@@ -1133,26 +1225,22 @@ public:
             if (p_leaf < cpu::leaf::hypervisor) {
                 /* Standard range: 0x00000000 - 0x3FFFFFFF */
                 cpu::cpuid(eax, unused, unused, unused, cpu::leaf::basic_info);
-                debug("CPUID: max standard leaf = 0x", std::hex, eax);
                 supported = (p_leaf <= eax);
             }
             else if (p_leaf < cpu::leaf::func_ext) {
                 /* Hypervisor range: 0x40000000 - 0x7FFFFFFF */
                 cpu::cpuid(eax, unused, unused, unused, cpu::leaf::hypervisor);
-                debug("CPUID: max hypervisor leaf = 0x", std::hex, eax);
                 supported = (p_leaf <= eax);
             }
             else if (p_leaf < 0xC0000000) {
                 /* Extended range: 0x80000000 - 0xBFFFFFFF */
                 cpu::cpuid(eax, unused, unused, unused, cpu::leaf::func_ext);
-                debug("CPUID: max extended leaf = 0x", std::hex, eax);
                 supported = (p_leaf <= eax);
             }
             else {
                 supported = false;
             }
 
-            memo::leaf_cache::store(p_leaf, supported);
             return supported;
         }
 
@@ -1454,6 +1542,124 @@ public:
             }
         };
 
+        /*
+         * A CPU database sorted by hash, with the hashes and the thread counts in separate
+         * arrays so nothing is padded. Each model takes 6 bytes: its hash, then threads << 1 | smt.
+         * index[b] is where the hashes with b as their top byte start, so a lookup only
+         * compares the handful of hashes that share one.
+         */
+        template <size_t N>
+        struct cpu_table {
+            u32 hashes[N] = {};
+            u16 info[N] = {};
+            u16 index[257] = {};
+        };
+
+        /* What thread_mismatch() looks models up in, whichever database they come from */
+        struct cpu_db {
+            const u32* hashes = nullptr;
+            const u16* info = nullptr;
+            const u16* index = nullptr;
+
+            template <size_t N>
+            static cpu_db of(const cpu_table<N>& table) noexcept {
+                cpu_db db;
+                db.hashes = table.hashes;
+                db.info = table.info;
+                db.index = table.index;
+                return db;
+            }
+
+            bool find(const u32 hash, u32& threads, bool& smt) const noexcept {
+                if (hashes == nullptr) {
+                    return false;
+                }
+
+                const u32 bucket = hash >> 24;
+                for (u32 i = index[bucket]; i < index[bucket + 1] && hashes[i] <= hash; ++i) {
+                    if (hashes[i] == hash) {
+                        threads = static_cast<u32>(info[i] >> 1);
+                        smt = (info[i] & 1) != 0;
+                        return true;
+                    }
+                }
+                return false;
+            }
+        };
+
+        /* Heapsort, which stays well within every compiler's constexpr step limit for a thousand models */
+        template <size_t N>
+        static VMAWARE_CONSTEXPR void sift_down(cpu_table<N>& table, size_t root, const size_t end) noexcept {
+            while (2 * root + 1 < end) {
+                size_t child = 2 * root + 1;
+                if (child + 1 < end && table.hashes[child] < table.hashes[child + 1]) {
+                    ++child;
+                }
+                if (table.hashes[root] >= table.hashes[child]) {
+                    return;
+                }
+
+                const u32 hash = table.hashes[root];
+                table.hashes[root] = table.hashes[child];
+                table.hashes[child] = hash;
+
+                const u16 info = table.info[root];
+                table.info[root] = table.info[child];
+                table.info[child] = info;
+
+                root = child;
+            }
+        }
+
+        /* Built at compile time from C++17 on, and on first use before that */
+        template <size_t N>
+        static VMAWARE_CONSTEXPR cpu_table<N> make_cpu_table(const cpu_entry (&db)[N]) noexcept {
+            static_assert(N < 0xFFFF, "CPU database too large for 16-bit indices.");
+
+            cpu_table<N> table;
+            for (size_t i = 0; i < N; ++i) {
+                table.hashes[i] = db[i].hash;
+                table.info[i] = static_cast<u16>((db[i].threads << 1) | (db[i].smt ? 1u : 0u));
+            }
+
+            for (size_t i = N / 2; i > 0; --i) {
+                sift_down(table, i - 1, N);
+            }
+            for (size_t end = N - 1; end > 0; --end) {
+                const u32 hash = table.hashes[0];
+                table.hashes[0] = table.hashes[end];
+                table.hashes[end] = hash;
+
+                const u16 info = table.info[0];
+                table.info[0] = table.info[end];
+                table.info[end] = info;
+
+                sift_down(table, 0, end);
+            }
+
+            size_t pos = 0;
+            for (u32 bucket = 0; bucket < 256; ++bucket) {
+                table.index[bucket] = static_cast<u16>(pos);
+                while (pos < N && (table.hashes[pos] >> 24) == bucket) {
+                    ++pos;
+                }
+            }
+            table.index[256] = static_cast<u16>(N);
+
+            return table;
+        }
+
+        /* Two models with the same hash would make one of them unreachable */
+        template <size_t N>
+        static VMAWARE_CONSTEXPR bool collision_free(const cpu_table<N>& table) noexcept {
+            for (size_t i = 1; i < N; ++i) {
+                if (table.hashes[i - 1] == table.hashes[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
         enum class cpu_type : u8 {
             UNKNOWN,
             INTEL_I,
@@ -1462,7 +1668,7 @@ public:
             AMD
         };
 
-        static void get_intel_core_db(const cpu_entry*& out_ptr, size_t& out_size) noexcept {
+        static cpu_db get_intel_core_db() noexcept {
             static constexpr cpu_entry db[] = {
                 /* i3 series */
                 { "i3-1000G1", 4, true },
@@ -2472,11 +2678,15 @@ public:
             };
 
             static_assert(sizeof(db) / sizeof(cpu_entry) > 0, "Intel Core database must contain at least one entry.");
-            out_ptr = db;
-            out_size = sizeof(db) / sizeof(cpu_entry);
+
+            static VMAWARE_CONSTEXPR const cpu_table<sizeof(db) / sizeof(cpu_entry)> table = make_cpu_table(db);
+        #if (VMAWARE_CPP >= 17)
+            static_assert(collision_free(table), "Intel Core database has two models with the same hash.");
+        #endif
+            return cpu_db::of(table);
         }
 
-        static void get_intel_xeon_db(const cpu_entry*& out_ptr, size_t& out_size) noexcept {
+        static cpu_db get_intel_xeon_db() noexcept {
             static constexpr cpu_entry db[] = {
                 { "D-1518", 8, true },
                 { "D-1520", 8, true },
@@ -2613,11 +2823,15 @@ public:
             };
 
             static_assert(sizeof(db) / sizeof(cpu_entry) > 0, "Intel Xeon database must contain at least one entry.");
-            out_ptr = db;
-            out_size = sizeof(db) / sizeof(cpu_entry);
+
+            static VMAWARE_CONSTEXPR const cpu_table<sizeof(db) / sizeof(cpu_entry)> table = make_cpu_table(db);
+        #if (VMAWARE_CPP >= 17)
+            static_assert(collision_free(table), "Intel Xeon database has two models with the same hash.");
+        #endif
+            return cpu_db::of(table);
         }
 
-        static void get_intel_ultra_db(const cpu_entry*& out_ptr, size_t& out_size) noexcept {
+        static cpu_db get_intel_ultra_db() noexcept {
             static constexpr cpu_entry db[] = {
                 /* Series 2 (Arrow Lake - Desktop/Mobile) - No SMT/HT on P-Cores */
                 { "285K", 24, false },
@@ -2651,12 +2865,16 @@ public:
             };
 
             static_assert(sizeof(db) / sizeof(cpu_entry) > 0, "Intel Ultra database must contain at least one entry.");
-            out_ptr = db;
-            out_size = sizeof(db) / sizeof(cpu_entry);
+
+            static VMAWARE_CONSTEXPR const cpu_table<sizeof(db) / sizeof(cpu_entry)> table = make_cpu_table(db);
+        #if (VMAWARE_CPP >= 17)
+            static_assert(collision_free(table), "Intel Ultra database has two models with the same hash.");
+        #endif
+            return cpu_db::of(table);
         }
 
-        static void get_amd_ryzen_db(const cpu_entry*& out_ptr, size_t& out_size) noexcept {
-            static const cpu_entry db[] = {
+        static cpu_db get_amd_ryzen_db() noexcept {
+            static constexpr cpu_entry db[] = {
                 /* 3015/3020 */
                 { "3015ce", 4, true },
                 { "3015e", 4, true },
@@ -3161,8 +3379,12 @@ public:
             };
 
             static_assert(sizeof(db) / sizeof(cpu_entry) > 0, "AMD Ryzen database must contain at least one entry.");
-            out_ptr = db;
-            out_size = sizeof(db) / sizeof(cpu_entry);
+
+            static VMAWARE_CONSTEXPR const cpu_table<sizeof(db) / sizeof(cpu_entry)> table = make_cpu_table(db);
+        #if (VMAWARE_CPP >= 17)
+            static_assert(collision_free(table), "AMD Ryzen database has two models with the same hash.");
+        #endif
+            return cpu_db::of(table);
         }
     };
 
@@ -3189,1362 +3411,3534 @@ public:
             bool cached;
             brand_enum brand_name;
         };
+
+        /*
+         * Every technique slot goes through EMPTY -> RUNNING -> READY once per process.
+         * Only the thread that wins the EMPTY -> RUNNING exchange runs the technique and
+         * writes the slot, so a technique is never executed twice even when several
+         * threads call into the library at the same time. Readers of a READY slot only
+         * need an acquire load, the mutex and condition variable below are exclusively
+         * for threads that have to wait on a slot another thread is still running.
+         */
+        enum entry_state : u8 {
+            ENTRY_EMPTY = 0,
+            ENTRY_RUNNING,
+            ENTRY_READY
+        };
+
+        /*
+         * The result, points and brand share one word, since VM::invalidate() and VM::refresh()
+         * can hand a READY slot back to EMPTY and let another thread fill it again while a
+         * reader is still looking at it. stored_at is on the steady clock, in milliseconds.
+         */
         struct cache_entry {
-            bool result;
-            u8 points;
-            bool has_value;
-            brand_enum brand_name;
+            std::atomic<u8> state;
+            std::atomic<u32> payload;
+            std::atomic<u64> stored_at;
         };
 
         static std::array<cache_entry, enum_size + 1> cache_table;
+        static std::mutex wait_mutex;
+        static std::condition_variable wait_cv;
 
-        static VMAWARE_CONSTEXPR void cache_store(u16 flag, bool result, u8 points, const brand_enum brand = brand_enum::NULL_BRAND) noexcept {
-            if (flag <= enum_size) {
-                VMAWARE_ASSUME(flag <= enum_size);
-                cache_table[flag] = { result, points, true, brand };
+        static void wake_waiters() noexcept {
+            {
+                /* taking the lock orders the state change before a waiter's predicate check */
+                std::lock_guard<std::mutex> lock(wait_mutex);
             }
+            wait_cv.notify_all();
         }
 
-        static constexpr bool is_cached(u16 flag) noexcept {
-            return VMAWARE_LIKELY(flag <= enum_size) && cache_table[flag].has_value;
+        static u64 now_ms() noexcept {
+            return static_cast<u64>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count());
         }
 
-        static VMAWARE_CONSTEXPR data_t cache_fetch(u16 flag) noexcept {
-            if (VMAWARE_UNLIKELY(flag > enum_size)) {
-                return { false, 0, false, brand_enum::NULL_BRAND };
+        /* Must only be called by the thread that claimed the slot */
+        static void cache_store(u16 flag, bool result, u8 points, const brand_enum brand = brand_enum::NULL_BRAND) noexcept {
+            if (flag <= enum_size) {
+                VMAWARE_ASSUME(flag <= enum_size);
+                cache_entry& entry = cache_table[flag];
+                entry.payload.store(static_cast<u32>(result) | (static_cast<u32>(points) << 8) | (static_cast<u32>(brand) << 16), std::memory_order_relaxed);
+                entry.stored_at.store(now_ms(), std::memory_order_relaxed);
+                entry.state.store(ENTRY_READY, std::memory_order_release);
+                wake_waiters();
             }
+        }
 
-            if (VMAWARE_LIKELY(cache_table[flag].has_value)) {
-                const auto& entry = cache_table[flag];
-                return { entry.result, entry.points, true, entry.brand_name };
+        static bool is_cached(u16 flag) noexcept {
+            return VMAWARE_LIKELY(flag <= enum_size) && (cache_table[flag].state.load(std::memory_order_acquire) == ENTRY_READY);
+        }
+
+        /*
+         * The state and the payload are read together here, so a result is only ever taken
+         * from a READY slot. Since VM::invalidate() and VM::refresh() can drop a slot right
+         * after is_cached() or claim() saw it READY, callers go by the returned cached field,
+         * and claim the slot again when it says the result is gone
+         */
+        static data_t cache_fetch(u16 flag) noexcept {
+            if (VMAWARE_LIKELY(is_cached(flag))) {
+                const u32 payload = cache_table[flag].payload.load(std::memory_order_relaxed);
+                return { (payload & 0xFF) != 0, static_cast<u8>(payload >> 8), true, static_cast<brand_enum>(payload >> 16) };
             }
 
             return { false, 0, false, brand_enum::NULL_BRAND };
-            return { false, 0, false, brand_enum::NULL_BRAND };
         }
 
-        struct single_brand {
-            static brand_enum brand_cache;
-            static flagset cached_flags;
-            static bool cached;
+        /* How long ago a cached result was stored, in milliseconds */
+        static u64 age_ms(u16 flag) noexcept {
+            const u64 stored = cache_table[flag].stored_at.load(std::memory_order_relaxed);
+            const u64 now = now_ms();
+            return (now > stored) ? (now - stored) : 0;
+        }
 
-            static void store(const brand_enum s, const flagset& flags) noexcept {
-                brand_cache = s;
-                cached_flags = flags;
-                cached = true;
+        /*
+         * Drop a result so the technique runs again the next time it's needed. Only READY
+         * slots are dropped, one that's being run right now is left to the thread running it
+         */
+        static bool forget(u16 flag) noexcept {
+            if (VMAWARE_UNLIKELY(flag > enum_size)) {
+                return false;
             }
 
-            static bool is_cached(const flagset& flags) noexcept {
-                return cached && (cached_flags == flags); 
-            }
-            
-            static brand_enum fetch() noexcept {
-                return brand_cache; 
+            u8 expected = ENTRY_READY;
+            return cache_table[flag].state.compare_exchange_strong(expected, ENTRY_EMPTY, std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        /*
+         * Non-blocking claim. Returns true if the caller now owns the slot and has to
+         * either cache_store() or release() it. Flags outside of the table (custom
+         * techniques past enum_size) are never cached, so they're always "owned".
+         */
+        static bool try_claim(u16 flag) noexcept {
+            if (VMAWARE_UNLIKELY(flag > enum_size)) {
+                return true;
             }
-        };
 
-        struct multi_brand {
-            static std::string brand_cache;
-            static flagset cached_flags;
-            static bool cached;
+            u8 expected = ENTRY_EMPTY;
+            return cache_table[flag].state.compare_exchange_strong(expected, ENTRY_RUNNING, std::memory_order_acq_rel, std::memory_order_acquire);
+        }
 
-            static void store(const std::string& s, const flagset& flags) noexcept {
-                brand_cache = s;
-                cached_flags = flags;
-                cached = true;
+        /*
+         * Blocking claim. Returns true if the caller owns the slot, or false once the
+         * slot holds a result (possibly after waiting for whoever was running it).
+         */
+        static bool claim(u16 flag) noexcept {
+            if (VMAWARE_LIKELY(is_cached(flag))) {
+                return false;
             }
 
-            static bool is_cached(const flagset& flags) noexcept {
-                return cached && (cached_flags == flags);
+            if (try_claim(flag)) {
+                return true;
             }
 
-            static std::string fetch() noexcept {
-                return brand_cache;
-            }
-        };
+            std::unique_lock<std::mutex> lock(wait_mutex);
 
-        struct brand_list {
-            static brand_list_t cache;
-            static flagset cached_flags;
-            static bool cached;
+            for (;;) {
+                if (is_cached(flag)) {
+                    return false;
+                }
 
-            static void store(const brand_list_t& list, const flagset& flags) noexcept {
-                cache = list;
-                cached_flags = flags;
-                cached = true;
-            }
+                /* the owner might have given the slot back without a result */
+                if (try_claim(flag)) {
+                    return true;
+                }
 
-            static bool is_cached(const flagset& flags) noexcept {
-                return cached && (cached_flags == flags);
+                wait_cv.wait(lock, [flag]() noexcept {
+                    return cache_table[flag].state.load(std::memory_order_acquire) != ENTRY_RUNNING;
+                });
             }
+        }
 
-            static brand_list_t fetch() noexcept {
-                return cache;
+        /* Give a claimed slot back without a result, for techniques that were claimed but never run */
+        static void release(u16 flag) noexcept {
+            if (flag <= enum_size) {
+                cache_table[flag].state.store(ENTRY_EMPTY, std::memory_order_release);
+                wake_waiters();
             }
-        };
+        }
 
-        /* Helper specifically for conclusion strings */
-        struct conclusion {
-            static char cache[512];
-            static flagset cached_flags;
-            static bool cached;
+        /*
+         * Gives a claimed slot back if the technique throws before its result is stored,
+         * otherwise every later claim() on it would wait for a result that never comes
+         */
+        struct claim_guard {
+            u16 flag;
+            bool armed;
 
-            static void store(const char* s, const flagset& flags) noexcept {
-                str_copy(cache, s, sizeof(cache));
-                cached_flags = flags;
-                cached = true;
-            }
+            explicit claim_guard(const u16 id) noexcept : flag(id), armed(true) {}
 
-            static bool is_cached(const flagset& flags) noexcept {
-                return cached && (cached_flags == flags);
+            ~claim_guard() {
+                if (armed) {
+                    release(flag);
+                }
             }
 
-            static const char* fetch() noexcept {
-                return cache; 
-            }
+            void dismiss() noexcept { armed = false; }
         };
 
-        struct cpu_brand {
-            static char brand_cache[128];
-            static bool cached;
+        /* Guards the result caches below, which hold more than a word of data */
+        static std::mutex result_mutex;
 
-            static void store(const char* s) noexcept {
-                str_copy(brand_cache, s, sizeof(brand_cache));
-                cached = true;
-            }
+        /* Hit and miss counters of one result cache, since it was first used */
+        struct cache_stats {
+            u64 hits;
+            u64 misses;
+        };
 
-            static bool is_cached() noexcept {
-                return cached; 
+        /*
+         * Small LRU cache of results keyed by the flagset they were computed for.
+         * Callers tend to alternate between a handful of flag combinations
+         * (the default, VM::MULTIPLE, VM::HIGH_THRESHOLD...), so a single slot
+         * would keep throwing away the result it's about to be asked for again.
+         * Entries are matched on the flagset hash first and only then on the
+         * whole bitset. None of this locks, result_mutex must already be held.
+         */
+        template <typename T>
+        struct result_cache {
+            static constexpr std::size_t CAPACITY = 8;
+
+            struct slot {
+                std::size_t key;
+                u64 last_used; /* 0 means the slot was never filled */
+                flagset flags;
+                T value;
+            };
+
+            std::array<slot, CAPACITY> slots;
+            u64 clock;
+            cache_stats stats;
+
+            static std::size_t key_of(const flagset& flags) noexcept {
+                return std::hash<flagset>()(flags);
             }
 
-            static const char* fetch() noexcept {
-                return brand_cache; 
+            /* Returns the entry for these flags and marks it as the most recently used one, or nullptr on a miss */
+            const T* find(const flagset& flags) noexcept {
+                const std::size_t key = key_of(flags);
+
+                for (auto& entry : slots) {
+                    if (entry.last_used != 0 && entry.key == key && entry.flags == flags) {
+                        entry.last_used = ++clock;
+                        ++stats.hits;
+                        return &entry.value;
+                    }
+                }
+
+                ++stats.misses;
+                return nullptr;
             }
-        };
 
-        struct thread_count {
-            static u32 thread_count_cache;
+            /* Returns the entry to overwrite for these flags: the existing one, an empty one, or the least recently used one */
+            T& insert(const flagset& flags) noexcept {
+                const std::size_t key = key_of(flags);
+                slot* victim = &slots[0];
 
-            static u32 fetch() noexcept {
-                if (VMAWARE_LIKELY(thread_count_cache != 0)) {
-                    VMAWARE_ASSUME(thread_count_cache != 0);
-                    return thread_count_cache;
+                for (auto& entry : slots) {
+                    if (entry.last_used != 0 && entry.key == key && entry.flags == flags) {
+                        victim = &entry;
+                        break;
+                    }
+
+                    if (entry.last_used < victim->last_used) {
+                        victim = &entry;
+                    }
+                }
+
+                victim->key = key;
+                victim->flags = flags;
+                victim->last_used = ++clock;
+                return victim->value;
+            }
+
+            void clear() noexcept {
+                for (auto& entry : slots) {
+                    entry.last_used = 0;
                 }
-                thread_count_cache = std::thread::hardware_concurrency();
-                return thread_count_cache;
             }
         };
 
-        struct hyperx {
-            static hyperx_state state;
-            static bool cached;
+        struct single_brand {
+            static result_cache<brand_enum> entries;
 
-            static hyperx_state fetch() noexcept {
-                return state; 
+            static void store(const brand_enum s, const flagset& flags) noexcept {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                entries.insert(flags) = s;
             }
 
-            static void store(const hyperx_state p_state) noexcept {
-                state = p_state;
-                cached = true;
+            static bool fetch(const flagset& flags, brand_enum& out) noexcept {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                const brand_enum* hit = entries.find(flags);
+                if (hit) {
+                    out = *hit;
+                    return true;
+                }
+                return false;
             }
 
-            static bool is_cached() noexcept {
-                return cached;
+            static cache_stats stats() noexcept {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                return entries.stats;
             }
         };
 
-        struct leaf_entry { 
-            u32 leaf; 
-            bool value;
-            bool has_value; 
-        };
+        struct multi_brand {
+            static result_cache<std::string> entries;
 
-        struct leaf_cache {
-            static constexpr std::size_t CAPACITY = 128;
-            static std::array<leaf_entry, CAPACITY> table;
-            static std::size_t count;      
-            static std::size_t next_index; 
+            static void store(const std::string& s, const flagset& flags) {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                entries.insert(flags) = s;
+            }
 
-            static bool fetch(u32 leaf, bool& out) noexcept {
-                for (std::size_t i = 0; i < count; ++i) {
-                    if (table[i].has_value && table[i].leaf == leaf) {
-                        out = table[i].value;
-                        return true;
-                    }
+            static bool fetch(const flagset& flags, std::string& out) {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                const std::string* hit = entries.find(flags);
+                if (hit) {
+                    out = *hit;
+                    return true;
                 }
-
                 return false;
             }
 
-            static void store(u32 leaf, bool val) noexcept {
-                for (std::size_t i = 0; i < count; ++i) {
-                    auto& entry = table[i];
-                    if (entry.leaf == leaf) {
-                        entry.value = val;
-                        entry.has_value = true;
-                        return;
-                    }
-                }
+            static cache_stats stats() noexcept {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                return entries.stats;
+            }
+        };
 
-                if (count < CAPACITY) {
-                    table[count++] = { leaf, val, true };
-                    return;
+        struct brand_list {
+            static result_cache<brand_list_t> entries;
+
+            static void store(const brand_list_t& list, const flagset& flags) {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                entries.insert(flags) = list;
+            }
+
+            static bool fetch(const flagset& flags, brand_list_t& out) {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                const brand_list_t* hit = entries.find(flags);
+                if (hit) {
+                    out = *hit;
+                    return true;
                 }
+                return false;
+            }
 
-                table[next_index] = { leaf, val, true };
-                next_index = (next_index + 1) % CAPACITY;
+            static cache_stats stats() noexcept {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                return entries.stats;
             }
         };
 
-        struct bios_info {
-            static char manufacturer[256];
-            static char model[128];
-            static bool cached;
+        /* Helper specifically for conclusion strings */
+        struct conclusion {
+            using text_t = std::array<char, 512>;
+            static result_cache<text_t> entries;
 
-            static constexpr const char* fetch_manufacturer() noexcept {
-                return manufacturer;
+            static void store(const char* s, const flagset& flags) noexcept {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                text_t& cache = entries.insert(flags);
+                str_copy(cache.data(), s, cache.size());
             }
 
-            static constexpr const char* fetch_model() noexcept {
-                return model;
+            static bool fetch(const flagset& flags, std::string& out) {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                const text_t* hit = entries.find(flags);
+                if (hit) {
+                    out = hit->data();
+                    return true;
+                }
+                return false;
             }
 
-            static VMAWARE_CONSTEXPR void store_manufacturer(const char* VMAWARE_RESTRICT s) noexcept {
-                if (!s) { 
-                    manufacturer[0] = '\0'; 
-                    return; 
-                }
-                const size_t n = strlen(s);
-                const size_t cap = sizeof(manufacturer) - 1;
-                const size_t tocopy = (n > cap) ? cap : n;
-                for (size_t i = 0; i < tocopy; ++i) {
-                    manufacturer[i] = s[i];
+            static cache_stats stats() noexcept {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                return entries.stats;
+            }
+        };
+
+        /* Empty the result caches above, which are only as good as the technique results they were built from */
+        static void forget_results() noexcept {
+            std::lock_guard<std::mutex> lock(result_mutex);
+            single_brand::entries.clear();
+            multi_brand::entries.clear();
+            brand_list::entries.clear();
+            conclusion::entries.clear();
+        }
+
+        /*
+         * Contents of the files read during a run, keyed by path, so a file that several
+         * techniques look at (the DMI id files, /proc/cpuinfo...) is opened and read only
+         * once per run. It's only filled while at least one run is going on, and emptied
+         * when the last one finishes, so a new run always sees fresh sysfs and procfs
+         * contents. The util readers are the only users, everything else goes through them.
+         */
+        struct file_cache {
+            static constexpr std::size_t CAPACITY = 64;
+
+            struct entry {
+                std::string path;
+                std::string content;
+                bool exists_known; /* from a stat(), or implied by a successful open() */
+                bool exists;
+                bool read_done;    /* open() was attempted, content is only valid if it succeeded */
+                bool opened;
+                u32 syscalls; /* what it took to fill this entry, which is what every hit saves */
+                u64 generation; /* of the run that filled it */
+            };
+
+            struct stats_t {
+                u64 hits;
+                u64 misses;
+                u64 syscalls_saved;
+            };
+
+            static std::array<entry, CAPACITY> table;
+            static std::size_t count;
+            static stats_t totals;
+            static std::atomic<u32> active_runs;
+            static std::mutex mutex;
+
+            /*
+             * Every run takes a new generation when it starts, and every entry keeps the one of
+             * the run that filled it. A run only takes entries filled by runs that started no
+             * earlier than itself, so in a daemon where runs keep overlapping and the table is
+             * never emptied, /proc content read by runs that are long gone isn't handed to newer
+             * ones. Outside of a run, or on a thread that isn't told its run, anything goes.
+             */
+            static std::atomic<u64> generation;
+            static thread_local u64 run_generation;
+
+            static bool active() noexcept {
+                return active_runs.load(std::memory_order_acquire) != 0;
+            }
+
+            static bool fresh(const entry& e) noexcept {
+                return e.generation >= run_generation;
+            }
+
+            /* Returns the generation of the run this one is nested in, if any, for end_run() to put back */
+            static u64 begin_run() noexcept {
+                const u64 outer = run_generation;
+                run_generation = generation.fetch_add(1, std::memory_order_acq_rel) + 1;
+                active_runs.fetch_add(1, std::memory_order_acq_rel);
+                return outer;
+            }
+
+            static void end_run(const u64 outer) noexcept {
+                run_generation = outer;
+
+                if (active_runs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                #ifdef VMAWARE_DEBUG
+                    const stats_t current = stats();
+                    if (current.hits > 0) {
+                        debug("FILE_CACHE: ", current.hits, " hits and ", current.misses, " misses so far, ", current.syscalls_saved, " syscalls saved");
+                    }
+                #endif
+                    invalidate();
                 }
-                *(manufacturer + tocopy) = '\0';
-                cached = true;
             }
 
-            static VMAWARE_CONSTEXPR void store_model(const char* VMAWARE_RESTRICT s) noexcept {
-                if (!s) { 
-                    model[0] = '\0';
-                    return; 
+            /* Drop every cached file, for when the files are known to have changed in the middle of a run */
+            static void invalidate() noexcept {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (std::size_t i = 0; i < count; ++i) {
+                    table[i].path.clear();
+                    table[i].content.clear();
                 }
-                const size_t n = strlen(s);
-                const size_t cap = sizeof(model) - 1;
-                const size_t tocopy = (n > cap) ? cap : n;
-                for (size_t i = 0; i < tocopy; ++i) {
-                    model[i] = s[i];
+                count = 0;
+            }
+
+            /* Whether the path exists, if that's known already */
+            static bool fetch_exists(const char* path, bool& out) noexcept {
+                std::lock_guard<std::mutex> lock(mutex);
+                const entry* e = find(path);
+                if (!e || !fresh(*e) || !e->exists_known) {
+                    ++totals.misses;
+                    return false;
                 }
-                *(model + tocopy) = '\0';
-                cached = true;
+                ++totals.hits;
+                totals.syscalls_saved += 1; /* the stat() */
+                out = e->exists;
+                return true;
             }
 
-            static bool is_cached() noexcept {
-                return cached; 
+            /* The whole file, if it was read already. A file that couldn't be opened comes back as a hit with opened = false */
+            static bool fetch_content(const char* path, std::string& out, bool& opened) {
+                std::lock_guard<std::mutex> lock(mutex);
+                const entry* e = find(path);
+                if (!e || !fresh(*e) || !(e->read_done || (e->exists_known && !e->exists))) {
+                    ++totals.misses;
+                    return false;
+                }
+                ++totals.hits;
+                totals.syscalls_saved += e->read_done ? e->syscalls : 1;
+                opened = e->read_done && e->opened;
+                out = e->content;
+                return true;
             }
-        };
 
-    #if (WINDOWS)
-        struct module {
-            static HMODULE& fetch_ntdll() noexcept {
-                static HMODULE handle = nullptr;
-                return handle;
+            /* Same as above, but copied into a null-terminated buffer, with the copied length or -1 in length */
+            static bool fetch_content(const char* path, char* buffer, const std::size_t capacity, i64& length) noexcept {
+                std::lock_guard<std::mutex> lock(mutex);
+                const entry* e = find(path);
+                if (!e || !fresh(*e) || !(e->read_done || (e->exists_known && !e->exists))) {
+                    ++totals.misses;
+                    return false;
+                }
+                ++totals.hits;
+                totals.syscalls_saved += e->read_done ? e->syscalls : 1;
+
+                if (!(e->read_done && e->opened)) {
+                    buffer[0] = '\0';
+                    length = -1;
+                    return true;
+                }
+
+                const std::size_t n = (std::min)(e->content.size(), capacity - 1);
+                std::memcpy(buffer, e->content.data(), n);
+                buffer[n] = '\0';
+                length = static_cast<i64>(n);
+                return true;
             }
 
-            static HMODULE& fetch_kernel32() noexcept {
-                static HMODULE handle = nullptr;
-                return handle;
+            static void store_exists(const char* path, const bool exists) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!active()) {
+                    return;
+                }
+                entry* e = claim(path);
+                if (e) {
+                    e->exists_known = true;
+                    e->exists = exists;
+                }
             }
 
-            static void store(const HMODULE ntdll, const HMODULE kernel32) noexcept {
-                fetch_ntdll() = ntdll;
-                fetch_kernel32() = kernel32;
-                is_cached() = true;
+            static void store_content(const char* path, const std::string& content, const bool opened, const u32 syscalls) {
+                store_content(path, content.data(), content.size(), opened, syscalls);
             }
 
-            static bool& is_cached() noexcept {
-                static bool cached = false;
-                return cached;
+            /* Same as above, straight from a buffer, the entry's string keeps its capacity from one run to the next */
+            static void store_content(const char* path, const char* content, const std::size_t length, const bool opened, const u32 syscalls) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!active()) {
+                    return;
+                }
+                entry* e = claim(path);
+                if (e) {
+                    /* A failed open() doesn't mean it's not there, it might just be unreadable */
+                    if (opened) {
+                        e->exists_known = true;
+                        e->exists = true;
+                    }
+                    e->read_done = true;
+                    e->opened = opened;
+                    e->content.assign(content, length);
+                    e->syscalls = syscalls;
+                }
             }
-        };
-    #endif
-    };
 
-#if (WINDOWS)
-    /* Timing attacks helper functionalities */
-    #if (x86)
-    struct timer {
-    #if (x86_64)
-        using timer_tick_t = u64;
-    #else
-        using timer_tick_t = u32;
-    #endif
+            static stats_t stats() noexcept {
+                std::lock_guard<std::mutex> lock(mutex);
+                return totals;
+            }
 
-    #if (MSVC)
-        #pragma warning(push)
-        #pragma warning(disable: 4324) 
-    #endif
-        /* Align to prevent false sharing when triggering hypervisor exits with the intentional data race condition */
-        struct alignas(64) cache_state {
-            alignas(64) volatile timer_tick_t counter { 0 };
-            alignas(64) std::atomic<bool> start_test{ false };
-            alignas(64) std::atomic<bool> test_done{ false };
-        };
-    #if (MSVC)
-        #pragma warning(pop)
-    #endif
+            static entry* find(const char* path) noexcept {
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (table[i].path == path) {
+                        return &table[i];
+                    }
+                }
+                return nullptr;
+            }
 
-        #define VMAWARE_STR2(x) #x
-        #define VMAWARE_STR(x) VMAWARE_STR2(x)
+            /*
+             * The entry to fill for a path. One that older runs filled starts over for this run,
+             * and once the table is full, the stalest entry makes room if this run can't use it
+             * anyway. Otherwise nullptr, in which case the file just isn't cached
+             */
+            static entry* claim(const char* path) {
+                entry* e = find(path);
 
-        struct config {
-            [[nodiscard]] static VMAWARE_CONSTEXPR u32 get_seed() noexcept {
-                constexpr char s[] = __DATE__ " " __TIME__ " " __FILE__ " " VMAWARE_STR(__LINE__);
-                u32 h = 2166136261u;
-                for (char c : s) {
-                    if (!c) {
-                        break;
+                if (!e && count < CAPACITY) {
+                    e = &table[count++];
+                    e->path = path;
+                    reset(*e);
+                    return e;
+                }
+
+                if (!e) {
+                    e = &table[0];
+                    for (std::size_t i = 1; i < count; ++i) {
+                        if (table[i].generation < e->generation) {
+                            e = &table[i];
+                        }
                     }
-                    h ^= static_cast<unsigned char>(c);
-                    h *= 16777619u;
+                    if (fresh(*e)) {
+                        return nullptr;
+                    }
+                    e->path = path;
+                    reset(*e);
+                    return e;
                 }
-                return h;
+
+                if (!fresh(*e)) {
+                    reset(*e);
+                }
+
+                return e;
             }
 
-            [[nodiscard]] static constexpr size_t clamp_c11(const size_t val, const size_t min_val, const size_t max_val) noexcept {
-                return (val < min_val) ? min_val : ((val > max_val) ? max_val : val);
+            static void reset(entry& e) noexcept {
+                e.content.clear();
+                e.exists_known = false;
+                e.exists = false;
+                e.read_done = false;
+                e.opened = false;
+                e.syscalls = 0;
+                e.generation = (run_generation != 0) ? run_generation : generation.load(std::memory_order_acquire);
             }
+        };
 
-            [[nodiscard]] static size_t generate_batch_size(const u32 ct_seed) noexcept {
-                /*
-                 * Important so that hypervisor can't predict how many samples we will collect
-                 * stack-only / ASLR-derived component (no APIs, no interceptable instructions by hypervisors)
-                 */
-                u64 seed = 0;
-                seed ^= static_cast<u64>(ct_seed);
+        struct cpu_brand {
+            static char brand_cache[128];
+            static std::atomic<bool> cached;
+            static std::mutex mutex;
 
-                u64 local1 = 0;
-                u64 local2 = 0;
-                u64 local3 = 0;
+            /* First store wins, the buffer is never written again once it's published */
+            static void store(const char* s) noexcept {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (cached.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                str_copy(brand_cache, s, sizeof(brand_cache));
+                cached.store(true, std::memory_order_release);
+            }
 
-                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&seed));
-                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local1)) << 1;
-                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local2)) << 2;
-                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local3)) << 3;
+            static bool is_cached() noexcept {
+                return cached.load(std::memory_order_acquire);
+            }
 
-                seed ^= seed >> 33;
-                seed *= 0xff51afd7ed558ccdULL;
-                seed ^= seed >> 33;
-                seed *= 0xc4ceb9fe1a85ec53ULL;
-                seed ^= seed >> 33;
+            static const char* fetch() noexcept {
+                return brand_cache; 
+            }
+        };
 
-                std::seed_seq seq{
-                    static_cast<u32>(seed),
-                    static_cast<u32>(seed >> 32),
-                    static_cast<u32>(seed ^ 0x9e3779b9u),
-                    ct_seed
-                };
+        struct thread_count {
+            static std::atomic<u32> thread_count_cache;
 
-                std::mt19937 gen(seq);
-                return std::uniform_int_distribution<size_t>(500, 1000)(gen);
+            static u32 fetch() noexcept {
+                const u32 cached = thread_count_cache.load(std::memory_order_relaxed);
+                if (VMAWARE_LIKELY(cached != 0)) {
+                    VMAWARE_ASSUME(cached != 0);
+                    return cached;
+                }
+                const u32 count = std::thread::hardware_concurrency();
+                thread_count_cache.store(count, std::memory_order_relaxed);
+                return count;
             }
         };
 
-        struct scheduler {
-            
-            /*
-             *  Golden Rules (must happen ALWAYS; if they don't happen the check should be aborted):
-             *  1. The check needs AT LEAST two different physical cores, so if one single core is detected, returns
-             *  2. The counter thread should always be in the middle available physical CPU when there's more than 2 cores, and in the core 2 (1-indexed) when there's 2 cores
-             *  3. The counter thread and the measurement thread can't never be in the same physical core. This means that SMT siblings should always be avoided.
-             *
-             *  Silver Rules (in order of priority):
-             *  1. Prioritize higher-performance pipelines (P-cores) over efficiency-oriented pipelines (E-cores) for the measurement thread (+800). P-cores feature private L2 caches (no cluster controller congestion).
-             *  2. Prioritize candidates within the same NUMA node (+1000) and same L3 cache slice/CCD domain (+500) to ensure minimal latency (preventing cross-CCD Infinity Fabric or cross-socket routing delays).
-             *  3. Deduct points (-800) for candidate cores that share an L2 cache with the counter thread but reside on different physical cores (targeting and resolving Intel E-core cluster L2 controller bottlenecks).
-             *  4. Prioritize cores with matching efficiency classes (+100) to align power and frequency (DVFS) domains.
-             *  5. Apply a minor index-distance penalty to select the closest physical neighbor on the silicon layout/ring bus stop (best-effort only because logical indexing does not always prove physical proximity).
-             *  6. Penalize edge logical cores (-50) because those are where most OS interrupt and background DPC scheduler noise occur.
-            */
-            [[nodiscard]] static GROUP_AFFINITY get_mask(const bool measurement) {
-                const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
-                const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
+        struct hyperx {
+            static std::atomic<hyperx_state> state;
+            static std::atomic<bool> cached;
 
-                GROUP_AFFINITY active_group_aff{};
-                DWORD_PTR proc_mask = 0, sys_mask = 0;
+            static hyperx_state fetch() noexcept {
+                return state.load(std::memory_order_relaxed); 
+            }
 
-                /* Base our available CPU pool on the process-wide affinity mask instead of the thread's currently restricted affinity mask. Threads are frequently restricted to a single core by runtime schedulers or thread-pools, while the process retains access to all cores. */
-                if (GetProcessAffinityMask(current_process, &proc_mask, &sys_mask) && proc_mask) {
-                    active_group_aff.Mask = proc_mask;
+            static void store(const hyperx_state p_state) noexcept {
+                state.store(p_state, std::memory_order_relaxed);
+                cached.store(true, std::memory_order_release);
+            }
 
-                    /* Query the executing thread's current group to ensure both threads run on the same processor group/physical socket to avoid severe interconnect latency */
-                    GROUP_AFFINITY thread_aff{};
-                    if (GetThreadGroupAffinity(current_thread, &thread_aff)) {
-                        active_group_aff.Group = thread_aff.Group;
+            static bool is_cached() noexcept {
+                return cached.load(std::memory_order_acquire);
+            }
+        };
+
+        /*
+         * Every CPUID leaf the techniques read, so each one costs a single VM exit per
+         * process instead of one per call. The basic (0x0 - 0x1F), hypervisor (0x40000000
+         * - 0x4000001F and 0x40000100 - 0x4000011F) and extended (0x80000000 - 0x8000002F)
+         * ranges are indexed directly by leaf, then come subleaves 0 to 3 of the leaves
+         * that have them. Slots fill on first read, or all at once with capture().
+         *
+         * Registers that differ between cores (APIC IDs in leaves 0x1, 0xB and 0x1F) hold
+         * whichever core filled the slot, so checks comparing them go through cpu::cpuid_live().
+         */
+        struct cpuid_snapshot {
+            struct record {
+                u32 leaf;
+                u32 subleaf;
+                u32 regs[4];
+            };
+
+            static constexpr u32 default_subleaf = 0xFF;
+            static constexpr u32 window = 0x20;
+            static constexpr u32 extended_window = 0x30;
+            static constexpr u32 subleaf_count = 4;
+            static constexpr u32 subleaf_leaves[4] = { 0x07, 0x0B, 0x0D, 0x1F };
+
+            static constexpr u32 basic_base = 0;
+            static constexpr u32 hypervisor_base = basic_base + window;
+            static constexpr u32 hv_enlightenment_base = hypervisor_base + window;
+            static constexpr u32 extended_base = hv_enlightenment_base + window;
+            static constexpr u32 subleaf_base = extended_base + extended_window;
+            static constexpr u32 SLOTS = subleaf_base + 4 * subleaf_count;
+
+            static u32 table[SLOTS][4];
+            static std::atomic<bool> valid[SLOTS];
+            static std::atomic<bool> loaded;
+            static std::mutex mutex;
+
+            /* Where a leaf and subleaf live in the table, or -1 when they aren't kept */
+            static int slot(const u32 leaf, const u32 subleaf) noexcept {
+                if (subleaf == default_subleaf) {
+                    if (leaf < window) {
+                        return static_cast<int>(basic_base + leaf);
                     }
-                    else {
-                        active_group_aff.Group = 0;
+                    if (leaf - 0x40000000u < window) {
+                        return static_cast<int>(hypervisor_base + (leaf - 0x40000000u));
+                    }
+                    if (leaf - 0x40000100u < window) {
+                        return static_cast<int>(hv_enlightenment_base + (leaf - 0x40000100u));
                     }
+                    if (leaf - 0x80000000u < extended_window) {
+                        return static_cast<int>(extended_base + (leaf - 0x80000000u));
+                    }
+                    return -1;
+                }
+
+                if (subleaf < subleaf_count) {
+                    for (u32 i = 0; i < 4; ++i) {
+                        if (subleaf_leaves[i] == leaf) {
+                            return static_cast<int>(subleaf_base + i * subleaf_count + subleaf);
+                        }
+                    }
+                }
+                return -1;
+            }
+
+            static record record_of(const u32 index) noexcept {
+                record r {};
+                if (index < hypervisor_base) {
+                    r.leaf = index - basic_base;
+                }
+                else if (index < hv_enlightenment_base) {
+                    r.leaf = 0x40000000u + (index - hypervisor_base);
+                }
+                else if (index < extended_base) {
+                    r.leaf = 0x40000100u + (index - hv_enlightenment_base);
+                }
+                else if (index < subleaf_base) {
+                    r.leaf = 0x80000000u + (index - extended_base);
                 }
                 else {
-                    return {};
+                    r.leaf = subleaf_leaves[(index - subleaf_base) / subleaf_count];
+                    r.subleaf = (index - subleaf_base) % subleaf_count;
+                    return r;
                 }
+                r.subleaf = default_subleaf;
+                return r;
+            }
 
-                const WORD target_group = active_group_aff.Group;
-                const KAFFINITY target_mask = active_group_aff.Mask;
+            static void read(const u32 leaf, const u32 subleaf, u32 out[4]) noexcept {
+                const int index = slot(leaf, subleaf);
 
-                DWORD len = 0;
-                SetLastError(ERROR_SUCCESS);
-                GetLogicalProcessorInformationEx(RelationAll, nullptr, &len);
-                if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || !len) {
-                    return {};
+                if (index >= 0 && valid[index].load(std::memory_order_acquire)) {
+                    memcpy(out, table[index], sizeof(table[index]));
+                    return;
                 }
 
-                std::vector<BYTE> topo(len);
-                if (!GetLogicalProcessorInformationEx(
-                    RelationAll,
-                    reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(topo.data()),
-                    &len)) {
-                    return {};
+                /* A loaded snapshot stands in for the CPU, so anything it doesn't have reads as unsupported */
+                if (loaded.load(std::memory_order_acquire)) {
+                    out[0] = out[1] = out[2] = out[3] = 0;
+                    return;
                 }
 
-                struct GroupCpu {
-                    DWORD LogicalId = 0xFFFFFFFFu; /* 0..63 within target group */
-                    DWORD CoreId = 0xFFFFFFFFu;
-                    DWORD NumaNode = 0xFFFFFFFFu;
-                    DWORD L2CacheId = 0xFFFFFFFFu;
-                    DWORD L3CacheId = 0xFFFFFFFFu;
-                    BYTE EfficiencyClass = 0;
-                };
+                if (index < 0) {
+                    cpu::cpuid_count(leaf, subleaf, &out[0], &out[1], &out[2], &out[3]);
+                    return;
+                }
 
-                GroupCpu group_cpus[64]{};
-                DWORD active_cpu_count = 0;
-                DWORD idxs[64]{};
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!valid[index].load(std::memory_order_relaxed)) {
+                    cpu::cpuid_count(leaf, subleaf, &table[index][0], &table[index][1], &table[index][2], &table[index][3]);
+                    valid[index].store(true, std::memory_order_release);
+                }
+                memcpy(out, table[index], sizeof(table[index]));
+            }
 
-                for (DWORD i = 0; i < 64; ++i) {
-                    if (target_mask & (1ull << i)) {
-                        group_cpus[i].LogicalId = i;
-                        idxs[active_cpu_count++] = i;
+            /* Fill every slot the CPU has, and copy them out when out isn't null. Returns how many there are */
+            static size_t capture(record* out = nullptr, const size_t capacity = 0) noexcept {
+                u32 regs[4];
+                read(0, default_subleaf, regs);
+                const u32 max_basic = regs[0];
+                read(0x40000000u, default_subleaf, regs);
+                const u32 max_hypervisor = regs[0];
+                read(0x40000100u, default_subleaf, regs);
+                const u32 max_hv_enlightenment = regs[0];
+                read(0x80000000u, default_subleaf, regs);
+                const u32 max_extended = regs[0];
+
+                size_t count = 0;
+                for (u32 index = 0; index < SLOTS; ++index) {
+                    record r = record_of(index);
+
+                    bool supported = false;
+                    if (index < hypervisor_base || index >= subleaf_base) {
+                        supported = (r.leaf <= max_basic);
+                    }
+                    else if (index < hv_enlightenment_base) {
+                        supported = (r.leaf <= max_hypervisor);
+                    }
+                    else if (index < extended_base) {
+                        supported = (r.leaf <= max_hv_enlightenment);
+                    }
+                    else {
+                        supported = (r.leaf <= max_extended);
+                    }
+
+                    if (!supported) {
+                        continue;
+                    }
+
+                    read(r.leaf, r.subleaf, r.regs);
+                    if (out != nullptr && count < capacity) {
+                        out[count] = r;
                     }
+                    ++count;
                 }
+                return count;
+            }
 
-                if (active_cpu_count < 2) {
-                    return {};
+            /*
+             * Replace the CPU with recorded leaves, for tests. Call it before the first
+             * detection, since a few results derived from CPUID are cached on their own.
+             */
+            static void load(const record* records, const size_t count) noexcept {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (u32 i = 0; i < SLOTS; ++i) {
+                    valid[i].store(false, std::memory_order_relaxed);
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    const int index = slot(records[i].leaf, records[i].subleaf);
+                    if (index >= 0) {
+                        memcpy(table[index], records[i].regs, sizeof(table[index]));
+                        valid[index].store(true, std::memory_order_release);
+                    }
                 }
+                loaded.store(true, std::memory_order_release);
+            }
 
-                DWORD core_count = 0;
-                DWORD cache_count = 0;
-                size_t offset = 0;
+            /* Forget every leaf, loaded or read, and go back to the real CPU */
+            static void reset() noexcept {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (u32 i = 0; i < SLOTS; ++i) {
+                    valid[i].store(false, std::memory_order_relaxed);
+                }
+                loaded.store(false, std::memory_order_release);
+            }
+        };
 
-                while (offset + sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) <= len) {
-                    auto* ptr = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(topo.data() + offset);
+        struct bios_info {
+            static char manufacturer[256];
+            static char model[128];
+            static std::atomic<bool> cached;
 
-                    constexpr size_t base_header_size = sizeof(LOGICAL_PROCESSOR_RELATIONSHIP) + sizeof(DWORD);
-                    if (ptr->Size < base_header_size || offset + ptr->Size > len) {
-                        return {};
-                    }
+            static constexpr const char* fetch_manufacturer() noexcept {
+                return manufacturer;
+            }
 
-                    switch (ptr->Relationship) {
-                    case RelationProcessorCore: {
-                        const size_t expected_size = offsetof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, Processor.GroupMask) + (ptr->Processor.GroupCount * sizeof(GROUP_AFFINITY));
-                        if (ptr->Size < expected_size) {
-                            return {};
-                        }
+            static constexpr const char* fetch_model() noexcept {
+                return model;
+            }
 
-                        const DWORD core_id = core_count++;
-                        const BYTE efficiency = ptr->Processor.EfficiencyClass;
+            static VMAWARE_CONSTEXPR void store_manufacturer(const char* VMAWARE_RESTRICT s) noexcept {
+                if (!s) { 
+                    manufacturer[0] = '\0'; 
+                    return; 
+                }
+                const size_t n = strlen(s);
+                const size_t cap = sizeof(manufacturer) - 1;
+                const size_t tocopy = (n > cap) ? cap : n;
+                for (size_t i = 0; i < tocopy; ++i) {
+                    manufacturer[i] = s[i];
+                }
+                *(manufacturer + tocopy) = '\0';
+                cached = true;
+            }
 
-                        for (DWORD g = 0; g < ptr->Processor.GroupCount; ++g) {
-                            if (ptr->Processor.GroupMask[g].Group == target_group) {
-                                const KAFFINITY mask = ptr->Processor.GroupMask[g].Mask;
-                                for (DWORD bit = 0; bit < 64; ++bit) {
-                                    if (mask & (1ull << bit)) {
-                                        if (group_cpus[bit].LogicalId != 0xFFFFFFFFu) {
-                                            group_cpus[bit].CoreId = core_id;
-                                            group_cpus[bit].EfficiencyClass = efficiency;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        break;
-                    }
+            static VMAWARE_CONSTEXPR void store_model(const char* VMAWARE_RESTRICT s) noexcept {
+                if (!s) { 
+                    model[0] = '\0';
+                    return; 
+                }
+                const size_t n = strlen(s);
+                const size_t cap = sizeof(model) - 1;
+                const size_t tocopy = (n > cap) ? cap : n;
+                for (size_t i = 0; i < tocopy; ++i) {
+                    model[i] = s[i];
+                }
+                *(model + tocopy) = '\0';
+                cached = true;
+            }
 
-                    case RelationNumaNode: {
-                        const DWORD node_id = ptr->NumaNode.NodeNumber;
-                        if (ptr->NumaNode.GroupMask.Group == target_group) {
-                            const KAFFINITY mask = ptr->NumaNode.GroupMask.Mask;
-                            for (DWORD bit = 0; bit < 64; ++bit) {
-                                if (mask & (1ull << bit)) {
-                                    if (group_cpus[bit].LogicalId != 0xFFFFFFFFu) {
-                                        group_cpus[bit].NumaNode = node_id;
-                                    }
-                                }
-                            }
-                        }
-                        break;
-                    }
+            static bool is_cached() noexcept {
+                return cached; 
+            }
+        };
 
-                    case RelationCache: {
-                        const size_t expected_size = offsetof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, Cache.GroupMasks) + (ptr->Cache.GroupCount * sizeof(GROUP_AFFINITY));
-                        if (ptr->Size < expected_size) {
-                            return {};
-                        }
+    #if (LINUX)
+        /*
+         * Technique results kept on disk, so the next processes of the same boot pick them up
+         * instead of running the techniques again. Every user gets their own file, <dir>/results-<euid>,
+         * which only counts for the boot it was written in (/proc/sys/kernel/random/boot_id)
+         * and for builds with the same techniques and scores (fingerprint()). A file that's
+         * stale, malformed, not a regular file, owned by someone else or writable by anyone
+         * but its owner is ignored, and so is a directory others could swap it in. Updates are
+         * written to a temporary file renamed over the old one, so a reader never sees half of it.
+         *
+         * With VMAWARE_PERSISTENT_CACHE, the file in VMAWARE_PERSISTENT_CACHE_DIR (/run/vmaware
+         * by default) is loaded at startup and rewritten after any run that found something new.
+         */
+        struct disk_cache {
+            static constexpr u32 magic = 0x43414D56; /* "VMAC" */
+            static constexpr u32 format = 1;
+
+            struct record {
+                u8 cached;
+                u8 result;
+                u8 points;
+                u8 brand;
+            };
 
-                        const WORD group_count_cache = ptr->Cache.GroupCount;
-                        const DWORD cache_id = cache_count++;
+            struct file_header {
+                u32 magic;
+                u32 format;
+                u32 fingerprint;
+                u32 count;
+                char boot_id[40];
+            };
 
-                        for (WORD g = 0; g < group_count_cache; ++g) {
-                            /* Read and check all GroupMasks entries, supporting multi-group caches */
-                            const GROUP_AFFINITY& g_aff = ptr->Cache.GroupMasks[g];
-                            if (g_aff.Group == target_group) {
-                                const KAFFINITY mask = g_aff.Mask;
-                                for (DWORD bit = 0; bit < 64; ++bit) {
-                                    if (mask & (1ull << bit)) {
-                                        if (group_cpus[bit].LogicalId != 0xFFFFFFFFu) {
-                                            if (ptr->Cache.Level == 2) {
-                                                group_cpus[bit].L2CacheId = cache_id;
-                                            }
-                                            else if (ptr->Cache.Level == 3) {
-                                                group_cpus[bit].L3CacheId = cache_id;
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        break;
-                    }
+            struct file_image {
+                file_header header;
+                record records[enum_size + 1];
+            };
 
-                    default:
-                        break;
+            static std::mutex mutex;
+            static std::atomic<u32> saved; /* how many results the file is known to hold */
+
+            /* Only results that hold until the next reboot, the others have to run again in every process */
+            static bool persistable(const u16 id) noexcept {
+                return (id < technique_end) && (core::technique_table[id].volatility == core::PER_BOOT);
+            }
+
+            /* FNV-1a over the technique table, so a build with other techniques or scores won't trust the file */
+            static u32 fingerprint() noexcept {
+                u32 hash = 2166136261u;
+                auto mix = [&hash](const u32 value) noexcept {
+                    for (u32 shift = 0; shift < 32; shift += 8) {
+                        hash = (hash ^ ((value >> shift) & 0xFF)) * 16777619u;
                     }
+                };
 
-                    offset += ptr->Size;
+                mix(enum_size);
+                mix(MAX_BRANDS);
+                for (u16 id = 0; id <= enum_size; ++id) {
+                    const auto& tech = core::technique_table[id];
+                    mix(static_cast<u32>(tech.points) | (static_cast<u32>(tech.max_points) << 8) | (static_cast<u32>(tech.run != nullptr) << 16));
+                    mix(static_cast<u32>(tech.cost) | (static_cast<u32>(tech.volatility) << 16));
                 }
+                return hash;
+            }
 
-                /* Golden Rule 1: At least two physical cores must exist in the allowed process affinity */
-                bool seen_core[256]{};
-                DWORD physical_cores = 0;
+            static bool make_header(file_header& header) noexcept {
+                memset(&header, 0, sizeof(header));
+                header.magic = magic;
+                header.format = format;
+                header.fingerprint = fingerprint();
+                header.count = enum_size + 1;
 
-                for (DWORD i = 0; i < active_cpu_count; ++i) {
-                    const DWORD log = idxs[i];
-                    const DWORD core = group_cpus[log].CoreId;
-                    if (core == 0xFFFFFFFFu) {
-                        return {};
-                    }
-                    if (core < 256 && !seen_core[core]) {
-                        seen_core[core] = true;
-                        ++physical_cores;
-                    }
+                const int fd = ::open("/proc/sys/kernel/random/boot_id", O_RDONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    return false;
                 }
+                const ssize_t length = ::read(fd, header.boot_id, sizeof(header.boot_id) - 1);
+                ::close(fd);
 
-                if (physical_cores < 2) {
-                    return {};
+                if (length < 36) {
+                    return false;
                 }
+                /* a uuid and its trailing newline */
+                memset(header.boot_id + 36, 0, sizeof(header.boot_id) - 36);
+                return true;
+            }
 
-                /* Golden Rule 2: Counter thread always in the middle available physical CPU (or 2nd core if exactly 2) */
-                DWORD unique_cores[256]{};
-                DWORD unique_cores_count = 0;
-                DWORD core_to_logical[256]{};
+            /* Nobody but root and the current user may be able to replace files in it, unless it's sticky like /tmp */
+            static bool trusted_directory(const char* dir) noexcept {
+                struct stat info;
+                if (::lstat(dir, &info) != 0 || !S_ISDIR(info.st_mode)) {
+                    return false;
+                }
+                if (info.st_uid != 0 && info.st_uid != ::geteuid()) {
+                    return false;
+                }
+                return ((info.st_mode & (S_IWGRP | S_IWOTH)) == 0) || ((info.st_mode & S_ISVTX) != 0);
+            }
 
-                for (DWORD i = 0; i < active_cpu_count; ++i) {
-                    const DWORD log = idxs[i];
-                    const DWORD core = group_cpus[log].CoreId;
+            static bool file_path(const char* dir, char (&out)[PATH_MAX]) noexcept {
+                const int length = snprintf(out, sizeof(out), "%s/results-%u", dir, static_cast<unsigned>(::geteuid()));
+                return (length > 0) && (static_cast<size_t>(length) < sizeof(out));
+            }
 
-                    bool already_seen = false;
-                    for (DWORD c = 0; c < unique_cores_count; ++c) {
-                        if (unique_cores[c] == core) {
-                            already_seen = true;
-                            break;
-                        }
+            /* Map the file read-only and copy it out if it's ours and matches the expected header */
+            static bool read_image(const char* path, const file_header& expected, file_image& out) noexcept {
+                const int fd = ::open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+                if (fd < 0) {
+                    return false;
+                }
+
+                struct stat info;
+                bool valid = (::fstat(fd, &info) == 0) &&
+                    S_ISREG(info.st_mode) &&
+                    (info.st_uid == ::geteuid()) &&
+                    ((info.st_mode & (S_IWGRP | S_IWOTH)) == 0) &&
+                    (info.st_size == static_cast<off_t>(sizeof(file_image)));
+
+                if (valid) {
+                    void* view = ::mmap(nullptr, sizeof(file_image), PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (view == MAP_FAILED) {
+                        valid = false;
                     }
-                    if (!already_seen) {
-                        if (unique_cores_count < 64) {
-                            unique_cores[unique_cores_count] = core;
-                            core_to_logical[unique_cores_count] = log;
-                            unique_cores_count++;
-                        }
-                        else {
-                            break;
+                    else {
+                        valid = (memcmp(view, &expected, sizeof(expected)) == 0);
+                        if (valid) {
+                            memcpy(&out, view, sizeof(file_image));
                         }
+                        ::munmap(view, sizeof(file_image));
                     }
                 }
 
-                if (unique_cores_count < 2) {
-                    return {};
-                }
+                ::close(fd);
+                return valid;
+            }
 
-                const DWORD counter_pos0 = (unique_cores_count == 2) ? 1u : (unique_cores_count / 2u);
-                if (counter_pos0 >= unique_cores_count) {
-                    return {};
+            static u32 count_results(const file_image& image) noexcept {
+                u32 count = 0;
+                for (const record& r : image.records) {
+                    count += (r.cached != 0);
                 }
+                return count;
+            }
 
-                const DWORD counter_logical = core_to_logical[counter_pos0];
-                const auto& counter_cpu = group_cpus[counter_logical];
-
-                if (counter_cpu.CoreId == 0xFFFFFFFFu || counter_cpu.NumaNode == 0xFFFFFFFFu) {
-                    return {};
-                }
+            /* Put the results of the file in every technique slot that's still empty, and return how many were taken */
+            static u32 load(const char* dir) noexcept {
+                file_header header;
+                char path[PATH_MAX];
+                file_image image;
 
-                if (!measurement) {
-                    GROUP_AFFINITY aff{};
-                    aff.Group = target_group;
-                    aff.Mask = (1ull << counter_logical);
-                    return aff;
+                if (!make_header(header) || !trusted_directory(dir) || !file_path(dir, path) || !read_image(path, header, image)) {
+                    return 0;
                 }
 
-                /* Silver Rule 2: Find performance-dominant type within the process affinity subset */
-                BYTE max_efficiency = 0;
-                for (DWORD i = 0; i < active_cpu_count; ++i) {
-                    const DWORD logical = idxs[i];
-                    if (group_cpus[logical].EfficiencyClass > max_efficiency) {
-                        max_efficiency = group_cpus[logical].EfficiencyClass;
+                u32 taken = 0;
+                for (u16 id = 0; id <= enum_size; ++id) {
+                    const record& r = image.records[id];
+                    if (!r.cached || !persistable(id) || r.brand > static_cast<u8>(brand_enum::NULL_BRAND)) {
+                        continue;
+                    }
+                    if (try_claim(id)) {
+                        cache_store(id, r.result != 0, r.points, static_cast<brand_enum>(r.brand));
+                        ++taken;
                     }
                 }
 
-                auto is_edge = [&](DWORD logical) noexcept -> bool {
-                    return logical == idxs[0] || logical == idxs[active_cpu_count - 1];
-                };
-
-                DWORD best_logical = 0xFFFFFFFFu;
-                int best_score = (std::numeric_limits<int>::min)();
+                saved.store(count_results(image), std::memory_order_relaxed);
+                return taken;
+            }
 
-                for (DWORD i = 0; i < active_cpu_count; ++i) {
-                    const DWORD logical = idxs[i];
-                    if (logical == counter_logical) {
-                        continue;
-                    }
+            /* How many results this process could write out */
+            static u32 pending() noexcept {
+                u32 count = 0;
+                for (u16 id = 0; id <= enum_size; ++id) {
+                    count += (persistable(id) && is_cached(id));
+                }
+                return count;
+            }
 
-                    const auto& cand_cpu = group_cpus[logical];
+            /*
+             * Merge the results of this process into the file. Whatever another process added
+             * since this one loaded it is kept. Nothing is written while a recorded CPUID
+             * snapshot stands in for the CPU, those results aren't about this machine
+             */
+            static bool save(const char* dir) noexcept {
+                if (cpuid_snapshot::loaded.load(std::memory_order_acquire)) {
+                    return false;
+                }
 
-                    /* Silver Rule 1: SMT Sibling Isolation */
-                    if (cand_cpu.CoreId == counter_cpu.CoreId) {
-                        continue;
-                    }
+                file_header header;
+                char path[PATH_MAX];
+                char temporary[PATH_MAX + 32];
 
-                    int score = 0;
+                if (!make_header(header) || !file_path(dir, path)) {
+                    return false;
+                }
 
-                    /* Silver Rule 3: Same NUMA Node alignment */
-                    if (cand_cpu.NumaNode != 0xFFFFFFFFu && cand_cpu.NumaNode == counter_cpu.NumaNode) {
-                        score += 1000;
-                    }
+                std::lock_guard<std::mutex> lock(mutex);
 
-                    /* Silver Rule 3: Same L3 Cache Domain alignment */
-                    if (cand_cpu.L3CacheId != 0xFFFFFFFFu && cand_cpu.L3CacheId == counter_cpu.L3CacheId) {
-                        score += 500;
-                    }
+                if (::mkdir(dir, 0755) != 0 && errno != EEXIST) {
+                    return false;
+                }
+                if (!trusted_directory(dir)) {
+                    return false;
+                }
 
-                    /* Silver Rule 2: Performance Core (P-Core) Priority */
-                    if (cand_cpu.EfficiencyClass == max_efficiency) {
-                        score += 800;
-                    }
+                file_image image;
+                if (!read_image(path, header, image)) {
+                    memset(&image, 0, sizeof(image));
+                    image.header = header;
+                }
 
-                    /* Silver Rule 4: Shared L2 Cache Cluster Penalty (avoids shared E-core controllers) */
-                    if (cand_cpu.L2CacheId != 0xFFFFFFFFu && cand_cpu.L2CacheId == counter_cpu.L2CacheId) {
-                        score -= 800;
+                for (u16 id = 0; id <= enum_size; ++id) {
+                    const data_t data = cache_fetch(id);
+                    if (persistable(id) && data.cached) {
+                        image.records[id] = { 1, static_cast<u8>(data.result), data.points, static_cast<u8>(data.brand_name) };
                     }
+                }
 
-                    /* Silver Rule 5: Same Core Type alignment. The counter can actually be in a E-Core and the trigger in a P-Core safely, that's why I put a lower score */
-                    if (cand_cpu.EfficiencyClass == counter_cpu.EfficiencyClass) {
-                        score += 100;
-                    }
+                snprintf(temporary, sizeof(temporary), "%s.%d.tmp", path, static_cast<int>(::getpid()));
+                ::unlink(temporary);
 
-                    /* Silver Rule 6: Physical Proximity Penalty */
-                    const int dist = static_cast<int>(logical) - static_cast<int>(counter_logical);
-                    score -= std::abs(dist);
+                const int fd = ::open(temporary, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+                if (fd < 0) {
+                    return false;
+                }
 
-                    /* Silver Rule 7: Edge Core Protection */
-                    if (is_edge(logical)) {
-                        score -= 50;
+                const char* data = reinterpret_cast<const char*>(&image);
+                size_t written = 0;
+                while (written < sizeof(image)) {
+                    const ssize_t n = ::write(fd, data + written, sizeof(image) - written);
+                    if (n < 0 && errno == EINTR) {
+                        continue;
                     }
-
-                    if (score > best_score) {
-                        best_score = score;
-                        best_logical = logical;
+                    if (n <= 0) {
+                        break;
                     }
+                    written += static_cast<size_t>(n);
                 }
 
-                if (best_logical == 0xFFFFFFFFu) {
-                    return {};
+                const bool complete = (::close(fd) == 0) && (written == sizeof(image));
+                if (!complete || ::rename(temporary, path) != 0) {
+                    ::unlink(temporary);
+                    return false;
                 }
 
-                debug("TIMER: Measurement thread -> CPU ", best_logical, " | Counter thread -> CPU ", counter_logical);
+                saved.store(count_results(image), std::memory_order_relaxed);
+                return true;
+            }
 
-                GROUP_AFFINITY aff{};
-                aff.Group = target_group;
-                aff.Mask = (1ull << best_logical);
-                return aff;
+            /* Write the file only if this process has results it doesn't hold yet */
+            static void flush(const char* dir) noexcept {
+                if (pending() > saved.load(std::memory_order_relaxed)) {
+                    save(dir);
+                }
+            }
+
+        #if (VMAWARE_PERSISTENT_CACHE_SUPPORTED)
+            static const bool started;
+
+            static void flush_at_exit() noexcept {
+                flush(VMAWARE_PERSISTENT_CACHE_DIR);
+            }
+
+            static bool start() noexcept {
+                load(VMAWARE_PERSISTENT_CACHE_DIR);
+                std::atexit(flush_at_exit);
+                return true;
             }
+        #endif
         };
+    #endif
 
-        struct engine {
-                VMAWARE_SERIALIZE static VMAWARE_FORCE_INLINE void warmup_cpu(const bool serialize_available) noexcept {
-                /* Signal Intel Speed Shift / AMD CPPC to force maximum non-AVX Turbo/P-state frequency transition */
-                u64 val = 0x5a5a5a5a5a5a5a5aULL;
-                for (u32 i = 0; i < 2'000'000; ++i) {
-                    val = (val ^ i) * 6364136223846793005ULL + 1442695040888963407ULL;
-                }
-                volatile u64 compiler_sink = val;
-                VMAWARE_UNUSED(compiler_sink);
+    #if (WINDOWS)
+        struct module {
+            static HMODULE& fetch_ntdll() noexcept {
+                static HMODULE handle = nullptr;
+                return handle;
+            }
 
-                /* Warm up the decoded i-cache (DSB), BTB, and microcode sequencer */
-                if (serialize_available) {
-                    for (int i = 0; i < 5000; ++i) {
-                        _serialize();
-                        std::atomic_signal_fence(std::memory_order_seq_cst);
-                    }
-                }
-                else {
-                    for (int i = 0; i < 5000; ++i) {
-                        _mm_lfence();
-                        std::atomic_signal_fence(std::memory_order_seq_cst);
-                    }
-                }
+            static HMODULE& fetch_kernel32() noexcept {
+                static HMODULE handle = nullptr;
+                return handle;
             }
 
-            [[nodiscard]] static timer_tick_t calculate_latency(const std::vector<timer_tick_t>& samples_in) {
-                if (samples_in.empty()) {
-                    return 0;
-                }
-                const size_t N = samples_in.size();
-                if (N == 1) {
-                    return samples_in[0];
-                }
+            static void store(const HMODULE ntdll, const HMODULE kernel32) noexcept {
+                fetch_ntdll() = ntdll;
+                fetch_kernel32() = kernel32;
+                is_cached() = true;
+            }
 
-                /* Create a local copy to sort */
-                std::vector<timer_tick_t> s = samples_in;
-                std::sort(s.begin(), s.end());
+            static bool& is_cached() noexcept {
+                static bool cached = false;
+                return cached;
+            }
+        };
+    #endif
+    };
 
-                /* Discard the lower 25% and upper 25%, leaving the middle 50% */
-                const size_t low_idx = N / 4;
-                const size_t high_idx = (3 * N) / 4;
+#if (WINDOWS)
+    /* Timing attacks helper functionalities */
+    #if (x86)
+    struct timer {
+    #if (x86_64)
+        using timer_tick_t = u64;
+    #else
+        using timer_tick_t = u32;
+    #endif
 
-                double sum = 0;
-                size_t count = 0;
-                for (size_t i = low_idx; i < high_idx; ++i) {
-                    sum += s[i];
-                    count++;
-                }
+    #if (MSVC)
+        #pragma warning(push)
+        #pragma warning(disable: 4324) 
+    #endif
+        /* Align to prevent false sharing when triggering hypervisor exits with the intentional data race condition */
+        struct alignas(64) cache_state {
+            alignas(64) volatile timer_tick_t counter { 0 };
+            alignas(64) std::atomic<bool> start_test{ false };
+            alignas(64) std::atomic<bool> test_done{ false };
+        };
+    #if (MSVC)
+        #pragma warning(pop)
+    #endif
 
-                /* Fallback to the median if the dataset is too small */
-                if (count == 0) {
-                    return s[N / 2];
+        #define VMAWARE_STR2(x) #x
+        #define VMAWARE_STR(x) VMAWARE_STR2(x)
+
+        struct config {
+            [[nodiscard]] static VMAWARE_CONSTEXPR u32 get_seed() noexcept {
+                constexpr char s[] = __DATE__ " " __TIME__ " " __FILE__ " " VMAWARE_STR(__LINE__);
+                u32 h = 2166136261u;
+                for (char c : s) {
+                    if (!c) {
+                        break;
+                    }
+                    h ^= static_cast<unsigned char>(c);
+                    h *= 16777619u;
                 }
+                return h;
+            }
 
-                /* Compute the average of the middle 50% and round to the nearest integer */
-                return static_cast<timer_tick_t>((sum / count) + 0.5);
+            [[nodiscard]] static constexpr size_t clamp_c11(const size_t val, const size_t min_val, const size_t max_val) noexcept {
+                return (val < min_val) ? min_val : ((val > max_val) ? max_val : val);
             }
 
-            static VMAWARE_FORCE_INLINE void burn_random_cycles(const u32 ct_seed, const timer_tick_t v_post, const timer_tick_t r_post) noexcept {
+            [[nodiscard]] static size_t generate_batch_size(const u32 ct_seed) noexcept {
                 /*
-                 * The internal pseudo-random number generator (PRNG) variables like u64 seed and volatile u64 x can be kept as u64
-                 * because they are simple register-only PRNG arithmetic and benefit from the extra 64-bit entropy space even on 32-bit platforms
+                 * Important so that hypervisor can't predict how many samples we will collect
+                 * stack-only / ASLR-derived component (no APIs, no interceptable instructions by hypervisors)
                  */
-                u64 seed = ct_seed;
+                u64 seed = 0;
+                seed ^= static_cast<u64>(ct_seed);
+
+                u64 local1 = 0;
+                u64 local2 = 0;
+                u64 local3 = 0;
+
                 seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&seed));
-                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&v_post)) << 1;
-                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&r_post)) << 2;
+                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local1)) << 1;
+                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local2)) << 2;
+                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&local3)) << 3;
+
                 seed ^= seed >> 33;
                 seed *= 0xff51afd7ed558ccdULL;
                 seed ^= seed >> 33;
                 seed *= 0xc4ceb9fe1a85ec53ULL;
                 seed ^= seed >> 33;
 
-                /* 64u is the minimum amount of work every time, 0x1FFu controls how much the count varies */
-                const u32 rounds = 64u + static_cast<u32>(seed & 0x7FFu);
-                volatile u64 x = seed | 1ULL;
-
-                for (u32 i = 0; i < rounds; ++i) {
-                    x = x * 6364136223846793005ULL + 1ULL;
-                    x ^= x >> 17;
-                }
+                std::seed_seq seq{
+                    static_cast<u32>(seed),
+                    static_cast<u32>(seed >> 32),
+                    static_cast<u32>(seed ^ 0x9e3779b9u),
+                    ct_seed
+                };
 
-                std::atomic_signal_fence(std::memory_order_acq_rel);
+                std::mt19937 gen(seq);
+                return std::uniform_int_distribution<size_t>(500, 1000)(gen);
             }
         };
-    };
-    #endif
 
-    /* Memory related functions */
-    struct memory {
-        /* Uninstrumented indirect-call invokers */
-        VMAWARE_NO_CFG static void execute(const void* pointer) noexcept {
-            using func_t = void(*)();
-            reinterpret_cast<func_t>(const_cast<void*>(pointer))();
-        }
+        struct scheduler {
+            
+            /*
+             *  Golden Rules (must happen ALWAYS; if they don't happen the check should be aborted):
+             *  1. The check needs AT LEAST two different physical cores, so if one single core is detected, returns
+             *  2. The counter thread should always be in the middle available physical CPU when there's more than 2 cores, and in the core 2 (1-indexed) when there's 2 cores
+             *  3. The counter thread and the measurement thread can't never be in the same physical core. This means that SMT siblings should always be avoided.
+             *
+             *  Silver Rules (in order of priority):
+             *  1. Prioritize higher-performance pipelines (P-cores) over efficiency-oriented pipelines (E-cores) for the measurement thread (+800). P-cores feature private L2 caches (no cluster controller congestion).
+             *  2. Prioritize candidates within the same NUMA node (+1000) and same L3 cache slice/CCD domain (+500) to ensure minimal latency (preventing cross-CCD Infinity Fabric or cross-socket routing delays).
+             *  3. Deduct points (-800) for candidate cores that share an L2 cache with the counter thread but reside on different physical cores (targeting and resolving Intel E-core cluster L2 controller bottlenecks).
+             *  4. Prioritize cores with matching efficiency classes (+100) to align power and frequency (DVFS) domains.
+             *  5. Apply a minor index-distance penalty to select the closest physical neighbor on the silicon layout/ring bus stop (best-effort only because logical indexing does not always prove physical proximity).
+             *  6. Penalize edge logical cores (-50) because those are where most OS interrupt and background DPC scheduler noise occur.
+            */
+            [[nodiscard]] static GROUP_AFFINITY get_mask(const bool measurement) {
+                const HANDLE current_process = reinterpret_cast<HANDLE>(-1LL);
+                const HANDLE current_thread = reinterpret_cast<HANDLE>(-2LL);
 
-        VMAWARE_NO_CFG static void execute(const void* pointer, void* frame, uintptr_t stack32_ptr, u64* saved_rsp) noexcept {
-            using func_t = void(*)(void*, uintptr_t, u64*);
-            reinterpret_cast<func_t>(const_cast<void*>(pointer))(frame, stack32_ptr, saved_rsp);
-        }
+                GROUP_AFFINITY active_group_aff{};
+                DWORD_PTR proc_mask = 0, sys_mask = 0;
+
+                /* Base our available CPU pool on the process-wide affinity mask instead of the thread's currently restricted affinity mask. Threads are frequently restricted to a single core by runtime schedulers or thread-pools, while the process retains access to all cores. */
+                if (GetProcessAffinityMask(current_process, &proc_mask, &sys_mask) && proc_mask) {
+                    active_group_aff.Mask = proc_mask;
+
+                    /* Query the executing thread's current group to ensure both threads run on the same processor group/physical socket to avoid severe interconnect latency */
+                    GROUP_AFFINITY thread_aff{};
+                    if (GetThreadGroupAffinity(current_thread, &thread_aff)) {
+                        active_group_aff.Group = thread_aff.Group;
+                    }
+                    else {
+                        active_group_aff.Group = 0;
+                    }
+                }
+                else {
+                    return {};
+                }
+
+                const WORD target_group = active_group_aff.Group;
+                const KAFFINITY target_mask = active_group_aff.Mask;
+
+                DWORD len = 0;
+                SetLastError(ERROR_SUCCESS);
+                GetLogicalProcessorInformationEx(RelationAll, nullptr, &len);
+                if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || !len) {
+                    return {};
+                }
+
+                std::vector<BYTE> topo(len);
+                if (!GetLogicalProcessorInformationEx(
+                    RelationAll,
+                    reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(topo.data()),
+                    &len)) {
+                    return {};
+                }
+
+                struct GroupCpu {
+                    DWORD LogicalId = 0xFFFFFFFFu; /* 0..63 within target group */
+                    DWORD CoreId = 0xFFFFFFFFu;
+                    DWORD NumaNode = 0xFFFFFFFFu;
+                    DWORD L2CacheId = 0xFFFFFFFFu;
+                    DWORD L3CacheId = 0xFFFFFFFFu;
+                    BYTE EfficiencyClass = 0;
+                };
+
+                GroupCpu group_cpus[64]{};
+                DWORD active_cpu_count = 0;
+                DWORD idxs[64]{};
+
+                for (DWORD i = 0; i < 64; ++i) {
+                    if (target_mask & (1ull << i)) {
+                        group_cpus[i].LogicalId = i;
+                        idxs[active_cpu_count++] = i;
+                    }
+                }
+
+                if (active_cpu_count < 2) {
+                    return {};
+                }
+
+                DWORD core_count = 0;
+                DWORD cache_count = 0;
+                size_t offset = 0;
+
+                while (offset + sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) <= len) {
+                    auto* ptr = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(topo.data() + offset);
+
+                    constexpr size_t base_header_size = sizeof(LOGICAL_PROCESSOR_RELATIONSHIP) + sizeof(DWORD);
+                    if (ptr->Size < base_header_size || offset + ptr->Size > len) {
+                        return {};
+                    }
+
+                    switch (ptr->Relationship) {
+                    case RelationProcessorCore: {
+                        const size_t expected_size = offsetof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, Processor.GroupMask) + (ptr->Processor.GroupCount * sizeof(GROUP_AFFINITY));
+                        if (ptr->Size < expected_size) {
+                            return {};
+                        }
+
+                        const DWORD core_id = core_count++;
+                        const BYTE efficiency = ptr->Processor.EfficiencyClass;
+
+                        for (DWORD g = 0; g < ptr->Processor.GroupCount; ++g) {
+                            if (ptr->Processor.GroupMask[g].Group == target_group) {
+                                const KAFFINITY mask = ptr->Processor.GroupMask[g].Mask;
+                                for (DWORD bit = 0; bit < 64; ++bit) {
+                                    if (mask & (1ull << bit)) {
+                                        if (group_cpus[bit].LogicalId != 0xFFFFFFFFu) {
+                                            group_cpus[bit].CoreId = core_id;
+                                            group_cpus[bit].EfficiencyClass = efficiency;
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                        break;
+                    }
+
+                    case RelationNumaNode: {
+                        const DWORD node_id = ptr->NumaNode.NodeNumber;
+                        if (ptr->NumaNode.GroupMask.Group == target_group) {
+                            const KAFFINITY mask = ptr->NumaNode.GroupMask.Mask;
+                            for (DWORD bit = 0; bit < 64; ++bit) {
+                                if (mask & (1ull << bit)) {
+                                    if (group_cpus[bit].LogicalId != 0xFFFFFFFFu) {
+                                        group_cpus[bit].NumaNode = node_id;
+                                    }
+                                }
+                            }
+                        }
+                        break;
+                    }
+
+                    case RelationCache: {
+                        const size_t expected_size = offsetof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX, Cache.GroupMasks) + (ptr->Cache.GroupCount * sizeof(GROUP_AFFINITY));
+                        if (ptr->Size < expected_size) {
+                            return {};
+                        }
+
+                        const WORD group_count_cache = ptr->Cache.GroupCount;
+                        const DWORD cache_id = cache_count++;
+
+                        for (WORD g = 0; g < group_count_cache; ++g) {
+                            /* Read and check all GroupMasks entries, supporting multi-group caches */
+                            const GROUP_AFFINITY& g_aff = ptr->Cache.GroupMasks[g];
+                            if (g_aff.Group == target_group) {
+                                const KAFFINITY mask = g_aff.Mask;
+                                for (DWORD bit = 0; bit < 64; ++bit) {
+                                    if (mask & (1ull << bit)) {
+                                        if (group_cpus[bit].LogicalId != 0xFFFFFFFFu) {
+                                            if (ptr->Cache.Level == 2) {
+                                                group_cpus[bit].L2CacheId = cache_id;
+                                            }
+                                            else if (ptr->Cache.Level == 3) {
+                                                group_cpus[bit].L3CacheId = cache_id;
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                        break;
+                    }
+
+                    default:
+                        break;
+                    }
+
+                    offset += ptr->Size;
+                }
+
+                /* Golden Rule 1: At least two physical cores must exist in the allowed process affinity */
+                bool seen_core[256]{};
+                DWORD physical_cores = 0;
+
+                for (DWORD i = 0; i < active_cpu_count; ++i) {
+                    const DWORD log = idxs[i];
+                    const DWORD core = group_cpus[log].CoreId;
+                    if (core == 0xFFFFFFFFu) {
+                        return {};
+                    }
+                    if (core < 256 && !seen_core[core]) {
+                        seen_core[core] = true;
+                        ++physical_cores;
+                    }
+                }
+
+                if (physical_cores < 2) {
+                    return {};
+                }
+
+                /* Golden Rule 2: Counter thread always in the middle available physical CPU (or 2nd core if exactly 2) */
+                DWORD unique_cores[256]{};
+                DWORD unique_cores_count = 0;
+                DWORD core_to_logical[256]{};
+
+                for (DWORD i = 0; i < active_cpu_count; ++i) {
+                    const DWORD log = idxs[i];
+                    const DWORD core = group_cpus[log].CoreId;
+
+                    bool already_seen = false;
+                    for (DWORD c = 0; c < unique_cores_count; ++c) {
+                        if (unique_cores[c] == core) {
+                            already_seen = true;
+                            break;
+                        }
+                    }
+                    if (!already_seen) {
+                        if (unique_cores_count < 64) {
+                            unique_cores[unique_cores_count] = core;
+                            core_to_logical[unique_cores_count] = log;
+                            unique_cores_count++;
+                        }
+                        else {
+                            break;
+                        }
+                    }
+                }
+
+                if (unique_cores_count < 2) {
+                    return {};
+                }
+
+                const DWORD counter_pos0 = (unique_cores_count == 2) ? 1u : (unique_cores_count / 2u);
+                if (counter_pos0 >= unique_cores_count) {
+                    return {};
+                }
+
+                const DWORD counter_logical = core_to_logical[counter_pos0];
+                const auto& counter_cpu = group_cpus[counter_logical];
+
+                if (counter_cpu.CoreId == 0xFFFFFFFFu || counter_cpu.NumaNode == 0xFFFFFFFFu) {
+                    return {};
+                }
+
+                if (!measurement) {
+                    GROUP_AFFINITY aff{};
+                    aff.Group = target_group;
+                    aff.Mask = (1ull << counter_logical);
+                    return aff;
+                }
+
+                /* Silver Rule 2: Find performance-dominant type within the process affinity subset */
+                BYTE max_efficiency = 0;
+                for (DWORD i = 0; i < active_cpu_count; ++i) {
+                    const DWORD logical = idxs[i];
+                    if (group_cpus[logical].EfficiencyClass > max_efficiency) {
+                        max_efficiency = group_cpus[logical].EfficiencyClass;
+                    }
+                }
+
+                auto is_edge = [&](DWORD logical) noexcept -> bool {
+                    return logical == idxs[0] || logical == idxs[active_cpu_count - 1];
+                };
+
+                DWORD best_logical = 0xFFFFFFFFu;
+                int best_score = (std::numeric_limits<int>::min)();
+
+                for (DWORD i = 0; i < active_cpu_count; ++i) {
+                    const DWORD logical = idxs[i];
+                    if (logical == counter_logical) {
+                        continue;
+                    }
+
+                    const auto& cand_cpu = group_cpus[logical];
+
+                    /* Silver Rule 1: SMT Sibling Isolation */
+                    if (cand_cpu.CoreId == counter_cpu.CoreId) {
+                        continue;
+                    }
+
+                    int score = 0;
+
+                    /* Silver Rule 3: Same NUMA Node alignment */
+                    if (cand_cpu.NumaNode != 0xFFFFFFFFu && cand_cpu.NumaNode == counter_cpu.NumaNode) {
+                        score += 1000;
+                    }
+
+                    /* Silver Rule 3: Same L3 Cache Domain alignment */
+                    if (cand_cpu.L3CacheId != 0xFFFFFFFFu && cand_cpu.L3CacheId == counter_cpu.L3CacheId) {
+                        score += 500;
+                    }
+
+                    /* Silver Rule 2: Performance Core (P-Core) Priority */
+                    if (cand_cpu.EfficiencyClass == max_efficiency) {
+                        score += 800;
+                    }
+
+                    /* Silver Rule 4: Shared L2 Cache Cluster Penalty (avoids shared E-core controllers) */
+                    if (cand_cpu.L2CacheId != 0xFFFFFFFFu && cand_cpu.L2CacheId == counter_cpu.L2CacheId) {
+                        score -= 800;
+                    }
+
+                    /* Silver Rule 5: Same Core Type alignment. The counter can actually be in a E-Core and the trigger in a P-Core safely, that's why I put a lower score */
+                    if (cand_cpu.EfficiencyClass == counter_cpu.EfficiencyClass) {
+                        score += 100;
+                    }
+
+                    /* Silver Rule 6: Physical Proximity Penalty */
+                    const int dist = static_cast<int>(logical) - static_cast<int>(counter_logical);
+                    score -= std::abs(dist);
+
+                    /* Silver Rule 7: Edge Core Protection */
+                    if (is_edge(logical)) {
+                        score -= 50;
+                    }
+
+                    if (score > best_score) {
+                        best_score = score;
+                        best_logical = logical;
+                    }
+                }
+
+                if (best_logical == 0xFFFFFFFFu) {
+                    return {};
+                }
+
+                debug("TIMER: Measurement thread -> CPU ", best_logical, " | Counter thread -> CPU ", counter_logical);
+
+                GROUP_AFFINITY aff{};
+                aff.Group = target_group;
+                aff.Mask = (1ull << best_logical);
+                return aff;
+            }
+        };
+
+        struct engine {
+                VMAWARE_SERIALIZE static VMAWARE_FORCE_INLINE void warmup_cpu(const bool serialize_available) noexcept {
+                /* Signal Intel Speed Shift / AMD CPPC to force maximum non-AVX Turbo/P-state frequency transition */
+                u64 val = 0x5a5a5a5a5a5a5a5aULL;
+                for (u32 i = 0; i < 2'000'000; ++i) {
+                    val = (val ^ i) * 6364136223846793005ULL + 1442695040888963407ULL;
+                }
+                volatile u64 compiler_sink = val;
+                VMAWARE_UNUSED(compiler_sink);
+
+                /* Warm up the decoded i-cache (DSB), BTB, and microcode sequencer */
+                if (serialize_available) {
+                    for (int i = 0; i < 5000; ++i) {
+                        _serialize();
+                        std::atomic_signal_fence(std::memory_order_seq_cst);
+                    }
+                }
+                else {
+                    for (int i = 0; i < 5000; ++i) {
+                        _mm_lfence();
+                        std::atomic_signal_fence(std::memory_order_seq_cst);
+                    }
+                }
+            }
+
+            [[nodiscard]] static timer_tick_t calculate_latency(const std::vector<timer_tick_t>& samples_in) {
+                if (samples_in.empty()) {
+                    return 0;
+                }
+                const size_t N = samples_in.size();
+                if (N == 1) {
+                    return samples_in[0];
+                }
+
+                /* Create a local copy to sort */
+                std::vector<timer_tick_t> s = samples_in;
+                std::sort(s.begin(), s.end());
+
+                /* Discard the lower 25% and upper 25%, leaving the middle 50% */
+                const size_t low_idx = N / 4;
+                const size_t high_idx = (3 * N) / 4;
+
+                double sum = 0;
+                size_t count = 0;
+                for (size_t i = low_idx; i < high_idx; ++i) {
+                    sum += s[i];
+                    count++;
+                }
+
+                /* Fallback to the median if the dataset is too small */
+                if (count == 0) {
+                    return s[N / 2];
+                }
+
+                /* Compute the average of the middle 50% and round to the nearest integer */
+                return static_cast<timer_tick_t>((sum / count) + 0.5);
+            }
+
+            static VMAWARE_FORCE_INLINE void burn_random_cycles(const u32 ct_seed, const timer_tick_t v_post, const timer_tick_t r_post) noexcept {
+                /*
+                 * The internal pseudo-random number generator (PRNG) variables like u64 seed and volatile u64 x can be kept as u64
+                 * because they are simple register-only PRNG arithmetic and benefit from the extra 64-bit entropy space even on 32-bit platforms
+                 */
+                u64 seed = ct_seed;
+                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&seed));
+                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&v_post)) << 1;
+                seed ^= static_cast<u64>(reinterpret_cast<std::uintptr_t>(&r_post)) << 2;
+                seed ^= seed >> 33;
+                seed *= 0xff51afd7ed558ccdULL;
+                seed ^= seed >> 33;
+                seed *= 0xc4ceb9fe1a85ec53ULL;
+                seed ^= seed >> 33;
+
+                /* 64u is the minimum amount of work every time, 0x1FFu controls how much the count varies */
+                const u32 rounds = 64u + static_cast<u32>(seed & 0x7FFu);
+                volatile u64 x = seed | 1ULL;
+
+                for (u32 i = 0; i < rounds; ++i) {
+                    x = x * 6364136223846793005ULL + 1ULL;
+                    x ^= x >> 17;
+                }
+
+                std::atomic_signal_fence(std::memory_order_acq_rel);
+            }
+        };
+    };
+    #endif
+
+    /* Memory related functions */
+    struct memory {
+        /* Uninstrumented indirect-call invokers */
+        VMAWARE_NO_CFG static void execute(const void* pointer) noexcept {
+            using func_t = void(*)();
+            reinterpret_cast<func_t>(const_cast<void*>(pointer))();
+        }
+
+        VMAWARE_NO_CFG static void execute(const void* pointer, void* frame, uintptr_t stack32_ptr, u64* saved_rsp) noexcept {
+            using func_t = void(*)(void*, uintptr_t, u64*);
+            reinterpret_cast<func_t>(const_cast<void*>(pointer))(frame, stack32_ptr, saved_rsp);
+        }
 
         VMAWARE_NO_CFG static void execute(const void* pointer, void* vmcall_info, void* vmcall_result) noexcept {
             using func_t = void(*)(void*, void*);
             reinterpret_cast<func_t>(const_cast<void*>(pointer))(vmcall_info, vmcall_result);
         }
 
-        inline static DWORD execute_handler(const void* pointer) noexcept {
-            DWORD exception_status = 0;
-            __try {
-                execute(pointer);
+        inline static DWORD execute_handler(const void* pointer) noexcept {
+            DWORD exception_status = 0;
+            __try {
+                execute(pointer);
+            }
+            __except (exception_status = GetExceptionCode(), EXCEPTION_EXECUTE_HANDLER) {}
+            return exception_status;
+        };
+
+        /* Retrieves the addresses of specified functions from a loaded module using the export directory, manual implementation of GetProcAddress without PE export forwarding parsing */
+        static void get_function(const HMODULE module, const char* const VMAWARE_RESTRICT names[], void** const VMAWARE_RESTRICT functions, const size_t count, const bool cache_result = true) {
+            VMAWARE_ASSUME(names != nullptr);
+            VMAWARE_ASSUME(functions != nullptr);
+            using func_map = std::unordered_map<std::string, void*>;
+            static std::unordered_map<HMODULE, func_map> function_cache;
+
+            for (size_t i = 0; i < count; ++i) functions[i] = nullptr;
+            if (!module) {
+                return;
+            }
+
+            BYTE* base = reinterpret_cast<BYTE*>(module);
+
+            size_t module_size = 0;
+            {
+                MEMORY_BASIC_INFORMATION mbi = {};
+                if (VirtualQuery(base, &mbi, sizeof(mbi))) {
+                    module_size = static_cast<size_t>(mbi.RegionSize);
+                }
+                else {
+                    return;
+                }
+            }
+
+            auto valid_range = [&](size_t offset, size_t sz) noexcept -> bool {
+                return (sz > 0) && (offset < module_size) && (sz <= module_size - offset);
+            };
+
+            auto cstr_from_rva = [&](DWORD rva) noexcept -> const char* {
+                if (!valid_range(static_cast<size_t>(rva), 1)) {
+                    return nullptr;
+                }
+
+                const char* start = reinterpret_cast<const char*>(base + rva);
+                const size_t remaining = module_size - static_cast<size_t>(rva);
+
+                if (std::memchr(start, '\0', remaining)) {
+                    return start;
+                }
+
+                return nullptr;
+            };
+
+            /* Validate DOS header */
+            if (VMAWARE_UNLIKELY(!valid_range(0, sizeof(IMAGE_DOS_HEADER)))) {
+                return;
+            }
+            const auto* dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+            if (VMAWARE_UNLIKELY(dosHeader->e_magic != IMAGE_DOS_SIGNATURE)) {
+                return;
+            }
+
+            /* e_lfanew -> NT headers */
+            if (VMAWARE_UNLIKELY(dosHeader->e_lfanew < 0)) {
+                return;
+            }
+            const size_t e_lfanew = static_cast<size_t>(dosHeader->e_lfanew);
+            if (VMAWARE_UNLIKELY(!valid_range(e_lfanew, sizeof(IMAGE_NT_HEADERS)))) {
+                return;
+            }
+            const auto* ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + e_lfanew);
+            if (VMAWARE_UNLIKELY(ntHeaders->Signature != IMAGE_NT_SIGNATURE)) {
+                return;
+            }
+
+            const size_t sizeOfImage = static_cast<size_t>(ntHeaders->OptionalHeader.SizeOfImage);
+            if (sizeOfImage != 0 && sizeOfImage > module_size) {
+                module_size = sizeOfImage;
+            }
+
+            /* Check export data directory exists */
+            if (ntHeaders->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_EXPORT) {
+                return;
+            }
+
+            const auto& dd = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+            if (dd.VirtualAddress == 0 || dd.Size == 0) {
+                return;
+            }
+
+            /* Validate export directory fits */
+            if (!valid_range(static_cast<size_t>(dd.VirtualAddress), sizeof(IMAGE_EXPORT_DIRECTORY))) {
+                return;
+            }
+
+            const auto* exportDir = reinterpret_cast<const IMAGE_EXPORT_DIRECTORY*>(base + dd.VirtualAddress);
+
+            const DWORD nameCount = exportDir->NumberOfNames;
+            const DWORD funcCount = exportDir->NumberOfFunctions;
+
+            constexpr DWORD MAX_NAMES = 1u << 20;
+            if (nameCount == 0 || nameCount > MAX_NAMES) {
+                return;
+            }
+            if (funcCount == 0 || funcCount > MAX_NAMES) {
+                return;
+            }
+
+            const DWORD addr_names = exportDir->AddressOfNames;
+            const DWORD addr_funcs = exportDir->AddressOfFunctions;
+            const DWORD addr_ord = exportDir->AddressOfNameOrdinals;
+
+            if (!valid_range(static_cast<size_t>(addr_names), static_cast<size_t>(nameCount) * sizeof(DWORD))) {
+                return;
+            }
+            if (!valid_range(static_cast<size_t>(addr_funcs), static_cast<size_t>(funcCount) * sizeof(DWORD))) {
+                return;
+            }
+            if (!valid_range(static_cast<size_t>(addr_ord), static_cast<size_t>(nameCount) * sizeof(WORD))) {
+                return;
+            }
+
+            const DWORD* nameRvas = reinterpret_cast<const DWORD*>(base + addr_names);
+            const DWORD* funcRvas = reinterpret_cast<const DWORD*>(base + addr_funcs);
+            const WORD* ordinals = reinterpret_cast<const WORD*>(base + addr_ord);
+
+            for (size_t i = 0; i < count; ++i) {
+                const char* current_name = names[i];
+                if (!current_name) {
+                    continue;
+                }
+                const std::string s_name(current_name);
+
+                /* Only query and populate the cache if it's not a dynamically loaded module with LoadLibraryEx */
+                if (cache_result) {
+                    func_map& module_cache = function_cache[module];
+                    const auto cache_it = module_cache.find(s_name);
+                    if (VMAWARE_LIKELY(cache_it != module_cache.end())) {
+                        functions[i] = cache_it->second;
+                        continue;
+                    }
+                }
+
+                /* Binary search over names */
+                DWORD lo = 0, hi = nameCount;
+                while (lo < hi) {
+                    const DWORD mid = lo + (hi - lo) / 2;
+                    const DWORD midNameRva = nameRvas[mid];
+                    const char* midName = cstr_from_rva(midNameRva);
+                    if (!midName) {
+                        lo = hi;
+                        break;
+                    }
+
+                    const int cmp = strcmp(current_name, midName);
+                    if (cmp > 0) {
+                        lo = mid + 1;
+                    }
+                    else {
+                        hi = mid;
+                    }
+                }
+
+                if (lo < nameCount) {
+                    const char* candidateName = cstr_from_rva(nameRvas[lo]);
+                    if (candidateName && strcmp(current_name, candidateName) == 0) {
+                        const WORD nameOrdinal = ordinals[lo];
+                        if (static_cast<DWORD>(nameOrdinal) >= funcCount) {
+                            continue;
+                        }
+                        const DWORD funcRva = funcRvas[nameOrdinal];
+                        if (!valid_range(static_cast<size_t>(funcRva), 1)) {
+                            continue;
+                        }
+                        void* addr = reinterpret_cast<void*>(base + funcRva);
+                        functions[i] = addr;
+
+                        if (cache_result) {
+                            function_cache[module][s_name] = addr;
+                        }
+                        continue;
+                    }
+                }
+            }
+        }
+
+        [[nodiscard]] static HMODULE get_module(const bool get_ntdll) noexcept {
+            struct custom_unicode_string {
+                unsigned short length;
+                unsigned short max_length;
+                wchar_t* buffer;
+            };
+
+            struct custom_ldr_entry {
+                void* reserved1[2];
+                LIST_ENTRY in_memory_links;
+                void* reserved2[2];
+                void* dll_base;
+                void* reserved3[2];
+                custom_unicode_string full_name;
+                custom_unicode_string base_name;
+            };
+
+            struct custom_peb {
+                unsigned char reserved1[2];
+                unsigned char being_debugged;
+                unsigned char reserved2[1];
+                void* mutant;
+                void* image_base_address;
+                struct {
+                    unsigned char reserved3[8];
+                    void* reserved4[3];
+                    LIST_ENTRY in_memory_list;
+                }*ldr;
+            };
+
+            if (memo::module::is_cached()) {
+                return get_ntdll ? memo::module::fetch_ntdll() : memo::module::fetch_kernel32();
+            }
+
+            custom_peb* peb = nullptr;
+
+        #if (x86_64)
+            #if (MSVC && !CLANG)
+                peb = reinterpret_cast<custom_peb*>(__readgsqword(0x60));
+            #else
+                asm("movq %%gs:0x60, %0" : "=r"(peb));
+            #endif
+        #elif (x86_32)
+            #if (MSVC && !CLANG)
+                peb = reinterpret_cast<custom_peb*>(__readfsdword(0x30));
+            #else
+                asm("movl %%fs:0x30, %0" : "=r"(peb));
+            #endif
+        #endif
+
+            if (!peb || !peb->ldr) {
+                return GetModuleHandleW(get_ntdll ? L"ntdll.dll" : L"kernel32.dll");
+            }
+
+            auto matches = [](const wchar_t* s1, const wchar_t* s2, const unsigned short len) noexcept -> bool {
+                for (unsigned short i = 0; i < len; ++i) {
+                    if ((s1[i] | 0x20) != (s2[i] | 0x20)) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            HMODULE res_ntdll = nullptr;
+            HMODULE res_k32 = nullptr;
+
+            LIST_ENTRY* head = &peb->ldr->in_memory_list;
+            for (LIST_ENTRY* cur = head->Flink; cur != nullptr && cur != head; cur = cur->Flink) {
+                auto* ent = reinterpret_cast<custom_ldr_entry*>(reinterpret_cast<char*>(cur) - (sizeof(void*) * 2));
+                if (!ent || !ent->base_name.buffer || ent->base_name.length == 0) {
+                    continue;
+                }
+
+                const unsigned short len_chars = ent->base_name.length / sizeof(wchar_t);
+                const wchar_t* buf = ent->base_name.buffer;
+
+                if ((len_chars == 9 && matches(buf, L"ntdll.dll", 9)) || (len_chars == 5 && matches(buf, L"ntdll", 5))) {
+                    res_ntdll = reinterpret_cast<HMODULE>(ent->dll_base);
+                }
+                else if ((len_chars == 12 && matches(buf, L"kernel32.dll", 12)) || (len_chars == 8 && matches(buf, L"kernel32", 8))) {
+                    res_k32 = reinterpret_cast<HMODULE>(ent->dll_base);
+                }
+
+                if (res_ntdll && res_k32) {
+                    break;
+                }
+            }
+
+            if (res_ntdll || res_k32) {
+                memo::module::store(res_ntdll, res_k32);
+            }
+
+            if (get_ntdll) {
+                return res_ntdll ? res_ntdll : GetModuleHandleW(L"ntdll.dll");
+            }
+            return res_k32 ? res_k32 : GetModuleHandleW(L"kernel32.dll");
+        }
+    };
+#endif
+
+    /* String utilities */
+    struct string {
+        /* Converts a single character to lowercase */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR char to_lower(char c) noexcept {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+        }
+
+        /* Converts a single character to uppercase */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR char to_upper(char c) noexcept {
+            return (c >= 'a' && c <= 'z') ? static_cast<char>(c & 0xDF) : c;
+        }
+
+        /* Checks if a string starts with a specific prefix (case-sensitive) */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 bool starts_with(const char* str, const char* prefix) noexcept {
+            if (!str || !prefix) {
+                return false;
+            }
+            while (*prefix) {
+                if (*str++ != *prefix++) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /* Finds a substring inside a null-terminated string (case-sensitive) */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 const char* find(const char* haystack, const char* needle) noexcept {
+            if (!haystack || !needle) {
+                return nullptr;
+            }
+            if (!*needle) {
+                return haystack;
+            }
+            for (; *haystack; ++haystack) {
+                if (*haystack == *needle) {
+                    const char* h = haystack;
+                    const char* n = needle;
+                    while (*h && *n && *h == *n) {
+                        h++;
+                        n++;
+                    }
+                    if (!*n) {
+                        return haystack;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        /* Finds a substring inside a null-terminated string (case-insensitive) */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 const char* find_ci(const char* haystack, const char* needle) noexcept {
+            if (!haystack || !needle) {
+                return nullptr;
+            }
+            if (!*needle) {
+                return haystack;
+            }
+            const char n0_lower = to_lower(*needle);
+            for (; *haystack; ++haystack) {
+                if (to_lower(*haystack) == n0_lower) {
+                    const char* h = haystack;
+                    const char* n = needle;
+                    while (*h && *n && to_lower(*h) == to_lower(*n)) {
+                        h++;
+                        n++;
+                    }
+                    if (!*n) {
+                        return haystack;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        /* Checks if a std::string contains a substring (case-sensitive) */
+        static VMAWARE_FORCE_INLINE bool contains(const std::string& base_str, const char* keyword) noexcept {
+            return base_str.find(keyword) != std::string::npos;
+        }
+
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 bool contains_ci(const char* haystack, const char* needle) noexcept {
+            if (!haystack || !needle) {
+                return false;
+            }
+            if (!*needle) {
+                return true;
+            }
+            const char n0_lower = to_lower(*needle);
+            for (; *haystack; ++haystack) {
+                if (to_lower(*haystack) == n0_lower) {
+                    const char* h = haystack;
+                    const char* n = needle;
+                    while (*h && *n && to_lower(*h) == to_lower(*n)) {
+                        h++;
+                        n++;
+                    }
+                    if (!*n) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        /* Compares two null-terminated strings for equality (case-insensitive) */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 bool equals_ci(const char* s1, const char* s2) noexcept {
+            if (!s1 || !s2) {
+                return s1 == s2;
+            }
+            while (*s1 && *s2) {
+                if (to_lower(*s1) != to_lower(*s2)) {
+                    return false;
+                }
+                s1++;
+                s2++;
+            }
+            return *s1 == *s2;
+        }
+
+        /* Converts a std::string to lowercase in place */
+        static VMAWARE_FORCE_INLINE void to_lower_inplace(std::string& str) noexcept {
+            const size_t len = str.length();
+            for (size_t i = 0; i < len; ++i) {
+                str[i] = to_lower(str[i]);
+            }
+        }
+
+        /* Trims leading and trailing whitespaces from a std::string in place */
+        static VMAWARE_FORCE_INLINE void trim_inplace(std::string& s) noexcept {
+            while (!s.empty() && is_space(s.front())) {
+                s.erase(s.begin());
+            }
+            while (!s.empty() && is_space(s.back())) {
+                s.pop_back();
+            }
+        }
+
+        /* Trims leading whitespaces from a null-terminated string pointer */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 const char* ltrim(const char* str) noexcept {
+            if (!str) {
+                return nullptr;
             }
-            __except (exception_status = GetExceptionCode(), EXCEPTION_EXECUTE_HANDLER) {}
-            return exception_status;
+            while (*str && is_space(*str)) {
+                str++;
+            }
+            return str;
+        }
+
+        /* Checks if a std::string consists only of numerical digits */
+        static VMAWARE_FORCE_INLINE bool is_numeric(const std::string& s) noexcept {
+            if (s.empty()) {
+                return false;
+            }
+            const size_t len = s.length();
+            for (size_t i = 0; i < len; ++i) {
+                if (!is_digit(s[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /* Helper to check for ASCII spaces (avoids locale overhead) */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR bool is_space(char c) noexcept {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+        }
+
+        /* Helper to check for ASCII digits */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR bool is_digit(char c) noexcept {
+            return c >= '0' && c <= '9';
+        }
+
+        /* Helper to check for hexadecimal characters */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR bool is_hex(char c) noexcept {
+            return (c >= '0' && c <= '9') || (to_lower(c) >= 'a' && to_lower(c) <= 'f');
+        }
+
+        /* Helper to check if a character is alphanumeric */
+        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR bool is_alnum(char c) noexcept {
+            return (to_lower(c) >= 'a' && to_lower(c) <= 'z') || is_digit(c);
+        }
+    };
+
+    /* Miscellaneous functionalities */
+    struct util {
+        [[nodiscard]] static constexpr bool is_unsupported(const VM::enum_flags flag) noexcept {
+            return (flag >= VM::HYPERVISOR_BIT && flag <= VM::KGT_SIGNATURE) ? false :
+            #if (LINUX)
+                !(flag >= LINUX_START && flag <= LINUX_END);
+            #elif (WINDOWS)
+                !(flag >= WINDOWS_START && flag <= WINDOWS_END);
+            #elif (APPLE) 
+                !(flag >= MACOS_START && flag <= MACOS_END);
+            #else
+                false;
+            #endif
+        }
+
+    #if (LINUX)
+        /*
+         * Read a whole file into a caller-provided buffer, null-terminated, with one open()
+         * and as many read() calls as the kernel needs to hand it over. Returns how many bytes
+         * were read, or -1 if the file couldn't be opened. Anything past the buffer is left out,
+         * which is fine for the small sysfs and procfs attributes this is meant for. There's no
+         * exists() check beforehand, since a failed open() already says the same thing.
+         * During a run, the file comes from memo::file_cache if another technique read it already.
+         */
+        static ssize_t read_into(const char* path, char* buffer, const size_t capacity) {
+            VMAWARE_ASSUME(path != nullptr);
+            if (buffer == nullptr || capacity == 0) {
+                return -1;
+            }
+
+            buffer[0] = '\0';
+
+            const bool cached = memo::file_cache::active();
+
+            if (cached) {
+                i64 length = -1;
+                if (memo::file_cache::fetch_content(path, buffer, capacity, length)) {
+                    return static_cast<ssize_t>(length);
+                }
+            }
+
+            const int fd = open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                if (cached) {
+                    memo::file_cache::store_content(path, "", 0, false, 1);
+                }
+                return -1;
+            }
+
+            size_t total = 0;
+            u32 syscalls = 2; /* open() and close() */
+            bool eof = false;
+
+            while (total < capacity - 1) {
+                const ssize_t n = read(fd, buffer + total, capacity - 1 - total);
+                ++syscalls;
+
+                if (n > 0) {
+                    total += static_cast<size_t>(n);
+                }
+                else if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                else {
+                    eof = (n == 0);
+                    break;
+                }
+            }
+
+            close(fd);
+            buffer[total] = '\0';
+
+            /* Only a file that fit whole is cached, a later reader might want more of it than this buffer holds */
+            if (cached && eof) {
+                memo::file_cache::store_content(path, buffer, total, true, syscalls);
+            }
+
+            return static_cast<ssize_t>(total);
+        }
+
+        /* Read the whole file into data, counting the syscalls it took. Returns false if it couldn't be opened */
+        static bool load_file(const char* path, std::string& data, u32& syscalls) {
+            data.clear();
+            syscalls = 1;
+
+            const int fd = open(path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return false;
+            }
+
+            /* Most of these files are small, so they arrive in one read() and one allocation */
+            char chunk[4096];
+
+            while (true) {
+                const ssize_t n = read(fd, chunk, sizeof(chunk));
+                ++syscalls;
+
+                if (n > 0) {
+                    data.append(chunk, static_cast<size_t>(n));
+                }
+                else if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                else {
+                    break;
+                }
+            }
+
+            close(fd);
+            ++syscalls;
+            return true;
+        }
+
+        /* The file exactly as it is, binary or not, shared through memo::file_cache during a run. Returns false if it couldn't be opened */
+        static bool read_bytes(const char* path, std::string& data) {
+            bool opened = false;
+            if (memo::file_cache::active() && memo::file_cache::fetch_content(path, data, opened)) {
+                return opened;
+            }
+
+            u32 syscalls = 0;
+            opened = load_file(path, data, syscalls);
+            memo::file_cache::store_content(path, data, opened, syscalls);
+            return opened;
+        }
+
+        /* Fetch file data, for files that can outgrow a stack buffer like /proc/cpuinfo */
+        [[nodiscard]] static std::string read_file(const char* raw_path) {
+            VMAWARE_ASSUME(raw_path != nullptr);
+            std::string path;
+
+            /* Replace the "~" part with the home directory */
+            if (raw_path[0] == '~') {
+                const char* home = std::getenv("HOME");
+                if (home) {
+                    path = std::string(home) + (raw_path + 1);
+                }
+            } else {
+                path = raw_path;
+            }
+
+            std::string data{};
+            read_bytes(path.c_str(), data);
+
+            /* Every line used to come back newline-terminated, the last one included */
+            if (!data.empty() && data.back() != '\n') {
+                data += '\n';
+            }
+
+            return data;
+        }
+
+        [[nodiscard]] static bool exists(const char* path) {
+            bool result = false;
+            if (memo::file_cache::active() && memo::file_cache::fetch_exists(path, result)) {
+                return result;
+            }
+
+        #if (VMAWARE_CPP >= 17)
+            result = std::filesystem::exists(path);
+        #elif (VMAWARE_CPP >= 11)
+            struct stat buffer;
+            result = (stat(path, &buffer) == 0);
+        #endif
+
+            memo::file_cache::store_exists(path, result);
+            return result;
+        }
+
+        [[nodiscard]] static bool is_directory(const char* path) {
+            VMAWARE_ASSUME(path != nullptr);
+            struct stat info{};
+            if (stat(path, &info) != 0) {
+                return false;
+            }
+            return (info.st_mode & S_IFDIR); /* check if directory */
+        }
+    #endif
+
+        /* Fetch the file but in binary form */
+        [[nodiscard]] static std::vector<u8> read_file_binary(const char* file_path) {
+            VMAWARE_ASSUME(file_path != nullptr);
+        #if (LINUX)
+            std::vector<u8> buffer;
+
+            const int fd = open(file_path, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return buffer;
+            }
+
+            /* sysfs reports a made-up size (or none), so it's only a hint for the first read */
+            struct stat info{};
+            const size_t hint = (fstat(fd, &info) == 0 && info.st_size > 0) ? static_cast<size_t>(info.st_size) : 4096;
+            buffer.resize(hint);
+
+            size_t total = 0;
+
+            while (true) {
+                if (total == buffer.size()) {
+                    buffer.resize(buffer.size() * 2);
+                }
+
+                const ssize_t n = read(fd, buffer.data() + total, buffer.size() - total);
+
+                if (n > 0) {
+                    total += static_cast<size_t>(n);
+                }
+                else if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                else {
+                    break;
+                }
+            }
+
+            close(fd);
+            buffer.resize(total);
+            return buffer;
+        #else
+            std::ifstream file(file_path, std::ios::binary);
+
+            if (!file) {
+                return {};
+            }
+
+            return std::vector<u8>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        #endif
+        }
+
+    #if (LINUX)
+        /*
+         * Files the Linux techniques look at. The techniques and prefetch_files() both take
+         * their paths from here, so what gets prefetched can't drift apart from what the
+         * techniques actually read
+         */
+        struct file_paths {
+            static constexpr const char* dmi_table = "/sys/firmware/dmi/tables/DMI";
+            static constexpr const char* smbios_entry_point = "/sys/firmware/dmi/tables/smbios_entry_point";
+            static constexpr const char* bios_raw = "/sys/firmware/dmi/entries/0-0/raw";
+            static constexpr const char* bios_vendor = "/sys/devices/virtual/dmi/id/bios_vendor";
+            static constexpr const char* bios_version = "/sys/devices/virtual/dmi/id/bios_version";
+            static constexpr const char* sys_vendor = "/sys/devices/virtual/dmi/id/sys_vendor";
+            static constexpr const char* product_name = "/sys/devices/virtual/dmi/id/product_name";
+            static constexpr const char* product_sku = "/sys/devices/virtual/dmi/id/product_sku";
+            static constexpr const char* product_family = "/sys/devices/virtual/dmi/id/product_family";
+            static constexpr const char* board_vendor = "/sys/devices/virtual/dmi/id/board_vendor";
+            static constexpr const char* board_name = "/sys/devices/virtual/dmi/id/board_name";
+            static constexpr const char* chassis_vendor = "/sys/devices/virtual/dmi/id/chassis_vendor";
+            static constexpr const char* chassis_asset_tag = "/sys/devices/virtual/dmi/id/chassis_asset_tag";
+            static constexpr const char* chassis_type = "/sys/devices/virtual/dmi/id/chassis_type";
+            static constexpr const char* modalias = "/sys/devices/virtual/dmi/id/modalias";
+            static constexpr const char* smt_control = "/sys/devices/system/cpu/smt/control";
+            static constexpr const char* smt_active = "/sys/devices/system/cpu/smt/active";
+            static constexpr const char* thread_siblings = "/sys/devices/system/cpu/cpu0/topology/thread_siblings_list";
+            static constexpr const char* hypervisor_type = "/sys/hypervisor/type";
+            static constexpr const char* cpuinfo = "/proc/cpuinfo";
+            static constexpr const char* modules = "/proc/modules";
+            static constexpr const char* sysinfo = "/proc/sysinfo";
+            static constexpr const char* osrelease = "/proc/sys/kernel/osrelease";
+            static constexpr const char* version = "/proc/version";
+            static constexpr const char* self_status = "/proc/self/status";
+            static constexpr const char* self_cgroup = "/proc/self/cgroup";
+            static constexpr const char* init_environ = "/proc/1/environ";
+            static constexpr const char* proc_bc = "/proc/bc";
+            static constexpr const char* proc_vz = "/proc/vz";
+            static constexpr const char* proc_xen = "/proc/xen";
+            static constexpr const char* dt_fw_cfg = "/proc/device-tree/fw-cfg";
+            static constexpr const char* dt_hypervisor = "/proc/device-tree/hypervisor/compatible";
+            static constexpr const char* qemu_fw_cfg_module = "/sys/module/qemu_fw_cfg/";
+            static constexpr const char* qemu_fw_cfg_firmware = "/sys/firmware/qemu_fw_cfg/";
+            static constexpr const char* container_manager = "/run/host/container-manager";
+            static constexpr const char* systemd_container = "/run/systemd/container";
+            static constexpr const char* containerenv = "/run/.containerenv";
+            static constexpr const char* dockerenv = "/.dockerenv";
+            static constexpr const char* dockerinit = "/.dockerinit";
+            static constexpr const char* hwmon = "/sys/class/hwmon/";
+            static constexpr const char* bluestacks_mnt = "/mnt/windows/BstSharedFolder";
+            static constexpr const char* bluestacks_sdcard = "/sdcard/windows/BstSharedFolder";
+            static constexpr const char* cooling_device = "/sys/class/thermal/cooling_device0";
+            static constexpr const char* thermal_zone = "/sys/class/thermal/thermal_zone0/";
         };
+    #endif
 
-        /* Retrieves the addresses of specified functions from a loaded module using the export directory, manual implementation of GetProcAddress without PE export forwarding parsing */
-        static void get_function(const HMODULE module, const char* const VMAWARE_RESTRICT names[], void** const VMAWARE_RESTRICT functions, const size_t count, const bool cache_result = true) {
-            VMAWARE_ASSUME(names != nullptr);
-            VMAWARE_ASSUME(functions != nullptr);
-            using func_map = std::unordered_map<std::string, void*>;
-            static std::unordered_map<HMODULE, func_map> function_cache;
+    #if (LINUX)
+        /*
+         * The SMBIOS records the Linux DMI techniques look at. They're parsed once per process
+         * from the raw structure table in /sys/firmware/dmi/tables/DMI, which only root can read.
+         * Otherwise they're filled from the /sys/devices/virtual/dmi/id attributes the kernel
+         * decoded from that same table, and the BIOS characteristics from entries/0-0/raw.
+         * Neither changes until the next boot.
+         */
+        struct smbios {
+            /* Type 0 */
+            struct bios_record {
+                std::string vendor;
+                std::string version;
+                bool has_vm_bit = false;
+                bool vm_bit = false; /* BIOS characteristics extension byte 2, bit 4 */
+            };
+
+            /* Type 1 */
+            struct system_record {
+                std::string manufacturer;
+                std::string product;
+                std::string sku;
+                std::string family;
+            };
+
+            /* Type 2 */
+            struct board_record {
+                std::string manufacturer;
+                std::string product;
+            };
+
+            /* Type 3 */
+            struct chassis_record {
+                std::string manufacturer;
+                std::string asset_tag;
+                bool has_type = false;
+                u8 type = 0;
+            };
+
+            bios_record bios;
+            system_record system;
+            board_record board;
+            chassis_record chassis;
+            bool from_table = false; /* whether this came from the raw table rather than the sysfs attributes */
+
+            static const smbios& get() {
+                static const smbios table = load();
+                return table;
+            }
+
+            /*
+             * Walk a raw SMBIOS structure table and fill in the first record of each type.
+             * Each structure is a formatted area (type, length, handle, then the fields) followed
+             * by its strings, which end with a double null. Returns whether any record was found.
+             */
+            static bool parse(const u8* data, const size_t size, smbios& out) {
+                bool found = false;
+                bool seen[4] = { false, false, false, false };
+                size_t offset = 0;
+
+                while (offset + 4 <= size) {
+                    const u8 type = data[offset];
+                    const u8 length = data[offset + 1];
+
+                    if (length < 4 || offset + length > size) {
+                        break;
+                    }
+
+                    /* The strings of this structure run until the double null */
+                    size_t end = offset + length;
+                    while (end + 1 < size && !(data[end] == 0 && data[end + 1] == 0)) {
+                        ++end;
+                    }
+                    if (end + 1 >= size) {
+                        break;
+                    }
+
+                    const u8* const formatted = data + offset;
+                    const char* const strings = reinterpret_cast<const char*>(data + offset + length);
+                    const char* const strings_end = reinterpret_cast<const char*>(data + end);
+
+                    /* Strings are numbered from 1 in the order they follow the formatted area, 0 means none */
+                    const auto string_at = [&](const u8 field) -> std::string {
+                        if (field >= length || formatted[field] == 0) {
+                            return std::string();
+                        }
+                        const char* s = strings;
+                        for (u8 i = 1; i < formatted[field] && s < strings_end; ++i) {
+                            s += std::strlen(s) + 1;
+                        }
+                        return (s < strings_end) ? std::string(s) : std::string();
+                    };
+
+                    if (type < 4 && !seen[type]) {
+                        seen[type] = true;
+                        found = true;
+
+                        switch (type) {
+                            case 0:
+                                out.bios.vendor = string_at(0x04);
+                                out.bios.version = string_at(0x05);
+                                if (length > 0x13) {
+                                    out.bios.has_vm_bit = true;
+                                    out.bios.vm_bit = (formatted[0x13] & (1 << 4));
+                                }
+                                break;
+                            case 1:
+                                out.system.manufacturer = string_at(0x04);
+                                out.system.product = string_at(0x05);
+                                out.system.sku = string_at(0x19);
+                                out.system.family = string_at(0x1A);
+                                break;
+                            case 2:
+                                out.board.manufacturer = string_at(0x04);
+                                out.board.product = string_at(0x05);
+                                break;
+                            default:
+                                out.chassis.manufacturer = string_at(0x04);
+                                out.chassis.asset_tag = string_at(0x08);
+                                if (length > 0x05) {
+                                    out.chassis.has_type = true;
+                                    out.chassis.type = (formatted[0x05] & 0x7F); /* bit 7 is the chassis lock */
+                                }
+                                break;
+                        }
+                    }
 
-            for (size_t i = 0; i < count; ++i) functions[i] = nullptr;
-            if (!module) {
-                return;
+                    /* End-of-table */
+                    if (type == 127) {
+                        break;
+                    }
+
+                    offset = end + 2;
+                }
+
+                return found;
             }
 
-            BYTE* base = reinterpret_cast<BYTE*>(module);
+            /* How long the structure table is according to the entry point, or 0 if it can't tell */
+            static size_t table_length(const std::string& entry_point) noexcept {
+                const u8* const e = reinterpret_cast<const u8*>(entry_point.data());
 
-            size_t module_size = 0;
-            {
-                MEMORY_BASIC_INFORMATION mbi = {};
-                if (VirtualQuery(base, &mbi, sizeof(mbi))) {
-                    module_size = static_cast<size_t>(mbi.RegionSize);
+                /* SMBIOS 3.x, "_SM3_" with a 32-bit maximum table size at 0x0C */
+                if (entry_point.size() >= 0x10 && entry_point.compare(0, 5, "_SM3_") == 0) {
+                    return static_cast<size_t>(e[0x0C]) | (static_cast<size_t>(e[0x0D]) << 8) |
+                        (static_cast<size_t>(e[0x0E]) << 16) | (static_cast<size_t>(e[0x0F]) << 24);
                 }
-                else {
-                    return;
+
+                /* SMBIOS 2.x, "_SM_" with a 16-bit table length at 0x16 */
+                if (entry_point.size() >= 0x18 && entry_point.compare(0, 4, "_SM_") == 0) {
+                    return static_cast<size_t>(e[0x16]) | (static_cast<size_t>(e[0x17]) << 8);
                 }
+
+                return 0;
             }
 
-            auto valid_range = [&](size_t offset, size_t sz) noexcept -> bool {
-                return (sz > 0) && (offset < module_size) && (sz <= module_size - offset);
-            };
+            static smbios load() {
+                smbios out;
+                std::string table;
+                std::string entry_point;
 
-            auto cstr_from_rva = [&](DWORD rva) noexcept -> const char* {
-                if (!valid_range(static_cast<size_t>(rva), 1)) {
-                    return nullptr;
+                if (read_bytes(file_paths::dmi_table, table) && !table.empty()) {
+                    size_t size = table.size();
+
+                    if (read_bytes(file_paths::smbios_entry_point, entry_point)) {
+                        const size_t length = table_length(entry_point);
+                        if (length != 0 && length < size) {
+                            size = length;
+                        }
+                    }
+
+                    out.from_table = parse(reinterpret_cast<const u8*>(table.data()), size, out);
                 }
 
-                const char* start = reinterpret_cast<const char*>(base + rva);
-                const size_t remaining = module_size - static_cast<size_t>(rva);
+                if (out.from_table) {
+                    return out;
+                }
 
-                if (std::memchr(start, '\0', remaining)) {
-                    return start;
+                out = smbios();
+
+                const auto attribute = [](const char* path) -> std::string {
+                    char buffer[256];
+                    ssize_t length = read_into(path, buffer, sizeof(buffer));
+                    while (length > 0 && string::is_space(buffer[length - 1])) {
+                        --length;
+                    }
+                    return (length > 0) ? std::string(buffer, static_cast<size_t>(length)) : std::string();
+                };
+
+                out.bios.vendor = attribute(file_paths::bios_vendor);
+                out.bios.version = attribute(file_paths::bios_version);
+                out.system.manufacturer = attribute(file_paths::sys_vendor);
+                out.system.product = attribute(file_paths::product_name);
+                out.system.sku = attribute(file_paths::product_sku);
+                out.system.family = attribute(file_paths::product_family);
+                out.board.manufacturer = attribute(file_paths::board_vendor);
+                out.board.product = attribute(file_paths::board_name);
+                out.chassis.manufacturer = attribute(file_paths::chassis_vendor);
+                out.chassis.asset_tag = attribute(file_paths::chassis_asset_tag);
+
+                const std::string type = attribute(file_paths::chassis_type);
+                if (!type.empty()) {
+                    char* end = nullptr;
+                    const long value = std::strtol(type.c_str(), &end, 10);
+                    if (end != type.c_str()) {
+                        out.chassis.has_type = true;
+                        out.chassis.type = static_cast<u8>(value);
+                    }
                 }
 
-                return nullptr;
-            };
+                /* Only the start of the BIOS information structure is needed */
+                char raw[64];
+                const ssize_t length = read_into(file_paths::bios_raw, raw, sizeof(raw));
+                if (length > 0x13 && static_cast<u8>(raw[1]) > 0x13) {
+                    out.bios.has_vm_bit = true;
+                    out.bios.vm_bit = (static_cast<u8>(raw[0x13]) & (1 << 4));
+                }
 
-            /* Validate DOS header */
-            if (VMAWARE_UNLIKELY(!valid_range(0, sizeof(IMAGE_DOS_HEADER)))) {
-                return;
-            }
-            const auto* dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
-            if (VMAWARE_UNLIKELY(dosHeader->e_magic != IMAGE_DOS_SIGNATURE)) {
-                return;
+                return out;
             }
+        };
+    #endif
 
-            /* e_lfanew -> NT headers */
-            if (VMAWARE_UNLIKELY(dosHeader->e_lfanew < 0)) {
-                return;
-            }
-            const size_t e_lfanew = static_cast<size_t>(dosHeader->e_lfanew);
-            if (VMAWARE_UNLIKELY(!valid_range(e_lfanew, sizeof(IMAGE_NT_HEADERS)))) {
-                return;
-            }
-            const auto* ntHeaders = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + e_lfanew);
-            if (VMAWARE_UNLIKELY(ntHeaders->Signature != IMAGE_NT_SIGNATURE)) {
-                return;
-            }
+    #if (LINUX)
+        /*
+         * One pass over the kernel log for the DMESG and KMSG techniques. /dev/kmsg is drained
+         * with non-blocking reads, one record per read(), until EAGAIN says there's nothing left,
+         * so there's never any waiting. If it can't be opened, the syslog buffer is read with
+         * klogctl() instead. Every record goes through the matcher as it arrives, and nothing is
+         * kept afterwards. The log only changes after boot in ways that don't matter here, so
+         * it's scanned once per process.
+         */
+        struct kernel_log {
+            bool readable = false;            /* whether any log source could be read */
+            bool hypervisor_detected = false; /* "Hypervisor detected" */
+            bool kvm = false;                 /* a line with both "hypervisor" and "kvm" in any case */
+            bool qemu = false;                /* a line with both "hypervisor" and "qemu" in any case */
+
+            static const kernel_log& get() {
+                static const kernel_log log = load();
+                return log;
+            }
+
+            /* Match one line against every pattern in a single pass over it */
+            void scan(const char* line, const size_t length) noexcept {
+                const auto at = [&](const size_t i, const char* pattern, const bool ignore_case) noexcept {
+                    size_t j = 0;
+                    for (; pattern[j] != '\0'; ++j) {
+                        if (i + j >= length) {
+                            return false;
+                        }
+                        const char c = ignore_case ? string::to_lower(line[i + j]) : line[i + j];
+                        if (c != pattern[j]) {
+                            return false;
+                        }
+                    }
+                    return true;
+                };
 
-            const size_t sizeOfImage = static_cast<size_t>(ntHeaders->OptionalHeader.SizeOfImage);
-            if (sizeOfImage != 0 && sizeOfImage > module_size) {
-                module_size = sizeOfImage;
-            }
+                bool hypervisor = false;
+                bool has_kvm = false;
+                bool has_qemu = false;
+
+                for (size_t i = 0; i < length; ++i) {
+                    switch (string::to_lower(line[i])) {
+                        case 'h':
+                            if (at(i, "hypervisor", true)) {
+                                hypervisor = true;
+                                if (at(i, "Hypervisor detected", false)) {
+                                    hypervisor_detected = true;
+                                }
+                            }
+                            break;
+                        case 'k':
+                            has_kvm = has_kvm || at(i, "kvm", true);
+                            break;
+                        case 'q':
+                            has_qemu = has_qemu || at(i, "qemu", true);
+                            break;
+                        default:
+                            break;
+                    }
+                }
 
-            /* Check export data directory exists */
-            if (ntHeaders->OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_EXPORT) {
-                return;
+                if (hypervisor) {
+                    kvm = kvm || has_kvm;
+                    qemu = qemu || has_qemu;
+                }
             }
 
-            const auto& dd = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
-            if (dd.VirtualAddress == 0 || dd.Size == 0) {
-                return;
+            /* Feed a buffer of newline-separated lines to scan() */
+            void scan_lines(const char* text, const size_t length) noexcept {
+                size_t start = 0;
+                for (size_t i = 0; i <= length; ++i) {
+                    if (i == length || text[i] == '\n') {
+                        if (i > start) {
+                            scan(text + start, i - start);
+                        }
+                        start = i + 1;
+                    }
+                }
             }
 
-            /* Validate export directory fits */
-            if (!valid_range(static_cast<size_t>(dd.VirtualAddress), sizeof(IMAGE_EXPORT_DIRECTORY))) {
-                return;
-            }
+            static kernel_log load() {
+                kernel_log log;
 
-            const auto* exportDir = reinterpret_cast<const IMAGE_EXPORT_DIRECTORY*>(base + dd.VirtualAddress);
+                const int fd = open("/dev/kmsg", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
 
-            const DWORD nameCount = exportDir->NumberOfNames;
-            const DWORD funcCount = exportDir->NumberOfFunctions;
+                if (fd >= 0) {
+                    /* A record is "priority,sequence,timestamp,flags;message\n" plus optional " KEY=value" lines */
+                    char record[8192];
 
-            constexpr DWORD MAX_NAMES = 1u << 20;
-            if (nameCount == 0 || nameCount > MAX_NAMES) {
-                return;
-            }
-            if (funcCount == 0 || funcCount > MAX_NAMES) {
-                return;
-            }
+                    while (true) {
+                        const ssize_t n = read(fd, record, sizeof(record));
 
-            const DWORD addr_names = exportDir->AddressOfNames;
-            const DWORD addr_funcs = exportDir->AddressOfFunctions;
-            const DWORD addr_ord = exportDir->AddressOfNameOrdinals;
+                        if (n > 0) {
+                            log.readable = true;
+                            const char* message = static_cast<const char*>(std::memchr(record, ';', static_cast<size_t>(n)));
+                            if (message) {
+                                ++message;
+                                const char* end = static_cast<const char*>(std::memchr(message, '\n', static_cast<size_t>(record + n - message)));
+                                log.scan(message, static_cast<size_t>((end ? end : record + n) - message));
+                            }
+                        }
+                        /* EPIPE means the record was overwritten while reading, and the next one is still there */
+                        else if (n < 0 && (errno == EINTR || errno == EPIPE)) {
+                            continue;
+                        }
+                        else {
+                            break; /* EAGAIN once drained, or an error */
+                        }
+                    }
 
-            if (!valid_range(static_cast<size_t>(addr_names), static_cast<size_t>(nameCount) * sizeof(DWORD))) {
-                return;
-            }
-            if (!valid_range(static_cast<size_t>(addr_funcs), static_cast<size_t>(funcCount) * sizeof(DWORD))) {
-                return;
-            }
-            if (!valid_range(static_cast<size_t>(addr_ord), static_cast<size_t>(nameCount) * sizeof(WORD))) {
-                return;
+                    close(fd);
+
+                    if (log.readable) {
+                        return log;
+                    }
+                }
+
+                constexpr int SYSLOG_ACTION_READ_ALL = 3;
+                constexpr int SYSLOG_ACTION_SIZE_BUFFER = 10;
+
+                const int size = klogctl(SYSLOG_ACTION_SIZE_BUFFER, nullptr, 0);
+                if (size <= 0) {
+                    debug("KERNEL_LOG: ", "neither /dev/kmsg nor klogctl() are readable");
+                    return log;
+                }
+
+                std::vector<char> buffer(static_cast<size_t>(size));
+                const int length = klogctl(SYSLOG_ACTION_READ_ALL, buffer.data(), size);
+
+                if (length > 0) {
+                    log.readable = true;
+                    log.scan_lines(buffer.data(), static_cast<size_t>(length));
+                }
+
+                return log;
             }
+        };
+    #endif
 
-            const DWORD* nameRvas = reinterpret_cast<const DWORD*>(base + addr_names);
-            const DWORD* funcRvas = reinterpret_cast<const DWORD*>(base + addr_funcs);
-            const WORD* ordinals = reinterpret_cast<const WORD*>(base + addr_ord);
+    #if (LINUX)
+        /*
+         * What systemd-detect-virt would print, worked out in-process from the same sources it
+         * reads, so nothing needs to be spawned. Containers are looked for first, then VMs, in
+         * the same order as systemd's detect_container() and detect_vm(). The answer is one of
+         * systemd's identifiers ("kvm", "oracle", "docker", "none"...), computed once per process.
+         */
+        struct virt_id {
+            /* Everything the classification looks at, so it can be fed recorded inputs */
+            struct sources {
+                bool proc_vz = false;
+                bool proc_bc = false;
+                std::string osrelease;
+                std::string container;        /* the container= value, or the /run/systemd/container id */
+                bool container_known = false; /* whether the container manager could be asked at all */
+                bool containerenv = false;    /* /run/.containerenv */
+                bool dockerenv = false;       /* /.dockerenv */
+
+                std::string dmi[4];           /* product_name, sys_vendor, board_vendor, bios_vendor */
+                bool smbios_vm_bit = false;
+                bool uml = false;
+                bool proc_xen = false;
+                bool hypervisor_bit = false;
+                std::string cpuid_vendor;     /* leaf 0x40000000 */
+                std::string sysinfo;          /* /proc/sysinfo on s390x */
+            };
 
-            for (size_t i = 0; i < count; ++i) {
-                const char* current_name = names[i];
-                if (!current_name) {
-                    continue;
+            static const char* get() {
+                static const char* id = classify(gather());
+                return id;
+            }
+
+            static const char* container_id(const sources& s) {
+                if (s.proc_vz && !s.proc_bc) {
+                    return "openvz";
                 }
-                const std::string s_name(current_name);
 
-                /* Only query and populate the cache if it's not a dynamically loaded module with LoadLibraryEx */
-                if (cache_result) {
-                    func_map& module_cache = function_cache[module];
-                    const auto cache_it = module_cache.find(s_name);
-                    if (VMAWARE_LIKELY(cache_it != module_cache.end())) {
-                        functions[i] = cache_it->second;
-                        continue;
-                    }
+                if (s.osrelease.find("Microsoft") != std::string::npos || s.osrelease.find("WSL") != std::string::npos) {
+                    return "wsl";
                 }
 
-                /* Binary search over names */
-                DWORD lo = 0, hi = nameCount;
-                while (lo < hi) {
-                    const DWORD mid = lo + (hi - lo) / 2;
-                    const DWORD midNameRva = nameRvas[mid];
-                    const char* midName = cstr_from_rva(midNameRva);
-                    if (!midName) {
-                        lo = hi;
-                        break;
+                if (s.container_known) {
+                    if (s.container.empty()) {
+                        return "none";
                     }
 
-                    const int cmp = strcmp(current_name, midName);
-                    if (cmp > 0) {
-                        lo = mid + 1;
+                    static constexpr const char* known[] = {
+                        "lxc", "lxc-libvirt", "systemd-nspawn", "docker", "podman", "rkt", "wsl", "proot", "pouch"
+                    };
+
+                    for (const char* id : known) {
+                        if (s.container == id) {
+                            return id;
+                        }
                     }
-                    else {
-                        hi = mid;
+
+                    /* "oci" isn't a container manager, so the well-known files get a say before giving up */
+                    if (s.container != "oci") {
+                        return "container-other";
                     }
                 }
 
-                if (lo < nameCount) {
-                    const char* candidateName = cstr_from_rva(nameRvas[lo]);
-                    if (candidateName && strcmp(current_name, candidateName) == 0) {
-                        const WORD nameOrdinal = ordinals[lo];
-                        if (static_cast<DWORD>(nameOrdinal) >= funcCount) {
-                            continue;
-                        }
-                        const DWORD funcRva = funcRvas[nameOrdinal];
-                        if (!valid_range(static_cast<size_t>(funcRva), 1)) {
-                            continue;
-                        }
-                        void* addr = reinterpret_cast<void*>(base + funcRva);
-                        functions[i] = addr;
+                if (s.containerenv) {
+                    return "podman";
+                }
 
-                        if (cache_result) {
-                            function_cache[module][s_name] = addr;
+                if (s.dockerenv) {
+                    return "docker";
+                }
+
+                return s.container_known ? "container-other" : "none";
+            }
+
+            static const char* dmi_id(const sources& s) {
+                static constexpr std::array<std::pair<const char*, const char*>, 17> vendors{ {
+                    { "KVM", "kvm" },
+                    { "OpenStack", "kvm" },
+                    { "KubeVirt", "kvm" },
+                    { "Amazon EC2", "amazon" },
+                    { "QEMU", "qemu" },
+                    { "VMware", "vmware" },
+                    { "VMW", "vmware" },
+                    { "innotek GmbH", "oracle" },
+                    { "VirtualBox", "oracle" },
+                    { "Oracle Corporation", "oracle" },
+                    { "Xen", "xen" },
+                    { "Bochs", "bochs" },
+                    { "Parallels", "parallels" },
+                    { "BHYVE", "bhyve" },
+                    { "Hyper-V", "microsoft" },
+                    { "Apple Virtualization", "apple" },
+                    { "Google Compute Engine", "google" }
+                } };
+
+                for (const std::string& value : s.dmi) {
+                    for (const auto& vendor : vendors) {
+                        if (value.compare(0, std::strlen(vendor.first), vendor.first) == 0) {
+                            return vendor.second;
                         }
-                        continue;
                     }
                 }
+
+                return s.smbios_vm_bit ? "vm-other" : "none";
             }
-        }
 
-        [[nodiscard]] static HMODULE get_module(const bool get_ntdll) noexcept {
-            struct custom_unicode_string {
-                unsigned short length;
-                unsigned short max_length;
-                wchar_t* buffer;
-            };
+            static const char* cpuid_id(const sources& s) {
+                if (!s.hypervisor_bit) {
+                    return "none";
+                }
 
-            struct custom_ldr_entry {
-                void* reserved1[2];
-                LIST_ENTRY in_memory_links;
-                void* reserved2[2];
-                void* dll_base;
-                void* reserved3[2];
-                custom_unicode_string full_name;
-                custom_unicode_string base_name;
-            };
+                static constexpr std::array<std::pair<const char*, const char*>, 11> vendors{ {
+                    { "XenVMMXenVMM", "xen" },
+                    { "KVMKVMKVM", "kvm" },
+                    { "Linux KVM Hv", "kvm" },
+                    { "TCGTCGTCGTCG", "qemu" },
+                    { "VMwareVMware", "vmware" },
+                    { "Microsoft Hv", "microsoft" },
+                    { "bhyve bhyve ", "bhyve" },
+                    { "QNXQVMBSQG", "qnx" },
+                    { "ACRNACRNACRN", "acrn" },
+                    { "SRESRESRESRE", "sre" },
+                    { "Apple VZ", "apple" }
+                } };
 
-            struct custom_peb {
-                unsigned char reserved1[2];
-                unsigned char being_debugged;
-                unsigned char reserved2[1];
-                void* mutant;
-                void* image_base_address;
-                struct {
-                    unsigned char reserved3[8];
-                    void* reserved4[3];
-                    LIST_ENTRY in_memory_list;
-                }*ldr;
-            };
+                for (const auto& vendor : vendors) {
+                    if (s.cpuid_vendor == vendor.first) {
+                        return vendor.second;
+                    }
+                }
 
-            if (memo::module::is_cached()) {
-                return get_ntdll ? memo::module::fetch_ntdll() : memo::module::fetch_kernel32();
+                return "vm-other";
             }
 
-            custom_peb* peb = nullptr;
-
-        #if (x86_64)
-            #if (MSVC && !CLANG)
-                peb = reinterpret_cast<custom_peb*>(__readgsqword(0x60));
-            #else
-                asm("movq %%gs:0x60, %0" : "=r"(peb));
-            #endif
-        #elif (x86_32)
-            #if (MSVC && !CLANG)
-                peb = reinterpret_cast<custom_peb*>(__readfsdword(0x30));
-            #else
-                asm("movl %%fs:0x30, %0" : "=r"(peb));
-            #endif
-        #endif
+            static const char* vm_id(const sources& s) {
+                const char* dmi = dmi_id(s);
 
-            if (!peb || !peb->ldr) {
-                return GetModuleHandleW(get_ntdll ? L"ntdll.dll" : L"kernel32.dll");
-            }
+                /* These are trusted over CPUID, which may show whatever is underneath */
+                if (!std::strcmp(dmi, "oracle") || !std::strcmp(dmi, "xen") || !std::strcmp(dmi, "amazon")) {
+                    return dmi;
+                }
 
-            auto matches = [](const wchar_t* s1, const wchar_t* s2, const unsigned short len) noexcept -> bool {
-                for (unsigned short i = 0; i < len; ++i) {
-                    if ((s1[i] | 0x20) != (s2[i] | 0x20)) {
-                        return false;
-                    }
+                if (s.uml) {
+                    return "uml";
                 }
-                return true;
-            };
 
-            HMODULE res_ntdll = nullptr;
-            HMODULE res_k32 = nullptr;
+                if (s.proc_xen) {
+                    return "xen";
+                }
 
-            LIST_ENTRY* head = &peb->ldr->in_memory_list;
-            for (LIST_ENTRY* cur = head->Flink; cur != nullptr && cur != head; cur = cur->Flink) {
-                auto* ent = reinterpret_cast<custom_ldr_entry*>(reinterpret_cast<char*>(cur) - (sizeof(void*) * 2));
-                if (!ent || !ent->base_name.buffer || ent->base_name.length == 0) {
-                    continue;
+                bool hyperv = false;
+                bool other = false;
+                const char* cpuid = cpuid_id(s);
+
+                /* Hyper-V shows up under other hypervisors too, so keep looking */
+                if (!std::strcmp(cpuid, "microsoft")) {
+                    hyperv = true;
+                }
+                else if (!std::strcmp(cpuid, "vm-other")) {
+                    other = true;
+                }
+                else if (std::strcmp(cpuid, "none") != 0) {
+                    return cpuid;
                 }
 
-                const unsigned short len_chars = ent->base_name.length / sizeof(wchar_t);
-                const wchar_t* buf = ent->base_name.buffer;
+                if (!std::strcmp(dmi, "vm-other")) {
+                    other = true;
+                }
+                else if (std::strcmp(dmi, "none") != 0) {
+                    return dmi;
+                }
 
-                if ((len_chars == 9 && matches(buf, L"ntdll.dll", 9)) || (len_chars == 5 && matches(buf, L"ntdll", 5))) {
-                    res_ntdll = reinterpret_cast<HMODULE>(ent->dll_base);
+                if (s.sysinfo.find("z/VM") != std::string::npos) {
+                    return "zvm";
                 }
-                else if ((len_chars == 12 && matches(buf, L"kernel32.dll", 12)) || (len_chars == 8 && matches(buf, L"kernel32", 8))) {
-                    res_k32 = reinterpret_cast<HMODULE>(ent->dll_base);
+
+                if (s.sysinfo.find("KVM/Linux") != std::string::npos) {
+                    return "kvm";
                 }
 
-                if (res_ntdll && res_k32) {
-                    break;
+                if (hyperv) {
+                    return "microsoft";
                 }
-            }
 
-            if (res_ntdll || res_k32) {
-                memo::module::store(res_ntdll, res_k32);
+                return other ? "vm-other" : "none";
             }
 
-            if (get_ntdll) {
-                return res_ntdll ? res_ntdll : GetModuleHandleW(L"ntdll.dll");
+            static const char* classify(const sources& s) {
+                const char* container = container_id(s);
+                return std::strcmp(container, "none") ? container : vm_id(s);
             }
-            return res_k32 ? res_k32 : GetModuleHandleW(L"kernel32.dll");
-        }
-    };
-#endif
 
-    /* String utilities */
-    struct string {
-        /* Converts a single character to lowercase */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR char to_lower(char c) noexcept {
-            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
-        }
+            static sources gather() {
+                sources s;
 
-        /* Converts a single character to uppercase */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR char to_upper(char c) noexcept {
-            return (c >= 'a' && c <= 'z') ? static_cast<char>(c & 0xDF) : c;
-        }
+                s.proc_vz = exists(file_paths::proc_vz);
+                s.proc_bc = exists(file_paths::proc_bc);
 
-        /* Checks if a string starts with a specific prefix (case-sensitive) */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 bool starts_with(const char* str, const char* prefix) noexcept {
-            if (!str || !prefix) {
-                return false;
-            }
-            while (*prefix) {
-                if (*str++ != *prefix++) {
-                    return false;
+                char line[256];
+                if (read_into(file_paths::osrelease, line, sizeof(line)) > 0) {
+                    s.osrelease = line;
                 }
-            }
-            return true;
-        }
 
-        /* Finds a substring inside a null-terminated string (case-sensitive) */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 const char* find(const char* haystack, const char* needle) noexcept {
-            if (!haystack || !needle) {
-                return nullptr;
-            }
-            if (!*needle) {
-                return haystack;
-            }
-            for (; *haystack; ++haystack) {
-                if (*haystack == *needle) {
-                    const char* h = haystack;
-                    const char* n = needle;
-                    while (*h && *n && *h == *n) {
-                        h++;
-                        n++;
+                /* Straight from the container manager if it left a note, otherwise from PID 1's environment */
+                const auto first_line = [](const char* text) {
+                    const char* end = text;
+                    while (*end != '\0' && *end != '\n') {
+                        ++end;
                     }
-                    if (!*n) {
-                        return haystack;
+                    return std::string(text, static_cast<size_t>(end - text));
+                };
+
+                std::string environment;
+
+                if (read_into(file_paths::container_manager, line, sizeof(line)) >= 0 ||
+                    read_into(file_paths::systemd_container, line, sizeof(line)) >= 0) {
+                    s.container = first_line(line);
+                    s.container_known = true;
+                }
+                else if (getpid() == 1) {
+                    const char* value = std::getenv("container");
+                    s.container = value ? value : "";
+                    s.container_known = (value != nullptr);
+                }
+                else if (read_bytes(file_paths::init_environ, environment)) {
+                    s.container_known = true;
+                    size_t start = 0;
+                    while (start < environment.size()) {
+                        const size_t end = environment.find('\0', start);
+                        const size_t length = ((end == std::string::npos) ? environment.size() : end) - start;
+                        if (environment.compare(start, 10, "container=") == 0) {
+                            s.container = environment.substr(start + 10, length - 10);
+                            break;
+                        }
+                        start += length + 1;
                     }
                 }
-            }
-            return nullptr;
-        }
 
-        /* Finds a substring inside a null-terminated string (case-insensitive) */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 const char* find_ci(const char* haystack, const char* needle) noexcept {
-            if (!haystack || !needle) {
-                return nullptr;
+                s.containerenv = exists(file_paths::containerenv);
+                s.dockerenv = exists(file_paths::dockerenv);
+
+                const smbios& table = smbios::get();
+                s.dmi[0] = table.system.product;
+                s.dmi[1] = table.system.manufacturer;
+                s.dmi[2] = table.board.manufacturer;
+                s.dmi[3] = table.bios.vendor;
+                s.smbios_vm_bit = table.bios.has_vm_bit && table.bios.vm_bit;
+
+                s.uml = (read_file(file_paths::cpuinfo).find("vendor_id\t: User Mode Linux") != std::string::npos);
+                s.proc_xen = exists(file_paths::proc_xen);
+
+            #if (x86)
+                u32 eax = 0, ebx = 0, ecx = 0, edx = 0;
+                cpu::cpuid(eax, ebx, ecx, edx, cpu::leaf::features);
+                s.hypervisor_bit = (ecx & (1u << 31));
+                if (s.hypervisor_bit) {
+                    s.cpuid_vendor = cpu::cpu_manufacturer(cpu::leaf::hypervisor);
+                }
+            #endif
+
+                s.sysinfo = read_file(file_paths::sysinfo);
+
+                return s;
             }
-            if (!*needle) {
-                return haystack;
+        };
+    #endif
+
+    #if (LINUX)
+        /* A file that a Linux technique is known to look at, either only for its existence or for its content */
+        struct file_probe {
+            enum_flags technique;
+            const char* path;
+            bool read;
+        };
+
+    #if (VMAWARE_IO_URING_SUPPORTED)
+        /*
+         * Minimal io_uring submission/completion ring, just enough to push a batch of statx,
+         * openat, read and close operations through a handful of io_uring_enter() calls.
+         * This talks to the kernel directly, so there's no dependency on liburing.
+         */
+        struct uring {
+            int fd = -1;
+            void* sq_ptr = MAP_FAILED;
+            void* cq_ptr = MAP_FAILED;
+            size_t sq_len = 0;
+            size_t cq_len = 0;
+            io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+            size_t sqes_len = 0;
+
+            unsigned* sq_head = nullptr;
+            unsigned* sq_tail = nullptr;
+            unsigned* sq_mask = nullptr;
+            unsigned* sq_array = nullptr;
+            unsigned* cq_head = nullptr;
+            unsigned* cq_tail = nullptr;
+            unsigned* cq_mask = nullptr;
+            io_uring_cqe* cqes = nullptr;
+            unsigned capacity = 0;
+            unsigned pending = 0;
+            bool broken = false; /* requests might still be in flight, see submit_and_wait() */
+
+            explicit uring(const unsigned entries) noexcept {
+                io_uring_params params{};
+                fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+                if (fd < 0) {
+                    return;
+                }
+
+                sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                cq_len = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP);
+
+                if (single_mmap) {
+                    sq_len = cq_len = (std::max)(sq_len, cq_len);
+                }
+
+                sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+                if (sq_ptr == MAP_FAILED) {
+                    return;
+                }
+
+                cq_ptr = single_mmap ? sq_ptr : mmap(nullptr, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                if (cq_ptr == MAP_FAILED) {
+                    return;
+                }
+
+                sqes_len = params.sq_entries * sizeof(io_uring_sqe);
+                sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+                if (sqes == MAP_FAILED) {
+                    return;
+                }
+
+                char* const sq = static_cast<char*>(sq_ptr);
+                char* const cq = static_cast<char*>(cq_ptr);
+                sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+                sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+                cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+                capacity = params.sq_entries;
             }
-            const char n0_lower = to_lower(*needle);
-            for (; *haystack; ++haystack) {
-                if (to_lower(*haystack) == n0_lower) {
-                    const char* h = haystack;
-                    const char* n = needle;
-                    while (*h && *n && to_lower(*h) == to_lower(*n)) {
-                        h++;
-                        n++;
-                    }
-                    if (!*n) {
-                        return haystack;
-                    }
+
+            ~uring() {
+                if (sqes != MAP_FAILED) {
+                    munmap(sqes, sqes_len);
+                }
+                if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+                    munmap(cq_ptr, cq_len);
+                }
+                if (sq_ptr != MAP_FAILED) {
+                    munmap(sq_ptr, sq_len);
+                }
+                if (fd >= 0) {
+                    close(fd);
                 }
             }
-            return nullptr;
-        }
 
-        /* Checks if a std::string contains a substring (case-sensitive) */
-        static VMAWARE_FORCE_INLINE bool contains(const std::string& base_str, const char* keyword) noexcept {
-            return base_str.find(keyword) != std::string::npos;
-        }
+            uring(const uring&) = delete;
+            uring& operator=(const uring&) = delete;
 
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 bool contains_ci(const char* haystack, const char* needle) noexcept {
-            if (!haystack || !needle) {
-                return false;
+            bool ready() const noexcept {
+                return capacity != 0 && !broken;
             }
-            if (!*needle) {
-                return true;
+
+            /* A zeroed entry to fill, only valid until the next submit_and_wait() */
+            io_uring_sqe* next(const u8 opcode, const int file, const u64 user_data) noexcept {
+                const unsigned tail = *sq_tail + pending;
+                const unsigned index = tail & *sq_mask;
+                io_uring_sqe* sqe = &sqes[index];
+                std::memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = opcode;
+                sqe->fd = file;
+                sqe->user_data = user_data;
+                sq_array[index] = index;
+                ++pending;
+                return sqe;
             }
-            const char n0_lower = to_lower(*needle);
-            for (; *haystack; ++haystack) {
-                if (to_lower(*haystack) == n0_lower) {
-                    const char* h = haystack;
-                    const char* n = needle;
-                    while (*h && *n && to_lower(*h) == to_lower(*n)) {
-                        h++;
-                        n++;
+
+            /*
+             * Submit everything queued and hand every completion to on_complete(user_data, res).
+             * If the submission fails, whatever the kernel didn't take yet is taken back out of
+             * the ring, and the completions of everything it did take are still waited for and
+             * handed over, so no request outlives the call and every fd that opened is reported.
+             * Only if even that wait fails is the ring marked broken for good, and the caller
+             * then has to leave every buffer it gave to the kernel alone, see abandon().
+             */
+            template <typename F>
+            bool submit_and_wait(F&& on_complete) noexcept {
+                const unsigned start = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+                unsigned submitted = pending;
+                __atomic_store_n(sq_tail, *sq_tail + pending, __ATOMIC_RELEASE);
+                pending = 0;
+
+                unsigned to_submit = submitted;
+                unsigned reaped = 0;
+                bool ok = true;
+
+                while (reaped < submitted) {
+                    const long rc = syscall(__NR_io_uring_enter, fd, to_submit, submitted - reaped, IORING_ENTER_GETEVENTS, nullptr, 0);
+                    if (rc < 0) {
+                        if (errno == EINTR) {
+                            continue;
+                        }
+                        if (to_submit == 0) {
+                            broken = true;
+                            return false;
+                        }
+
+                        /* The kernel only reads the ring during io_uring_enter(), so the rest can be withdrawn */
+                        const unsigned consumed = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+                        __atomic_store_n(sq_tail, consumed, __ATOMIC_RELEASE);
+                        submitted = consumed - start;
+                        to_submit = 0;
+                        ok = false;
+                        continue;
                     }
-                    if (!*n) {
-                        return true;
+                    to_submit -= (std::min)(to_submit, static_cast<unsigned>(rc));
+
+                    unsigned head = *cq_head;
+                    const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+                    while (head != tail) {
+                        const io_uring_cqe& cqe = cqes[head & *cq_mask];
+                        on_complete(cqe.user_data, cqe.res);
+                        ++head;
+                        ++reaped;
                     }
-                }
-            }
-            return false;
-        }
 
-        /* Compares two null-terminated strings for equality (case-insensitive) */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 bool equals_ci(const char* s1, const char* s2) noexcept {
-            if (!s1 || !s2) {
-                return s1 == s2;
-            }
-            while (*s1 && *s2) {
-                if (to_lower(*s1) != to_lower(*s2)) {
-                    return false;
+                    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
                 }
-                s1++;
-                s2++;
-            }
-            return *s1 == *s2;
-        }
 
-        /* Converts a std::string to lowercase in place */
-        static VMAWARE_FORCE_INLINE void to_lower_inplace(std::string& str) noexcept {
-            const size_t len = str.length();
-            for (size_t i = 0; i < len; ++i) {
-                str[i] = to_lower(str[i]);
+                return ok;
             }
-        }
+        };
 
-        /* Trims leading and trailing whitespaces from a std::string in place */
-        static VMAWARE_FORCE_INLINE void trim_inplace(std::string& s) noexcept {
-            while (!s.empty() && is_space(s.front())) {
-                s.erase(s.begin());
-            }
-            while (!s.empty() && is_space(s.back())) {
-                s.pop_back();
-            }
+        /* Hands the storage of buffers a broken ring might still write into to a vector that's never destroyed */
+        template <typename T>
+        static void abandon(std::vector<T>& buffers) {
+            std::vector<T>* const kept = new std::vector<T>(std::move(buffers));
+            VMAWARE_UNUSED(kept);
         }
 
-        /* Trims leading whitespaces from a null-terminated string pointer */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR_20 const char* ltrim(const char* str) noexcept {
-            if (!str) {
-                return nullptr;
-            }
-            while (*str && is_space(*str)) {
-                str++;
-            }
-            return str;
-        }
+        /* One batch of at most ring.capacity probes, see uring_probe() */
+        static bool uring_batch(uring& ring, const file_probe* const* probes, const size_t count) {
+            constexpr size_t READ_CHUNK = 16384;
+            constexpr u32 STATX_TYPE_MASK = 0x1; /* STATX_TYPE */
 
-        /* Checks if a std::string consists only of numerical digits */
-        static VMAWARE_FORCE_INLINE bool is_numeric(const std::string& s) noexcept {
-            if (s.empty()) {
-                return false;
+            struct slot {
+                int fd = -1;
+                int status = 0;     /* statx or openat result */
+                ssize_t length = 0; /* first read result */
+            };
+
+            std::vector<slot> slots(count);
+            std::vector<std::array<unsigned char, 256>> statx_buffers(count); /* struct statx is 256 bytes */
+            std::vector<char> contents;
+            size_t read_count = 0;
+
+            for (size_t i = 0; i < count; ++i) {
+                if (probes[i]->read) {
+                    ++read_count;
+                }
             }
-            const size_t len = s.length();
-            for (size_t i = 0; i < len; ++i) {
-                if (!is_digit(s[i])) {
-                    return false;
+            contents.resize(read_count * READ_CHUNK);
+
+            /* Round 1: statx for existence checks, openat for reads */
+            for (size_t i = 0; i < count; ++i) {
+                if (probes[i]->read) {
+                    io_uring_sqe* sqe = ring.next(IORING_OP_OPENAT, AT_FDCWD, i);
+                    sqe->addr = reinterpret_cast<u64>(probes[i]->path);
+                    sqe->open_flags = O_RDONLY | O_CLOEXEC;
+                }
+                else {
+                    io_uring_sqe* sqe = ring.next(IORING_OP_STATX, AT_FDCWD, i);
+                    sqe->addr = reinterpret_cast<u64>(probes[i]->path);
+                    sqe->len = STATX_TYPE_MASK;
+                    sqe->off = reinterpret_cast<u64>(statx_buffers[i].data());
                 }
             }
-            return true;
-        }
 
-        /* Helper to check for ASCII spaces (avoids locale overhead) */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR bool is_space(char c) noexcept {
-            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
-        }
+            const bool opened_ok = ring.submit_and_wait([&](const u64 id, const i32 res) noexcept {
+                slots[id].status = res;
+                if (probes[id]->read && res >= 0) {
+                    slots[id].fd = res;
+                }
+            });
 
-        /* Helper to check for ASCII digits */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR bool is_digit(char c) noexcept {
-            return c >= '0' && c <= '9';
-        }
+            /* Round 2: the first chunk of every file that opened, from its current position, only once round 1 went through */
+            size_t buffer_index = 0;
+            std::vector<char*> buffers(count, nullptr);
+            bool read_ok = false;
 
-        /* Helper to check for hexadecimal characters */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR bool is_hex(char c) noexcept {
-            return (c >= '0' && c <= '9') || (to_lower(c) >= 'a' && to_lower(c) <= 'f');
-        }
+            if (opened_ok) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (!probes[i]->read) {
+                        continue;
+                    }
+                    buffers[i] = contents.data() + (buffer_index++ * READ_CHUNK);
+                    if (slots[i].fd >= 0) {
+                        io_uring_sqe* sqe = ring.next(IORING_OP_READ, slots[i].fd, i);
+                        sqe->addr = reinterpret_cast<u64>(buffers[i]);
+                        sqe->len = static_cast<u32>(READ_CHUNK);
+                        sqe->off = static_cast<u64>(-1);
+                    }
+                }
+
+                read_ok = ring.submit_and_wait([&](const u64 id, const i32 res) noexcept {
+                    slots[id].length = res;
+                });
+            }
+
+            if (ring.broken) {
+                abandon(statx_buffers);
+                abandon(contents);
+            }
 
-        /* Helper to check if a character is alphanumeric */
-        static VMAWARE_FORCE_INLINE VMAWARE_CONSTEXPR bool is_alnum(char c) noexcept {
-            return (to_lower(c) >= 'a' && to_lower(c) <= 'z') || is_digit(c);
-        }
-    };
+            /* Anything longer than the first chunk is finished off with plain read() calls */
+            for (size_t i = 0; i < count && opened_ok; ++i) {
+                const file_probe& probe = *probes[i];
 
-    /* Miscellaneous functionalities */
-    struct util {
-        [[nodiscard]] static constexpr bool is_unsupported(const VM::enum_flags flag) noexcept {
-            return (flag >= VM::HYPERVISOR_BIT && flag <= VM::KGT_SIGNATURE) ? false :
-            #if (LINUX)
-                !(flag >= LINUX_START && flag <= LINUX_END);
-            #elif (WINDOWS)
-                !(flag >= WINDOWS_START && flag <= WINDOWS_END);
-            #elif (APPLE) 
-                !(flag >= MACOS_START && flag <= MACOS_END);
-            #else
-                false;
-            #endif
-        }
+                if (!probe.read) {
+                    /* Only a clear answer is cached, errors like EACCES on a parent directory are left to the technique */
+                    if (slots[i].status == 0) {
+                        memo::file_cache::store_exists(probe.path, true);
+                    }
+                    else if (slots[i].status == -ENOENT || slots[i].status == -ENOTDIR) {
+                        memo::file_cache::store_exists(probe.path, false);
+                    }
+                    continue;
+                }
 
-    #if (LINUX)
-        /* Fetch file data */
-        [[nodiscard]] static std::string read_file(const char* raw_path) {
-            VMAWARE_ASSUME(raw_path != nullptr);
-            std::string path;
-            const std::string raw_path_str = raw_path;
+                if (slots[i].fd < 0) {
+                    memo::file_cache::store_content(probe.path, std::string(), false, 1);
+                    continue;
+                }
 
-            /* Replace the "~" part with the home directory */
-            if (raw_path[0] == '~') {
-                const char* home = std::getenv("HOME");
-                if (home) {
-                    path = std::string(home) + raw_path_str.substr(1);
+                if (!read_ok || slots[i].length < 0) {
+                    continue;
                 }
-            } else {
-                path = raw_path;
-            }
 
-            if (!exists(path.c_str())) {
-                return "";
+                std::string data(buffers[i], static_cast<size_t>(slots[i].length));
+                u32 syscalls = 3; /* what open(), read() and close() would have taken */
+
+                if (static_cast<size_t>(slots[i].length) == READ_CHUNK) {
+                    char chunk[4096];
+                    while (true) {
+                        const ssize_t n = read(slots[i].fd, chunk, sizeof(chunk));
+                        ++syscalls;
+                        if (n > 0) {
+                            data.append(chunk, static_cast<size_t>(n));
+                        }
+                        else if (!(n < 0 && errno == EINTR)) {
+                            break;
+                        }
+                    }
+                }
+                else {
+                    ++syscalls; /* the read() that would have hit the end of the file */
+                }
+
+                memo::file_cache::store_content(probe.path, data, true, syscalls);
             }
 
-            std::ifstream file{};
-            std::string data{};
-            std::string line{};
+            /* Round 3: close everything that was opened, through the ring as long as the batch went through */
+            const bool close_round = opened_ok && read_ok;
+
+            if (close_round) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (slots[i].fd >= 0) {
+                        ring.next(IORING_OP_CLOSE, slots[i].fd, i);
+                    }
+                }
 
-            file.open(path);
+                /* close() gives the fd up even when it reports an error, so any completion means it's gone */
+                ring.submit_and_wait([&](const u64 id, const i32) noexcept {
+                    slots[id].fd = -1;
+                });
+            }
 
-            if (file.is_open()) {
-                while (std::getline(file, line)) {
-                    data += line + "\n";
+            /*
+             * Whatever is left never reached the kernel. If the ring broke in the middle of the
+             * closes, there's no telling which of them went through, and an fd that might belong
+             * to someone else by now is better leaked than closed
+             */
+            if (!(close_round && ring.broken)) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (slots[i].fd >= 0) {
+                        close(slots[i].fd);
+                    }
                 }
             }
 
-            file.close();
-            return data;
+            return opened_ok && read_ok;
         }
 
-        [[nodiscard]] static bool exists(const char* path) {
-        #if (VMAWARE_CPP >= 17)
-            return std::filesystem::exists(path);
-        #elif (VMAWARE_CPP >= 11)
-            struct stat buffer;
-            return (stat(path, &buffer) == 0);
-        #endif
-        }
+        /*
+         * Probe a batch of paths through io_uring and hand the results to memo::file_cache,
+         * so the techniques that look at them later on find them already there. Existence
+         * checks become statx operations, and reads become one round of openat, one round
+         * of reads and one round of close, no matter how many files there are. The ring is
+         * set up once and kept, as setting it up costs about as much as the probes it saves.
+         * Returns false if io_uring isn't usable here (old kernel, seccomp, gVisor...), and
+         * then nothing is prefetched and every technique falls back to the plain syscalls.
+         */
+        static bool uring_probe(const file_probe* const* probes, const size_t count) {
+            static uring ring(64);
+            static std::mutex ring_mutex;
 
-        [[nodiscard]] static bool is_directory(const char* path) {
-            VMAWARE_ASSUME(path != nullptr);
-            struct stat info{};
-            if (stat(path, &info) != 0) {
+            if (count == 0 || !ring.ready()) {
                 return false;
             }
-            return (info.st_mode & S_IFDIR); /* check if directory */
+
+            std::lock_guard<std::mutex> lock(ring_mutex);
+
+            for (size_t done = 0; done < count; done += ring.capacity) {
+                if (!uring_batch(ring, probes + done, (std::min)(static_cast<size_t>(ring.capacity), count - done))) {
+                    return false;
+                }
+            }
+
+            return true;
         }
     #endif
 
-        /* Fetch the file but in binary form */
-        [[nodiscard]] static std::vector<u8> read_file_binary(const char* file_path) {
-            VMAWARE_ASSUME(file_path != nullptr);
-            std::ifstream file(file_path, std::ios::binary);
+        /*
+         * Before a run, batch every file probe of the enabled techniques that haven't run yet
+         * through io_uring (only with VMAWARE_IO_URING), and store the results in memo::file_cache.
+         * Without io_uring this does nothing, and each technique just does its own syscalls.
+         * Returns whether anything was prefetched.
+         */
+        static bool prefetch_files(const flagset& flags) {
+        #if (VMAWARE_IO_URING_SUPPORTED)
+            static constexpr file_probe probes[] = {
+                { VM::THREAD_MISMATCH, file_paths::smt_control, true },
+                { VM::THREAD_MISMATCH, file_paths::smt_active, true },
+                { VM::THREAD_MISMATCH, file_paths::thread_siblings, true },
+                { VM::THREAD_MISMATCH, file_paths::cpuinfo, true },
+                { VM::SMBIOS_VM_BIT, file_paths::dmi_table, true },
+                { VM::SMBIOS_VM_BIT, file_paths::smbios_entry_point, true },
+                { VM::SMBIOS_VM_BIT, file_paths::bios_raw, true },
+                { VM::DMI_SCAN, file_paths::bios_vendor, true },
+                { VM::DMI_SCAN, file_paths::bios_version, true },
+                { VM::DMI_SCAN, file_paths::sys_vendor, true },
+                { VM::DMI_SCAN, file_paths::product_name, true },
+                { VM::DMI_SCAN, file_paths::product_sku, true },
+                { VM::DMI_SCAN, file_paths::product_family, true },
+                { VM::DMI_SCAN, file_paths::board_vendor, true },
+                { VM::DMI_SCAN, file_paths::board_name, true },
+                { VM::DMI_SCAN, file_paths::chassis_vendor, true },
+                { VM::DMI_SCAN, file_paths::chassis_asset_tag, true },
+                { VM::DMI_SCAN, file_paths::chassis_type, true },
+                { VM::QEMU_VIRTUAL_DMI, file_paths::sys_vendor, true },
+                { VM::QEMU_VIRTUAL_DMI, file_paths::modalias, true },
+                { VM::HYPERVISOR_DIR, file_paths::hypervisor_type, true },
+                { VM::UML_CPU, file_paths::cpuinfo, true },
+                { VM::VBOX_MODULE, file_paths::modules, true },
+                { VM::SYSINFO_PROC, file_paths::sysinfo, true },
+                { VM::WSL_PROC, file_paths::osrelease, true },
+                { VM::WSL_PROC, file_paths::version, true },
+                { VM::CONTAINER_PID, file_paths::self_status, true },
+                { VM::CGROUP, file_paths::self_cgroup, true },
+                { VM::QEMU_FW_CFG, file_paths::dt_fw_cfg, false },
+                { VM::QEMU_FW_CFG, file_paths::dt_hypervisor, false },
+                { VM::QEMU_FW_CFG, file_paths::qemu_fw_cfg_module, false },
+                { VM::QEMU_FW_CFG, file_paths::qemu_fw_cfg_firmware, false },
+                { VM::SYSTEMD, file_paths::proc_vz, false },
+                { VM::SYSTEMD, file_paths::proc_bc, false },
+                { VM::SYSTEMD, file_paths::osrelease, true },
+                { VM::SYSTEMD, file_paths::container_manager, true },
+                { VM::SYSTEMD, file_paths::systemd_container, true },
+                { VM::SYSTEMD, file_paths::init_environ, true },
+                { VM::SYSTEMD, file_paths::containerenv, false },
+                { VM::SYSTEMD, file_paths::dockerenv, false },
+                { VM::SYSTEMD, file_paths::cpuinfo, true },
+                { VM::SYSTEMD, file_paths::proc_xen, false },
+                { VM::SYSTEMD, file_paths::sysinfo, true },
+                { VM::DOCKERENV, file_paths::dockerenv, false },
+                { VM::DOCKERENV, file_paths::dockerinit, false },
+                { VM::HWMON, file_paths::hwmon, false },
+                { VM::BLUESTACKS_FOLDERS, file_paths::bluestacks_mnt, false },
+                { VM::BLUESTACKS_FOLDERS, file_paths::bluestacks_sdcard, false },
+                { VM::PODMAN_FILE, file_paths::containerenv, false },
+                { VM::TEMPERATURE, file_paths::cooling_device, false },
+                { VM::TEMPERATURE, file_paths::thermal_zone, false },
+                { VM::PROCESSES, file_paths::proc_xen, false },
+                { VM::PROCESSES, file_paths::proc_vz, false }
+            };
 
-            if (!file) {
-                return {};
-            }
+            constexpr size_t probe_count = sizeof(probes) / sizeof(probes[0]);
+            std::array<const file_probe*, probe_count> wanted{};
+            size_t count = 0;
 
-            std::vector<u8> buffer;
-            std::istreambuf_iterator<char> it(file);
-            const std::istreambuf_iterator<char> end;
+            for (const file_probe& probe : probes) {
+                if (!flags.test(probe.technique) || memo::is_cached(probe.technique)) {
+                    continue;
+                }
+
+                /* Several techniques can share a file, and the paths all come from file_paths, so the pointers tell */
+                bool duplicate = false;
+                for (size_t i = 0; i < count && !duplicate; ++i) {
+                    duplicate = (wanted[i]->path == probe.path) && (wanted[i]->read == probe.read);
+                }
 
-            while (it != end) {
-                buffer.push_back(static_cast<u8>(*it));
-                ++it;
+                if (!duplicate) {
+                    wanted[count++] = &probe;
+                }
             }
 
-            file.close();
+            /* A single file isn't worth setting up a ring for */
+            if (count < 2) {
+                return false;
+            }
 
-            return buffer;
+            return uring_probe(wanted.data(), count);
+        #else
+            VMAWARE_UNUSED(flags);
+            return false;
+        #endif
         }
+    #endif
 
         /* Wrapper for std::make_unique because it's not available for C++11 */
         template<typename T, typename... Args>
@@ -4694,12 +7088,15 @@ public:
         template <typename... Args>
         static void debug_msg(Args&&... message) {
             static std::unordered_set<std::string> printed_messages;
+            static std::mutex print_mutex; /* techniques can log from VM::PARALLEL worker threads */
 
             std::ostringstream oss;
             print_to_stream(oss, std::forward<Args>(message)...);
 
             std::string msg_content = oss.str();
 
+            const std::lock_guard<std::mutex> lock(print_mutex);
+
             if (printed_messages.find(msg_content) == printed_messages.end()) {
             #if (LINUX || APPLE)
                 constexpr const char* black_bg = "\x1B[48;2;0;0;0m";
@@ -4764,73 +7161,156 @@ public:
         }
 
 
-        [[nodiscard]] static bool is_proc_running(const char* executable) {
-        #if (LINUX)
-            VMAWARE_ASSUME(executable != nullptr);
-            #if (VMAWARE_CPP >= 17)
-            for (const auto& entry : std::filesystem::directory_iterator("/proc")) {
-                if (!entry.is_directory()) {
-                    continue;
-                }
+    #if (LINUX)
+        /* A process name to look for, with its hash worked out at compile time for the table ones */
+        struct process_entry {
+            u32 hash;
+            const char* name;
+            brand_enum brand;
 
-                const std::string filename = entry.path().filename().string();
-            #else
-            std::unique_ptr<DIR, decltype(&closedir)> dir(opendir("/proc"), closedir);
-            if (!dir) {
-                debug("util::is_proc_running: ", "failed to open /proc directory");
-                return false;
+            constexpr process_entry(const char* n, brand_enum b) noexcept
+                : hash(cpu::constexpr_hash::get(n)), name(n), brand(b) {
             }
+        };
 
-            struct dirent* entry;
-            while ((entry = readdir(dir.get())) != nullptr) {
-                std::string filename(entry->d_name);
-                if (filename == "." || filename == "..") {
-                    continue;
-                }
-            #endif
-                if (!string::is_numeric(filename)) {
-                    continue;
+        /* Same CRC32-C as cpu::constexpr_hash, over a string that isn't null-terminated */
+        static u32 process_hash(const char* s, const size_t length) noexcept {
+            u32 crc = 0;
+            for (size_t i = 0; i < length; ++i) {
+                crc ^= static_cast<u8>(s[i]);
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
                 }
+            }
+            return crc;
+        }
 
-                const std::string cmdline_file = "/proc/" + filename + "/cmdline";
+        /*
+         * Walk /proc once and look every process up among the entries, by the basename of its
+         * argv[0]. The directory is listed with raw getdents64() calls, each cmdline is opened
+         * relative to the /proc descriptor and only its first bytes are pread() into one reused
+         * buffer, and the names go through a small hash set, so looking for any number of names
+         * costs a single pass. Returns a bitmask of the entries that were found (up to 64), and
+         * stops early once all of them were.
+         */
+        static u64 find_processes(const process_entry* entries, const size_t count) {
+            if (count == 0) {
+                return 0;
+            }
 
-                /* Read raw bytes (binary) to preserve embedded NULs */
-                std::ifstream ifs(cmdline_file, std::ios::in | std::ios::binary);
-                if (!ifs.is_open()) {
-                    continue;
-                }
+            const size_t usable = (std::min)(count, static_cast<size_t>(64));
+            const u64 all = (usable == 64) ? ~0ull : ((1ull << usable) - 1);
 
-                /* Read entire file into vector<char> */
-                std::vector<char> buf((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
-                ifs.close();
+            /* Open addressing over twice as many slots as there are names, 0xFF is empty */
+            constexpr size_t SLOTS = 128;
+            std::array<u8, SLOTS> set;
+            set.fill(0xFF);
 
-                if (buf.empty()) {
-                    continue;
+            for (size_t i = 0; i < usable; ++i) {
+                size_t slot = entries[i].hash & (SLOTS - 1);
+                while (set[slot] != 0xFF) {
+                    slot = (slot + 1) & (SLOTS - 1);
                 }
+                set[slot] = static_cast<u8>(i);
+            }
 
-                /* Cmdline is argv0\0argv1\0..., so argv0 is bytes up to first NUL */
-                const auto it_nul = std::find(buf.begin(), buf.end(), '\0');
-                if (it_nul == buf.begin()) {
-                    continue;
-                }
+            const int proc = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (proc < 0) {
+                debug("util::find_processes: ", "failed to open /proc directory");
+                return 0;
+            }
 
-                std::string const argv0(buf.begin(), it_nul);
-                if (argv0.empty()) {
-                    continue;
-                }
+            /* The kernel's struct linux_dirent64, which glibc doesn't expose under that name */
+            struct dirent64_record {
+                u64 ino;
+                i64 off;
+                unsigned short reclen;
+                unsigned char type;
+                char name[1];
+            };
 
-                /* Extract basename of argv0 */
-                const std::size_t slash_index = argv0.find_last_of('/');
-                std::string const basename = (slash_index == std::string::npos) ? argv0 : argv0.substr(slash_index + 1);
+            alignas(8) char entries_buffer[16384];
+            char path[32];
+            char cmdline[256];
+            u64 found = 0;
 
-                if (basename != executable) {
-                    continue;
+            while (found != all) {
+                const long bytes = syscall(SYS_getdents64, proc, entries_buffer, sizeof(entries_buffer));
+                if (bytes <= 0) {
+                    break;
                 }
 
-                return true;
+                for (long offset = 0; offset < bytes && found != all;) {
+                    const dirent64_record* record = reinterpret_cast<const dirent64_record*>(entries_buffer + offset);
+                    offset += record->reclen;
+
+                    const char* pid = record->name;
+                    if (pid[0] < '1' || pid[0] > '9' || (record->type != DT_DIR && record->type != DT_UNKNOWN)) {
+                        continue;
+                    }
+
+                    size_t length = 0;
+                    while (pid[length] >= '0' && pid[length] <= '9' && length < 20) {
+                        ++length;
+                    }
+                    if (pid[length] != '\0') {
+                        continue;
+                    }
+
+                    std::memcpy(path, pid, length);
+                    std::memcpy(path + length, "/cmdline", sizeof("/cmdline"));
+
+                    const int fd = openat(proc, path, O_RDONLY | O_CLOEXEC);
+                    if (fd < 0) {
+                        continue; /* the process is already gone */
+                    }
+
+                    const ssize_t n = pread(fd, cmdline, sizeof(cmdline), 0);
+                    close(fd);
+
+                    if (n <= 0) {
+                        continue; /* kernel threads have an empty cmdline */
+                    }
+
+                    /* cmdline is argv0\0argv1\0..., so argv0 is everything up to the first NUL */
+                    const char* argv0_end = static_cast<const char*>(std::memchr(cmdline, '\0', static_cast<size_t>(n)));
+                    if (argv0_end == nullptr) {
+                        argv0_end = cmdline + n;
+                    }
+
+                    const char* name = cmdline;
+                    for (const char* c = cmdline; c < argv0_end; ++c) {
+                        if (*c == '/') {
+                            name = c + 1;
+                        }
+                    }
+
+                    const size_t name_length = static_cast<size_t>(argv0_end - name);
+                    if (name_length == 0) {
+                        continue;
+                    }
+
+                    const u32 hash = process_hash(name, name_length);
+
+                    for (size_t slot = hash & (SLOTS - 1); set[slot] != 0xFF; slot = (slot + 1) & (SLOTS - 1)) {
+                        const process_entry& entry = entries[set[slot]];
+                        if (entry.hash == hash && std::strlen(entry.name) == name_length && std::memcmp(entry.name, name, name_length) == 0) {
+                            found |= (1ull << set[slot]);
+                        }
+                    }
+                }
             }
 
-            return false;
+            close(proc);
+            return found;
+        }
+    #endif
+
+        [[nodiscard]] static bool is_proc_running(const char* executable) {
+        #if (LINUX)
+            VMAWARE_ASSUME(executable != nullptr);
+            const process_entry entry(executable, brand_enum::NULL_BRAND);
+            return (find_processes(&entry, 1) != 0);
         #else
             VMAWARE_UNUSED(executable);
             return false;
@@ -5687,10 +8167,221 @@ public:
                     crc = _mm_crc32_u8(crc, ptr[i]);
                 }
 
-                return crc;
-            #else
-                return crc32c_sw(crc, data, len);
-            #endif
+                return crc;
+            #else
+                return crc32c_sw(crc, data, len);
+            #endif
+            }
+        };
+
+        /*
+         * Up to 64 byte patterns searched in a single sweep over a buffer, Teddy-style.
+         * Every pattern goes into one of 8 buckets, and the first three bytes at each
+         * position are looked up in nibble tables that give the buckets which could
+         * start there. Only positions with a non-zero bucket mask are checked against
+         * the patterns of those buckets. The SSSE3 path builds the masks for 16 positions
+         * at once with pshufb, the scalar path (every other CPU) does the same lookups
+         * one byte at a time.
+         */
+        struct pattern_set {
+            static constexpr size_t max_patterns = 64;
+            static constexpr size_t fingerprint = 3;
+            static constexpr size_t npos = static_cast<size_t>(-1);
+
+            struct pattern {
+                const u8* bytes;
+                size_t length;
+            };
+
+            pattern patterns[max_patterns] = {};
+            size_t count = 0;
+
+            u8 bucket_members[8][max_patterns] = {};
+            u8 bucket_size[8] = {};
+
+            /* Bucket bits for the low and high nibble of each fingerprint byte */
+            alignas(16) u8 lo_nibble[fingerprint][16] = {};
+            alignas(16) u8 hi_nibble[fingerprint][16] = {};
+
+            /* Add a pattern of at least 3 bytes, which has to outlive the set. Returns its index, or npos when full */
+            size_t add(const void* bytes, const size_t length) noexcept {
+                if (count == max_patterns || length < fingerprint) {
+                    return npos;
+                }
+
+                const u8* data = static_cast<const u8*>(bytes);
+
+                /*
+                 * Each new nibble bit lets a bucket match more unrelated positions, and each
+                 * pattern in it makes those matches slower to check. The bucket where the sum
+                 * of both grows the least takes the pattern.
+                 */
+                u8 bucket = 0;
+                size_t best_cost = npos;
+                for (u8 candidate = 0; candidate < 8; ++candidate) {
+                    const u8 bit = static_cast<u8>(1u << candidate);
+                    size_t cost = bucket_size[candidate];
+                    for (size_t i = 0; i < fingerprint; ++i) {
+                        cost += !(lo_nibble[i][data[i] & 0x0F] & bit);
+                        cost += !(hi_nibble[i][data[i] >> 4] & bit);
+                    }
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        bucket = candidate;
+                    }
+                }
+
+                const u8 bit = static_cast<u8>(1u << bucket);
+                for (size_t i = 0; i < fingerprint; ++i) {
+                    lo_nibble[i][data[i] & 0x0F] |= bit;
+                    hi_nibble[i][data[i] >> 4] |= bit;
+                }
+
+                bucket_members[bucket][bucket_size[bucket]++] = static_cast<u8>(count);
+                patterns[count].bytes = data;
+                patterns[count].length = length;
+                return count++;
+            }
+
+            /*
+             * Fill first[i] with the offset of the first match of pattern i (npos if there's none)
+             * and return the mask of the patterns found. Stops as soon as every pattern is found.
+             */
+            u64 scan(const u8* data, const size_t length, size_t* first) const noexcept {
+                for (size_t i = 0; i < count; ++i) {
+                    first[i] = npos;
+                }
+
+                if (count == 0 || data == nullptr || length < fingerprint) {
+                    return 0;
+                }
+
+                const u64 all = (count == 64) ? ~0ull : ((1ull << count) - 1);
+                u64 found = 0;
+                size_t pos = 0;
+
+            #if (x86)
+                if (has_ssse3()) {
+                    pos = scan_ssse3(data, length, first, found, all);
+                }
+            #endif
+
+                for (; pos + fingerprint <= length && found != all; ++pos) {
+                    const u8 buckets = static_cast<u8>(
+                        lo_nibble[0][data[pos] & 0x0F] & hi_nibble[0][data[pos] >> 4] &
+                        lo_nibble[1][data[pos + 1] & 0x0F] & hi_nibble[1][data[pos + 1] >> 4] &
+                        lo_nibble[2][data[pos + 2] & 0x0F] & hi_nibble[2][data[pos + 2] >> 4]
+                    );
+                    if (buckets) {
+                        verify(data, length, pos, buckets, first, found);
+                    }
+                }
+
+                return found;
+            }
+
+        private:
+            void verify(const u8* data, const size_t length, const size_t pos, u8 buckets, size_t* first, u64& found) const noexcept {
+                const u8* at = data + pos;
+
+                for (size_t bucket = 0; buckets != 0; ++bucket, buckets = static_cast<u8>(buckets >> 1)) {
+                    if (!(buckets & 1)) {
+                        continue;
+                    }
+
+                    for (size_t m = 0; m < bucket_size[bucket]; ++m) {
+                        const u8 index = bucket_members[bucket][m];
+                        const pattern& p = patterns[index];
+
+                        /* The nibble tables let false positives through, so the fingerprint is compared first */
+                        if (at[0] != p.bytes[0] || at[1] != p.bytes[1] || at[2] != p.bytes[2]) {
+                            continue;
+                        }
+
+                        const u64 bit = 1ull << index;
+                        if ((found & bit) || p.length > length - pos) {
+                            continue;
+                        }
+                        if (memcmp(at + fingerprint, p.bytes + fingerprint, p.length - fingerprint) == 0) {
+                            first[index] = pos;
+                            found |= bit;
+                        }
+                    }
+                }
+            }
+
+        #if (x86)
+            static bool has_ssse3() noexcept {
+                static const bool supported = []() noexcept -> bool {
+                    i32 regs[4];
+                    cpu::cpuid(regs, cpu::leaf::features);
+                    return (regs[2] & (1 << 9)) != 0;
+                }();
+
+                return supported;
+            }
+
+            /* Handles the positions whose whole fingerprint fits in 16-byte loads, and returns where the scalar tail picks up */
+        #if (GCC || CLANG)
+            __attribute__((__target__("ssse3")))
+        #endif
+            size_t scan_ssse3(const u8* data, const size_t length, size_t* first, u64& found, const u64 all) const noexcept {
+                const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+                const __m128i zero = _mm_setzero_si128();
+
+                __m128i lo[fingerprint];
+                __m128i hi[fingerprint];
+                for (size_t i = 0; i < fingerprint; ++i) {
+                    lo[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(lo_nibble[i]));
+                    hi[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(hi_nibble[i]));
+                }
+
+                size_t pos = 0;
+                for (; pos + 16 + fingerprint - 1 <= length && found != all; pos += 16) {
+                    __m128i candidates = _mm_set1_epi8(static_cast<char>(0xFF));
+
+                    for (size_t i = 0; i < fingerprint; ++i) {
+                        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + i));
+                        const __m128i mask = _mm_and_si128(
+                            _mm_shuffle_epi8(lo[i], _mm_and_si128(bytes, nibble_mask)),
+                            _mm_shuffle_epi8(hi[i], _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble_mask))
+                        );
+                        candidates = _mm_and_si128(candidates, mask);
+                    }
+
+                    int positions = _mm_movemask_epi8(_mm_cmpeq_epi8(candidates, zero)) ^ 0xFFFF;
+                    if (positions == 0) {
+                        continue;
+                    }
+
+                    alignas(16) u8 buckets[16];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(buckets), candidates);
+
+                    for (size_t lane = 0; positions != 0; ++lane, positions >>= 1) {
+                        if (positions & 1) {
+                            verify(data, length, pos + lane, buckets[lane], first, found);
+                        }
+                    }
+                }
+
+                return pos;
+            }
+        #endif
+        };
+
+        /* A scratch buffer that keeps its memory between uses, so a loop over many files only allocates for the largest one */
+        struct scratch_buffer {
+            std::unique_ptr<u8[]> data;
+            size_t capacity = 0;
+
+            /* At least size bytes, or nullptr if they couldn't be allocated. The old contents are not kept */
+            u8* reserve(const size_t size) noexcept {
+                if (size > capacity) {
+                    const size_t grown = (std::max)(size, capacity * 2);
+                    data.reset(new (std::nothrow) u8[grown]);
+                    capacity = data ? grown : 0;
+                }
+                return data.get();
             }
         };
     };
@@ -5770,67 +8461,90 @@ public:
         static constexpr const char* CONTAINERD = "Containerd";
 
         static brand_list_t brand_list(const flagset& flags) {
-            if (memo::brand_list::is_cached(flags)) {
-                return memo::brand_list::fetch();
+            brand_list_t cached_list;
+            if (memo::brand_list::fetch(flags, cached_list)) {
+                return cached_list;
             }
 
-            /* Run all the techniques */
-            const u16 score = core::run_all(flags);
+            /* Run all the techniques, and work off this run's own tally rather than the shared scoreboard */
+            core::run_result run;
+            const u16 score = core::run_all(flags, false, run);
+            core::publish(run);
+
+            const brand_list_t active_brands = brand_list(run.hits, score);
+            memo::brand_list::store(active_brands, flags);
+            return active_brands;
+        }
+
+        /* Filter, merge and rank the brand hits of a finished run as a vector */
+        static brand_list_t brand_list(const std::array<brand_score_t, MAX_BRANDS>& hits, const u16 score) {
+            brand_set ranked;
+            rank(hits, score, ranked);
+            return brand_list_t(ranked.begin(), ranked.end());
+        }
+
+        /* Filter, merge and rank the brand hits of a finished run, without allocating */
+        static void rank(const std::array<brand_score_t, MAX_BRANDS>& hits, const u16 score, brand_set& out) noexcept {
+            brand_array_t& active_brands = out.entries;
+            out.count = 0;
 
-            brand_list_t active_brands = {};
-            active_brands.reserve(MAX_BRANDS);
+            /* Every brand index shows up at most once, so this can never overflow MAX_BRANDS */
+            auto push = [&](const enum brand_enum brand, const brand_score_t points) noexcept {
+                active_brands[out.count++] = std::make_pair(brand, points);
+            };
 
             for (size_t i = 0; i < MAX_BRANDS; ++i) {
-                if (core::brand_scoreboard.at(i).score > 0) {
-                    active_brands.emplace_back(std::make_pair(core::brand_scoreboard.at(i).name, core::brand_scoreboard.at(i).score));
+                if (hits[i] > 0) {
+                    push(static_cast<brand_enum>(i), hits[i]);
                 }
             }
 
-            /* Simple helper lambda for early filtering */
+            /* Simple helper lambda for early filtering, keeps the order of what's left */
             auto remove = [&](const enum brand_enum brand) noexcept {
-                for (auto it = active_brands.begin(); it != active_brands.end(); ++it) {
-                    if (it->first == brand) {
-                        active_brands.erase(it);
+                for (u8 i = 0; i < out.count; ++i) {
+                    if (active_brands[i].first == brand) {
+                        for (u8 j = static_cast<u8>(i + 1); j < out.count; ++j) {
+                            active_brands[j - 1] = active_brands[j];
+                        }
+                        --out.count;
                         return;
                     }
                 }
             };
 
             /* If all brands have a point of 0, return "Unknown" */
-            if (active_brands.empty()) {
-                active_brands.emplace_back(brand_enum::NULL_BRAND, 0);
-                memo::brand_list::store(active_brands, flags);
-                return active_brands;
+            if (out.empty()) {
+                push(brand_enum::NULL_BRAND, 0);
+                return;
             }
 
             /* If there's only a single brand, return it immediately */
-            if (active_brands.size() == 1) {
-                const enum brand_enum brand = active_brands.front().first;
+            if (out.size() == 1) {
+                const enum brand_enum brand = out.front().first;
 
                 if (brand == brand_enum::HYPERV_ROOT && score > 0) {
-                    active_brands.emplace_back(brand_enum::NULL_BRAND, 0);
+                    push(brand_enum::NULL_BRAND, 0);
                     remove(brand_enum::HYPERV_ROOT);
                 }
 
-                memo::brand_list::store(active_brands, flags);
-                return active_brands;
+                return;
             }
 
             /* Remove Hyper-V artifacts and Unknown if found alongside other brands */
-            if (active_brands.size() > 1) {
+            if (out.size() > 1) {
                 remove(brand_enum::HYPERV_ROOT);
                 remove(brand_enum::NULL_BRAND);
                 remove(brand_enum::INVALID);
             }
 
-            /* If filtering emptied the vector, fall back to NULL_BRAND */
-            if (active_brands.empty()) {
-                active_brands.emplace_back(brand_enum::NULL_BRAND, 0);
+            /* If filtering emptied the list, fall back to NULL_BRAND */
+            if (out.empty()) {
+                push(brand_enum::NULL_BRAND, 0);
             }
 
             /* Capture initial hit presence */
             std::bitset<MAX_BRANDS> brand_hits = {};
-            for (const auto& brand : active_brands) {
+            for (const auto& brand : out) {
                 brand_hits.set(static_cast<u8>(brand.first));
             }
 
@@ -5888,7 +8602,7 @@ public:
             std::bitset<MAX_BRANDS> current_active = brand_hits;
             std::array<brand_score_t, MAX_BRANDS> active_scores{};
 
-            for (const auto& brand : active_brands) {
+            for (const auto& brand : out) {
                 active_scores[static_cast<u8>(brand.first)] = brand.second;
             }
 
@@ -5915,24 +8629,238 @@ public:
             }
 
             /* Reconstruct active list */
-            active_brands.clear();
+            out.count = 0;
             for (size_t i = 0; i < MAX_BRANDS; ++i) {
                 if (current_active.test(i)) {
-                    active_brands.emplace_back(static_cast<brand_enum>(i), active_scores[i]);
+                    push(static_cast<brand_enum>(i), active_scores[i]);
                 }
             }
 
-            if (active_brands.size() > 1) {
-                std::sort(active_brands.begin(), active_brands.begin() + static_cast<std::ptrdiff_t>(active_brands.size()), [](
+            if (out.size() > 1) {
+                std::sort(active_brands.begin(), active_brands.begin() + static_cast<std::ptrdiff_t>(out.size()), [](
                     const brand_element_t& a,
                     const brand_element_t& b
                 ) {
                     return a.second > b.second; /* .second is brand score */  
                 } );
             }
+        }
 
-            memo::brand_list::store(active_brands, flags);
-            return active_brands;
+        /*
+         * The conclusion message for a given percentage and brand list, handed to append() one
+         * piece at a time so VM::conclusion() and VM::conclusion_into() build the same text
+         * whether it ends up in a std::string or in a caller's buffer
+         */
+        template <typename List, typename Append>
+        static void conclusion_parts(const flagset& flags, const u8 percent, const List& list, Append append) {
+            constexpr const char* very_unlikely = "Very unlikely";
+            constexpr const char* unlikely = "Unlikely";
+            constexpr const char* potentially = "Potentially";
+            constexpr const char* might = "Might be";
+            constexpr const char* likely = "Likely";
+            constexpr const char* very_likely = "Very likely";
+            constexpr const char* inside_vm = "Running inside";
+        
+            auto make_conclusion = [&](const char* category) {
+                const brand_enum first_brand = list.front().first;
+
+                const char* addition = " a ";
+
+                /*
+                 * This basically just fixes the grammatical syntax
+                 * by either having "a" or "an" before the VM brand
+                 * name. It would look weird if the conclusion
+                 * message was "an VirtualBox" or "a Anubis"
+                 */
+                if 
+                ( 
+                    (first_brand == brand_enum::ACRN)        ||
+                    (first_brand == brand_enum::ANUBIS)      ||
+                    (first_brand == brand_enum::BSD_VMM)     ||
+                    (first_brand == brand_enum::INTEL_HAXM)  ||
+                    (first_brand == brand_enum::APPLE_VZ)    ||
+                    (first_brand == brand_enum::INTEL_KGT)   ||
+                    (first_brand == brand_enum::POWERVM)     ||
+                    (first_brand == brand_enum::OPENSTACK)   ||
+                    (first_brand == brand_enum::AWS_NITRO)   ||
+                    (first_brand == brand_enum::OPENVZ)      ||
+                    (first_brand == brand_enum::INTEL_TDX)   ||
+                    (first_brand == brand_enum::AMD_SEV)     ||
+                    (first_brand == brand_enum::AMD_SEV_ES)  ||
+                    (first_brand == brand_enum::AMD_SEV_SNP) ||
+                    (first_brand == brand_enum::NULL_BRAND)              
+                )   
+                {             addition = " an ";             }
+
+                append(category);
+                append(addition);
+
+                /*
+                 * This is basically just to remove the capital "U",
+                 * since it doesn't make sense to see "an Unknown"
+                 */
+                if (first_brand == brand_enum::NULL_BRAND) {
+                    append("unknown");
+                } 
+                else if (core::is_enabled(flags, MULTIPLE)) {
+                    /* Same as brand_multiple() */
+                    append(brand_enum_to_string(list[0].first));
+                    for (size_t i = 1; i < list.size(); i++) {
+                        append(" or ");
+                        append(brand_enum_to_string(list[i].first));
+                    }
+                } 
+                else {
+                    append(brand_enum_to_string(first_brand));
+                }
+
+                /* Hyper-V artifacts are an exception due to how unique the circumstance is */
+                if (first_brand != brand_enum::HYPERV_ROOT) {
+                    append(" VM");
+                }
+            };
+
+            if (core::is_enabled(flags, DYNAMIC)) {
+                if (percent == 0)  { append("Running on bare metal");  return; }
+                if (percent <= 20) { make_conclusion(very_unlikely);   return; }
+                if (percent <= 35) { make_conclusion(unlikely);        return; }
+                if (percent < 50)  { make_conclusion(potentially);     return; }
+                if (percent <= 62) { make_conclusion(might);           return; }
+                if (percent <= 75) { make_conclusion(likely);          return; }
+                if (percent < 100) { make_conclusion(very_likely);     return; }
+            }
+
+            if (percent == 100) {
+                make_conclusion(inside_vm);
+                return;
+            }
+
+            append("Running on bare metal");
+        }
+
+        /* The conclusion message for a given percentage and brand list, for VM::conclusion() */
+        static std::string conclusion(const flagset& flags, const u8 percent, const brand_list_t& list) {
+            std::string result;
+            conclusion_parts(flags, percent, list, [&result](const char* part) { result += part; });
+            return result;
+        }
+
+        /*
+         * Same as above into a caller's buffer, for VM::conclusion_into(). Returns the length of
+         * the whole message like snprintf() does, whatever didn't fit is left out
+         */
+        static size_t conclusion(char* buffer, const size_t capacity, const flagset& flags, const u8 percent, const brand_set& list) noexcept {
+            size_t length = 0;
+
+            conclusion_parts(flags, percent, list, [&](const char* part) noexcept {
+                for (; *part != '\0'; ++part, ++length) {
+                    if (length + 1 < capacity) {
+                        buffer[length] = *part;
+                    }
+                }
+            });
+
+            if (capacity > 0) {
+                buffer[(length < capacity) ? length : (capacity - 1)] = '\0';
+            }
+
+            return length;
+        }
+
+        /* The kind of VM behind the most likely brand, for VM::type() */
+        static const char* brand_type(const brand_list_t& list, const bool multiple) noexcept {
+            if (multiple && list.size() > 1) {
+                return "Unknown";
+            }
+
+            return brand_type(brand_single(list));
+        }
+
+        static const char* brand_type(const brand_set& list, const bool multiple) noexcept {
+            if (multiple && list.size() > 1) {
+                return "Unknown";
+            }
+
+            return brand_type(list.front().first);
+        }
+
+        static const char* brand_type(const enum brand_enum brand) noexcept {
+            switch (brand) {
+                case brand_enum::XEN: return "Hypervisor (Type 1)";
+                case brand_enum::VMWARE_ESX: return "Hypervisor (Type 1)";
+                case brand_enum::ACRN: return "Hypervisor (Type 1)";
+                case brand_enum::QNX: return "Hypervisor (Type 1)";
+                case brand_enum::HYPERV: return "Hypervisor (Type 2)"; /* to clarify you're running under a Hyper-V guest VM */
+                case brand_enum::AZURE_HYPERV: return "Hypervisor (Type 1)";
+                case brand_enum::KVM: return "Hypervisor (Type 1)";
+                case brand_enum::KVM_HYPERV: return "Hypervisor (Type 1)";
+                case brand_enum::QEMU_KVM_HYPERV: return "Hypervisor (Type 1)";
+                case brand_enum::QEMU_KVM: return "Hypervisor (Type 1)";
+                case brand_enum::INTEL_KGT: return "Hypervisor (Type 1)";
+                case brand_enum::SIMPLEVISOR: return "Hypervisor (Type 1)";
+                case brand_enum::OPENSTACK: return "Hypervisor (Type 1)";
+                case brand_enum::KUBEVIRT: return "Hypervisor (Type 1)";
+                case brand_enum::POWERVM: return "Hypervisor (Type 1)";
+                case brand_enum::AWS_NITRO: return "Hypervisor (Type 1)";
+                case brand_enum::LKVM: return "Hypervisor (Type 1)";
+                case brand_enum::NOIRVISOR: return "Hypervisor (Type 1)";
+                case brand_enum::WSL: return "Hypervisor (Type 1)";  /* Type 1-derived lightweight VM system */
+                case brand_enum::DBVM: return "Hypervisor (Type 1)" ;
+                case brand_enum::BHYVE: return "Hypervisor (Type 2)";
+                case brand_enum::VBOX: return "Hypervisor (Type 2)";
+                case brand_enum::VMWARE: return "Hypervisor (Type 2)";
+                case brand_enum::VMWARE_EXPRESS: return "Hypervisor (Type 2)";
+                case brand_enum::VMWARE_GSX: return "Hypervisor (Type 2)";
+                case brand_enum::VMWARE_WORKSTATION: return "Hypervisor (Type 2)";
+                case brand_enum::VMWARE_FUSION: return "Hypervisor (Type 2)";
+                case brand_enum::PARALLELS: return "Hypervisor (Type 2)";
+                case brand_enum::VPC: return "Hypervisor (Type 2)";
+                case brand_enum::NVMM: return "Hypervisor (Type 2)";
+                case brand_enum::BSD_VMM: return "Hypervisor (Type 2)";
+                case brand_enum::HYPERV_VPC: return "Hypervisor (Type 2)";
+                case brand_enum::VMWARE_HARD: return "Hypervisor (Type 2)";
+                case brand_enum::UTM: return "Hypervisor (Type 2)";
+                case brand_enum::INTEL_HAXM: return "Hosted hypervisor / accelerator (Type 2)";
+                case brand_enum::CUCKOO: return "Sandbox";
+                case brand_enum::SANDBOXIE: return "Sandbox";
+                case brand_enum::HYBRID: return "Sandbox";
+                case brand_enum::CWSANDBOX: return "Sandbox";
+                case brand_enum::JOEBOX: return "Sandbox";
+                case brand_enum::ANUBIS: return "Sandbox";
+                case brand_enum::COMODO: return "Sandbox";
+                case brand_enum::THREATEXPERT: return "Sandbox";
+                case brand_enum::QIHOO: return "Sandbox";
+                case brand_enum::BOCHS: return "Emulator";
+                case brand_enum::BLUESTACKS: return "Emulator";
+                case brand_enum::NEKO_PROJECT: return "Emulator";
+                case brand_enum::COMPAQ: return "Emulator";
+                case brand_enum::INSIGNIA: return "Emulator";
+                case brand_enum::CONNECTIX: return "Emulator";
+                case brand_enum::QEMU: return "Emulator/Hypervisor (Type 2)";
+                case brand_enum::JAILHOUSE: return "Partitioning Hypervisor";
+                case brand_enum::UNISYS: return "Partitioning Hypervisor";
+                case brand_enum::DOCKER: return "Container";
+                case brand_enum::PODMAN: return "Container";
+                case brand_enum::OPENVZ: return "Container";
+                case brand_enum::CONTAINERD: return "Container";
+                case brand_enum::LMHS: return "Hypervisor (unknown type)";
+                case brand_enum::WINE: return "Compatibility layer";
+                case brand_enum::INTEL_TDX: return "Trusted Domain";
+                case brand_enum::APPLE_VZ: return "Unknown";
+                case brand_enum::UML: return "Paravirtualised/Hypervisor (Type 2)";
+                case brand_enum::AMD_SEV: return "VM encryptor";
+                case brand_enum::AMD_SEV_ES: return "VM encryptor";
+                case brand_enum::AMD_SEV_SNP: return "VM encryptor";
+                case brand_enum::GCE: return "Cloud VM service";
+                case brand_enum::BAREVISOR: return "Hypervisor (Type 1)";
+                case brand_enum::HYPERPLATFORM: return "Hypervisor (Type 1)";
+                case brand_enum::MINIVISOR: return "Hypervisor (Type 1)";
+                case brand_enum::HYPERV_ROOT: return "Host machine"; /* this refers to the type 1 hypervisor where Windows normally runs under, we put "Host machine" to clarify you're not running under a traditional VM if this is detected */
+                case brand_enum::NULL_BRAND: return "Unknown";
+                case brand_enum::INVALID: return "Invalid";
+            }
+
+            return "Invalid";
         }
 
         static VMAWARE_CONSTEXPR const char* brand_enum_to_string(const brand_enum brand) noexcept {
@@ -6029,8 +8957,9 @@ public:
         }
 
         static std::string brand_multiple(const flagset& flags = core::generate_default()) {
-            if (memo::multi_brand::is_cached(flags)) {
-                return memo::multi_brand::fetch();
+            std::string cached_brand;
+            if (memo::multi_brand::fetch(flags, cached_brand)) {
+                return cached_brand;
             }
 
             const brand_list_t& list = brands::brand_list(flags);
@@ -6047,8 +8976,9 @@ public:
         }
 
         static brand_enum brand_single(const flagset& flags = core::generate_default()) {
-            if (memo::single_brand::is_cached(flags)) {
-                return memo::single_brand::fetch();
+            brand_enum cached_brand = brand_enum::NULL_BRAND;
+            if (memo::single_brand::fetch(flags, cached_brand)) {
+                return cached_brand;
             }
 
             const brand_list_t& list = brands::brand_list(flags);
@@ -6372,60 +9302,57 @@ public:
 
         #else
 
-            {
-                std::ifstream f("/sys/devices/system/cpu/smt/control");
-                if (f) {
-                    std::string s;
-                    if (std::getline(f, s)) {
-                        string::trim_inplace(s);
+            /* Keeps the first line of a small sysfs attribute, without the surrounding whitespace */
+            auto read_line = [](const char* path, char* buffer, const size_t capacity) -> const char* {
+                if (util::read_into(path, buffer, capacity) <= 0) {
+                    return nullptr;
+                }
 
-                        if (s == "on") {
-                            return true;
-                        }
+                char* end = buffer;
+                while (*end && *end != '\n') {
+                    ++end;
+                }
+                while (end > buffer && string::is_space(*(end - 1))) {
+                    --end;
+                }
+                *end = '\0';
 
-                        if (s == "off" || s == "forceoff" || s == "notsupported") {
-                            return false;
-                        }
-                    }
+                return string::ltrim(buffer);
+            };
+
+            char line[256];
+
+            if (const char* s = read_line(util::file_paths::smt_control, line, sizeof(line))) {
+                if (std::strcmp(s, "on") == 0) {
+                    return true;
                 }
-            }
 
-            {
-                std::ifstream f("/sys/devices/system/cpu/smt/active");
-                if (f) {
-                    std::string s;
-                    if (std::getline(f, s)) {
-                        string::trim_inplace(s);
+                if (std::strcmp(s, "off") == 0 || std::strcmp(s, "forceoff") == 0 || std::strcmp(s, "notsupported") == 0) {
+                    return false;
+                }
+            }
 
-                        if (s == "1") {
-                            return true;
-                        }
+            if (const char* s = read_line(util::file_paths::smt_active, line, sizeof(line))) {
+                if (std::strcmp(s, "1") == 0) {
+                    return true;
+                }
 
-                        if (s == "0") {
-                            return false;
-                        }
-                    }
+                if (std::strcmp(s, "0") == 0) {
+                    return false;
                 }
             }
 
-            {
-                std::ifstream f("/sys/devices/system/cpu/cpu0/topology/thread_siblings_list");
-                if (f) {
-                    std::string s;
-                    if (std::getline(f, s)) {
-                        string::trim_inplace(s);
-
-                        for (char ch : s) {
-                            if (ch == ',' || ch == '-') {
-                                return true;
-                            }
-                        }
+            if (const char* s = read_line(util::file_paths::thread_siblings, line, sizeof(line))) {
+                for (; *s; ++s) {
+                    if (*s == ',' || *s == '-') {
+                        return true;
                     }
                 }
             }
 
             {
-                std::ifstream cpuinfo("/proc/cpuinfo");
+                /* Through util::read_file() so UML_CPU's read of the same file is shared during a run */
+                std::istringstream cpuinfo(util::read_file(util::file_paths::cpuinfo));
                 if (cpuinfo) {
                     std::string line;
                     int siblings = -1;
@@ -6477,9 +9404,10 @@ public:
 
         constexpr size_t max_model_len = 32;
         cpu::cpu_type type = cpu::cpu_type::UNKNOWN;
-        size_t db_size = 0;
-        const cpu::cpu_entry* db = nullptr;
-        const cpu::cpu_entry* matched = nullptr;
+        cpu::cpu_db db;
+        bool matched = false;
+        u32 expected_threads = 0;
+        bool model_expects_smt = false;
         const char* model_name = nullptr;
 
         if (cpu::is_intel()) {
@@ -6489,25 +9417,25 @@ public:
 
                 if (strstr(model_name, "Ultra") != nullptr) {
                     type = cpu::cpu_type::INTEL_ULTRA;
-                    cpu::get_intel_ultra_db(db, db_size);
+                    db = cpu::get_intel_ultra_db();
                 }
                 else if (model.is_i_series) {
                     type = cpu::cpu_type::INTEL_I;
-                    cpu::get_intel_core_db(db, db_size);
+                    db = cpu::get_intel_core_db();
                 }
                 else if (model.is_xeon) {
                     type = cpu::cpu_type::INTEL_XEON;
-                    cpu::get_intel_xeon_db(db, db_size);
+                    db = cpu::get_intel_xeon_db();
                 }
             }
         }
         else if (cpu::is_amd()) {
             type = cpu::cpu_type::AMD;
             model_name = cpu::get_brand();
-            cpu::get_amd_ryzen_db(db, db_size);
+            db = cpu::get_amd_ryzen_db();
         }
 
-        if (model_name != nullptr && db != nullptr && model_name[0] != '\0') {
+        if (model_name != nullptr && db.hashes != nullptr && model_name[0] != '\0') {
             const char* str = model_name;
 
             for (size_t i = 0; str[i] != '\0'; ) {
@@ -6554,14 +9482,9 @@ public:
                         (next >= 'A' && next <= 'Z') ||
                         (next >= 'a' && next <= 'z');
 
-                    if (!next_is_alnum) {
-                        for (size_t idx = 0; idx < db_size; ++idx) {
-                            if (db[idx].hash == current_hash) {
-                                if (matched == nullptr || current_len > 0) {
-                                    matched = &db[idx];
-                                }
-                            }
-                        }
+                    /* The last model found in the brand string is the one that counts */
+                    if (!next_is_alnum && db.find(current_hash, expected_threads, model_expects_smt)) {
+                        matched = true;
                     }
                 }
 
@@ -6569,14 +9492,13 @@ public:
             }
         }
 
-        if (matched == nullptr) {
+        if (!matched) {
             return false;
         }
 
         debug("CPU model = ", model_name);
 
         const u32 actual = memo::thread_count::fetch();
-        const bool model_expects_smt = matched->smt;
 
         if (!model_expects_smt) {
             if (is_smt_active()) {
@@ -6585,9 +9507,9 @@ public:
             }
         }
 
-        if (actual != matched->threads) {
+        if (actual != expected_threads) {
             debug("THREAD_MISMATCH: Current threads -> ", actual);
-            debug("THREAD_MISMATCH: Expected threads -> ", matched->threads);
+            debug("THREAD_MISMATCH: Expected threads -> ", expected_threads);
             return true;
         }
 
@@ -6654,18 +9576,18 @@ public:
              * leaf 1's Initial APIC ID is the ABA guard
              */
             for (;;) {
-                cpu::cpuid(l1_eax, l1_ebx, l1_ecx, l1_edx, cpu::leaf::features, 0);
+                cpu::cpuid_live(l1_eax, l1_ebx, l1_ecx, l1_edx, cpu::leaf::features, 0);
                 aba_start = (l1_ebx >> 24) & 0xFF; /* Initial APIC ID */
 
                 if (has_leaf_b) {
-                    cpu::cpuid(vb_eax, vb_ebx, vb_ecx, vb_edx, cpu::leaf::ext_topology, 0);
+                    cpu::cpuid_live(vb_eax, vb_ebx, vb_ecx, vb_edx, cpu::leaf::ext_topology, 0);
                 }
 
                 if (has_leaf_1f) {
-                    cpu::cpuid(v1f_eax, v1f_ebx, v1f_ecx, v1f_edx, cpu::leaf::v2_ext_topology, 0);
+                    cpu::cpuid_live(v1f_eax, v1f_ebx, v1f_ecx, v1f_edx, cpu::leaf::v2_ext_topology, 0);
                 }
 
-                cpu::cpuid(unused, l1_ebx, unused, unused, cpu::leaf::features, 0);
+                cpu::cpuid_live(unused, l1_ebx, unused, unused, cpu::leaf::features, 0);
                 aba_end = (l1_ebx >> 24) & 0xFF;
 
                 if (aba_start == aba_end || ++retries >= 8) { 
@@ -7312,26 +10234,17 @@ public:
 
 #if (LINUX)
     /**
-     * @brief Check result from systemd-detect-virt tool
+     * @brief Check whether systemd-detect-virt would report a VM or container, without running it
+     * @note The tool doesn't have to be installed, so this also fires on hosts without systemd
      * @category Linux
      * @implements VM::SYSTEMD
      */
     [[nodiscard]] static bool systemd_virt() {
-        if (!(util::exists("/usr/bin/systemd-detect-virt") || util::exists("/bin/systemd-detect-virt"))) {
-            debug("SYSTEMD: ", "binary doesn't exist");
-            return false;
-        }
-
-        const std::unique_ptr<std::string> result = util::sys_result("systemd-detect-virt");
-
-        if (result == nullptr) {
-            debug("SYSTEMD: ", "invalid stdout output from systemd-detect-virt");
-            return false;
-        }
+        const char* id = util::virt_id::get();
 
-        debug("SYSTEMD: ", "output = ", *result);
+        debug("SYSTEMD: ", "id = ", id);
 
-        return (*result != "none");
+        return (std::strcmp(id, "none") != 0);
     }
 
 
@@ -7341,18 +10254,16 @@ public:
      * @implements VM::CVENDOR
      */
     [[nodiscard]] static bool chassis_vendor() {
-        const char* vendor_file = "/sys/devices/virtual/dmi/id/chassis_vendor";
+        const char* vendor = util::smbios::get().chassis.manufacturer.c_str();
 
-        if (!util::exists(vendor_file)) {
-            debug("CVENDOR: ", "file doesn't exist");
+        if (vendor[0] == '\0') {
+            debug("CVENDOR: ", "no chassis vendor");
             return false;
         }
 
-        const std::string vendor = util::read_file(vendor_file);
-
         /* TODO: More can definitely be added, only QEMU and VBox were tested so far */
-        if (util::find(vendor, "QEMU")) { return core::add(brand_enum::QEMU); }
-        if (util::find(vendor, "Oracle Corporation")) { return core::add(brand_enum::VBOX); }
+        if (string::find(vendor, "QEMU")) { return core::add(brand_enum::QEMU); }
+        if (string::find(vendor, "Oracle Corporation")) { return core::add(brand_enum::VBOX); }
 
         debug("CVENDOR: vendor = ", vendor);
 
@@ -7366,20 +10277,15 @@ public:
      * @implements VM::CTYPE
      */
     [[nodiscard]] static bool chassis_type() {
-        const char* chassis = "/sys/devices/virtual/dmi/id/chassis_type";
+        const util::smbios::chassis_record& chassis = util::smbios::get().chassis;
 
-        if (util::exists(chassis)) {
-            try {
-                return (std::stoi(util::read_file(chassis)) == 1);
-            }
-            catch (...) {
-                return false;
-            }
+        if (!chassis.has_type) {
+            debug("CTYPE: ", "no chassis type");
+            return false;
         }
 
-        debug("CTYPE: ", "file doesn't exist");
-
-        return false;
+        /* 1 is "Other" */
+        return (chassis.type == 1);
     }
 
 
@@ -7389,7 +10295,7 @@ public:
      * @implements VM::DOCKERENV
      */
     [[nodiscard]] static bool dockerenv() {
-        if (util::exists("/.dockerenv") || util::exists("/.dockerinit")) {
+        if (util::exists(util::file_paths::dockerenv) || util::exists(util::file_paths::dockerinit)) {
             return core::add(brand_enum::DOCKER);
         }
 
@@ -7398,46 +10304,39 @@ public:
 
 
     /**
-     * @brief Check if dmidecode output matches a VM brand
+     * @brief Check if the SMBIOS system information matches a VM brand, which is what dmidecode -t system would show
      * @category Linux
      * @warning Permissions required
      * @implements VM::DMIDECODE
      */
     [[nodiscard]] static bool dmidecode() {
-        if (!util::is_admin()) {
-            debug("DMIDECODE: ", "precondition return called (root = ", util::is_admin(), ")");
-            return false;
-        }
+        const util::smbios& table = util::smbios::get();
 
-        if (!(util::exists("/bin/dmidecode") || util::exists("/usr/bin/dmidecode"))) {
-            debug("DMIDECODE: ", "binary doesn't exist");
+        /* Only the raw table counts here, the sysfs attributes are already covered by DMI_SCAN */
+        if (!table.from_table) {
+            debug("DMIDECODE: ", "precondition return called (SMBIOS table readable = ", table.from_table, ")");
             return false;
         }
 
-        const std::unique_ptr<std::string> result = util::sys_result("dmidecode -t system | grep 'Manufacturer|Product' | grep -c \"QEMU|VirtualBox|KVM\"");
+        const std::array<const std::string*, 2> fields{ { &table.system.manufacturer, &table.system.product } };
 
-        if (!result || result->empty()) {
-            debug("DMIDECODE: ", "invalid output");
-            return false;
-        }
-        
-        if (*result == "QEMU") {
-            return core::add(brand_enum::QEMU);
-        }
-        
-        if (*result == "VirtualBox") {
-            return core::add(brand_enum::VBOX);
-        }
-        
-        if (*result == "KVM") {
-            return core::add(brand_enum::KVM);
-        } 
-        
-        if (std::strtol(result->c_str(), nullptr, 10) >= 1) {
-            return true;
+        for (const std::string* field : fields) {
+            const char* value = field->c_str();
+
+            if (string::find(value, "QEMU")) {
+                return core::add(brand_enum::QEMU);
+            }
+
+            if (string::find(value, "VirtualBox")) {
+                return core::add(brand_enum::VBOX);
+            }
+
+            if (string::find(value, "KVM")) {
+                return core::add(brand_enum::KVM);
+            }
         }
-         
-        debug("DMIDECODE: ", "output = ", *result);
+
+        debug("DMIDECODE: ", "manufacturer = ", table.system.manufacturer, ", product = ", table.system.product);
 
         return false;
     }
@@ -7560,46 +10459,29 @@ public:
 
 
     /**
-     * @brief Check if dmesg output matches a VM brand
+     * @brief Check if a hypervisor line in the kernel log, as dmesg would show it, matches a VM brand
      * @category Linux
      * @warning Permissions required
      * @implements VM::DMESG
      */
     [[nodiscard]] static bool dmesg() {
-    #if (VMAWARE_CPP <= 11)
-        return false;
-    #else
         if (!util::is_admin()) {
             return false;
         }
 
-        if (!util::exists("/bin/dmesg") && !util::exists("/usr/bin/dmesg")) {
-            debug("DMESG: ", "binary doesn't exist");
-            return false;
-        }
-
-        const std::unique_ptr<std::string> result = util::sys_result("dmesg | grep -i hypervisor | grep -c \"KVM|QEMU\"");
+        const util::kernel_log& log = util::kernel_log::get();
 
-        if (!result || result->empty()) {
-            return false;
-        }
-        
-        if (*result == "KVM") {
+        if (log.kvm) {
             return core::add(brand_enum::KVM);
         }
-        
-        if (*result == "QEMU") {
+
+        if (log.qemu) {
             return core::add(brand_enum::QEMU);
         }
-        
-        if (std::strtol(result->c_str(), nullptr, 10)) {
-            return true;
-        }
 
-        debug("DMESG: ", "output = ", *result);
+        debug("DMESG: ", "kernel log readable = ", log.readable);
 
         return false;
-    #endif
     }
 
 
@@ -7609,7 +10491,7 @@ public:
      * @implements VM::HWMON
      */
     [[nodiscard]] static bool hwmon() {
-        return (!util::exists("/sys/class/hwmon/"));
+        return (!util::exists(util::file_paths::hwmon));
     }
 
 
@@ -7651,8 +10533,8 @@ public:
         return false;
     #else
         if (
-            util::exists("/mnt/windows/BstSharedFolder") ||
-            util::exists("/sdcard/windows/BstSharedFolder")
+            util::exists(util::file_paths::bluestacks_mnt) ||
+            util::exists(util::file_paths::bluestacks_sdcard)
         ) {
             return core::add(brand_enum::BLUESTACKS);
         }
@@ -7734,14 +10616,17 @@ public:
      * @implements VM::QEMU_VIRTUAL_DMI
      */
     [[nodiscard]] static bool qemu_virtual_dmi() {
-        const char* sys_vendor = "/sys/devices/virtual/dmi/id/sys_vendor";
-        const char* modalias = "/sys/devices/virtual/dmi/id/modalias";
+        const char* sys_vendor = util::file_paths::sys_vendor;
+        const char* modalias = util::file_paths::modalias;
 
-        if (util::exists(sys_vendor) && util::exists(modalias)) {
-            const std::string sys_vendor_str = util::read_file(sys_vendor);
-            const std::string modalias_str = util::read_file(modalias);
+        char sys_vendor_str[256];
+        char modalias_str[512];
 
-            if (util::find(sys_vendor_str, "QEMU") && util::find(modalias_str, "QEMU")) {
+        if (
+            util::read_into(sys_vendor, sys_vendor_str, sizeof(sys_vendor_str)) >= 0 &&
+            util::read_into(modalias, modalias_str, sizeof(modalias_str)) >= 0
+        ) {
+            if (string::find(sys_vendor_str, "QEMU") && string::find(modalias_str, "QEMU")) {
                 return core::add(brand_enum::QEMU);
             }
         }
@@ -7763,19 +10648,9 @@ public:
 
         constexpr const char* usb_path = "/sys/kernel/debug/usb/devices";
 
-        std::ifstream file(usb_path);
-        if (!file) {
-            return false;
-        }
-
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.find("QEMU") != std::string::npos) {
-                return true;
-            }
-        }
+        const std::string content = util::read_file(usb_path);
 
-        return false;
+        return util::find(content, "QEMU");
     }
 
 
@@ -7817,17 +10692,11 @@ public:
 
         dir.reset();
 
-        bool type = false;
-
-        if (util::exists("/sys/hypervisor/type")) {
-            type = true;
-        }
+        char content[64];
+        const bool type = (util::read_into(util::file_paths::hypervisor_type, content, sizeof(content)) >= 0);
 
-        if (type) {
-            const std::string content = util::read_file("/sys/hypervisor/type");
-            if (util::find(content, "xen")) {
-                return core::add(brand_enum::XEN);
-            }
+        if (type && string::find(content, "xen")) {
+            return core::add(brand_enum::XEN);
         }
 
         /* Check if there's a few files in that directory */
@@ -7850,14 +10719,10 @@ public:
         }
 
         /* Method 2, match for the "User Mode Linux" string in /proc/cpuinfo */
-        const char* file = "/proc/cpuinfo";
-
-        if (util::exists(file)) {
-            const std::string file_content = util::read_file(file);
+        const std::string file_content = util::read_file(util::file_paths::cpuinfo);
 
-            if (util::find(file_content, "User Mode Linux")) {
-                return core::add(brand_enum::UML);
-            }
+        if (util::find(file_content, "User Mode Linux")) {
+            return core::add(brand_enum::UML);
         }
 
         return false;
@@ -7876,56 +10741,14 @@ public:
             return false;
         }
 
-        const int fd = open("/dev/kmsg", O_RDONLY | O_NONBLOCK);
-        if (fd < 0) {
-            debug("KMSG: Failed to open /dev/kmsg");
-            return false;
-        }
-
-        char buffer[1024] = {};
-        std::stringstream ss;
-        int empty_reads = 0;
-        constexpr int MAX_EMPTY_READS = 10;
-
-        while (true) {
-            const ssize_t bytes_read = read(fd, buffer, sizeof(buffer) - 1);
-
-            if (bytes_read > 0) {
-                *(buffer + bytes_read) = '\0';
-                ss << buffer;
-                empty_reads = 0; 
-            }
-            else if (bytes_read == 0) {
-                if (++empty_reads >= MAX_EMPTY_READS) {
-                    debug("KMSG: Reached maximum empty reads (EOF), breaking.");
-                    break;
-                }
-                usleep(10000); /* Sleep for 10 milliseconds */
-            }
-            else {
-                if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    if (++empty_reads >= MAX_EMPTY_READS) {
-                        debug("KMSG: Reached maximum EAGAIN retries, breaking.");
-                        break;
-                    }
-                    usleep(10000);
-                }
-                else {
-                    debug("KMSG: Error reading /dev/kmsg, errno = ", errno);
-                    break;
-                }
-            }
-        }
-
-        close(fd);
+        const util::kernel_log& log = util::kernel_log::get();
 
-        const std::string content = ss.str();
-
-        if (content.empty()) {
+        if (!log.readable) {
+            debug("KMSG: ", "kernel log isn't readable");
             return false;
         }
 
-        return (util::find(content, "Hypervisor detected"));
+        return log.hypervisor_detected;
     }
 
 
@@ -7936,13 +10759,7 @@ public:
      * @implements VM::VBOX_MODULE
      */
     [[nodiscard]] static bool vbox_module() {
-        const char* file = "/proc/modules";
-
-        if (!util::exists(file)) {
-            return false;
-        }
-
-        const std::string content = util::read_file(file);
+        const std::string content = util::read_file(util::file_paths::modules);
 
         if (util::find(content, "vboxguest")) {
             return core::add(brand_enum::VBOX);
@@ -7959,13 +10776,7 @@ public:
      * @implements VM::SYSINFO_PROC
      */
     [[nodiscard]] static bool sysinfo_proc() {
-        const char* file = "/proc/sysinfo";
-
-        if (!util::exists(file)) {
-            return false;
-        }
-
-        const std::string content = util::read_file(file);
+        const std::string content = util::read_file(util::file_paths::sysinfo);
 
         if (util::find(content, "VM00")) {
             return true;
@@ -7988,15 +10799,18 @@ public:
          *  cat: /sys/class/dmi/id/product_uuid:   Permission denied
          */
 
-        constexpr std::array<const char*, 7> dmi_array{
-            "/sys/class/dmi/id/bios_vendor",
-            "/sys/class/dmi/id/board_name",
-            "/sys/class/dmi/id/board_vendor",
-            "/sys/class/dmi/id/chassis_asset_tag",
-            "/sys/class/dmi/id/product_family",
-            "/sys/class/dmi/id/product_sku",
-            "/sys/class/dmi/id/sys_vendor"
-        };
+        /* The fields behind /sys/class/dmi/id/{bios_vendor,board_name,board_vendor,chassis_asset_tag,product_family,product_sku,sys_vendor} */
+        const util::smbios& table = util::smbios::get();
+
+        const std::array<const std::string*, 7> dmi_array{ {
+            &table.bios.vendor,
+            &table.board.product,
+            &table.board.manufacturer,
+            &table.chassis.asset_tag,
+            &table.system.family,
+            &table.system.sku,
+            &table.system.manufacturer
+        } };
 
         constexpr std::array<std::pair<const char*, enum brand_enum>, 15> vm_table{ {
             { "kvm", brand_enum::KVM },
@@ -8017,20 +10831,21 @@ public:
         } };
 
 
-        for (const auto file : dmi_array) {
-            if (!util::exists(file)) {
-                continue;
-            }
+        char content[256];
 
-            std::string content = util::read_file(file);
-            if (content.empty()) {
+        for (const auto field : dmi_array) {
+            const size_t length = (std::min)(field->size(), sizeof(content) - 1);
+            if (length == 0) {
                 continue;
             }
 
-            string::to_lower_inplace(content);
+            for (size_t i = 0; i < length; ++i) {
+                content[i] = string::to_lower((*field)[i]);
+            }
+            content[length] = '\0';
 
             for (const auto& vm_string : vm_table) {
-                if (string::contains(content, vm_string.first)) {
+                if (string::find(content, vm_string.first)) {
                     debug("DMI_SCAN: content = ", content);
 
                     if (vm_string.second == brand_enum::AWS_NITRO) {
@@ -8060,22 +10875,16 @@ public:
             return false;
         }
 
-        const char* file = "/sys/firmware/dmi/entries/0-0/raw";
-
-        if (!util::exists(file)) {
-            return false;
-        }
-
-        const std::vector<u8> content = util::read_file_binary(file);
+        const util::smbios::bios_record& bios = util::smbios::get().bios;
 
-        if (content.size() < 20 || content.at(1) < 20) {
-            debug("SMBIOS_VM_BIT: ", "only read ", content.size(), " bytes, expected 20");
+        if (!bios.has_vm_bit) {
+            debug("SMBIOS_VM_BIT: ", "no BIOS characteristics extension byte 2");
             return false;
         }
 
-        debug("SMBIOS_VM_BIT: ", "content.at(19) = ", static_cast<int>(content.at(19)));
+        debug("SMBIOS_VM_BIT: ", "vm bit = ", bios.vm_bit);
 
-        return (content.at(19) & (1 << 4));
+        return bios.vm_bit;
     } 
 
 
@@ -8085,7 +10894,7 @@ public:
      * @implements VM::PODMAN_FILE
      */
     [[nodiscard]] static bool podman_file() {
-        if (util::exists("/run/.containerenv")) {
+        if (util::exists(util::file_paths::containerenv)) {
             return core::add(brand_enum::PODMAN);
         }
 
@@ -8099,17 +10908,9 @@ public:
      * @implements VM::WSL_PROC
      */
     [[nodiscard]] static bool wsl_proc_subdir() {
-        auto read_proc_nonblock = [](const char* path) -> std::string {
-            const int fd = open(path, O_RDONLY | O_NONBLOCK);
-
-            if (fd < 0) {
-                return "";
-            }
-
-            char buf[512] = {};
-            const ssize_t n = read(fd, buf, sizeof(buf) - 1);
-
-            close(fd);
+        auto read_proc = [](const char* path) -> std::string {
+            char buf[512];
+            const ssize_t n = util::read_into(path, buf, sizeof(buf));
 
             if (n <= 0) {
                 return "";
@@ -8118,8 +10919,8 @@ public:
             return { buf, static_cast<size_t>(n) };
         };
 
-        const std::string osrelease = read_proc_nonblock("/proc/sys/kernel/osrelease");
-        const std::string version = read_proc_nonblock("/proc/version");
+        const std::string osrelease = read_proc(util::file_paths::osrelease);
+        const std::string version = read_proc(util::file_paths::version);
 
         if (osrelease.empty() || version.empty()) {
             return false;
@@ -8149,16 +10950,16 @@ public:
          *
          * 1) Device Tree-based detection
          */
-        if (util::exists("/proc/device-tree/fw-cfg")) {
+        if (util::exists(util::file_paths::dt_fw_cfg)) {
             return core::add(brand_enum::QEMU);
         }
-        if (util::exists("/proc/device-tree/hypervisor/compatible")) {
+        if (util::exists(util::file_paths::dt_hypervisor)) {
             return core::add(brand_enum::QEMU);
         }
 
         /* 2) sysfs-based detection */
-        const char* module_path = "/sys/module/qemu_fw_cfg/";
-        const char* firmware_path = "/sys/firmware/qemu_fw_cfg/";
+        const char* module_path = util::file_paths::qemu_fw_cfg_module;
+        const char* firmware_path = util::file_paths::qemu_fw_cfg_firmware;
 
         if (util::is_directory(module_path) && util::exists(module_path) &&
             util::is_directory(firmware_path) && util::exists(firmware_path)) {
@@ -8203,23 +11004,30 @@ public:
      * @implements VM::CONTAINER_PID
      */
     [[nodiscard]] static bool container_proc_id() {
-        std::ifstream status_file("/proc/self/status");
-        if (!status_file.is_open()) {
+        char status[4096];
+        if (util::read_into(util::file_paths::self_status, status, sizeof(status)) <= 0) {
             return false;
         }
 
-        std::string line;
-        bool pid_match = false;
-        bool ppid_match = false;
+        /* The number on the line starting with prefix, or -1 if there's no such line */
+        auto parse_number = [&](const char* prefix) noexcept -> int {
+            const size_t prefix_len = std::strlen(prefix);
+            const char* line = status;
+
+            while (line && std::strncmp(line, prefix, prefix_len) != 0) {
+                line = std::strchr(line, '\n');
+                if (line) {
+                    ++line;
+                }
+            }
 
-        auto parse_number = [&](const std::string& prefix) noexcept -> int {
-            if (line.rfind(prefix, 0) != 0) {
+            if (!line) {
                 return -1;
             }
 
             int num = 0;
-            for (size_t i = prefix.size(); i < line.size(); ++i) {
-                const u8 ch = static_cast<u8>(line.at(i));
+            for (const char* p = line + prefix_len; *p && *p != '\n'; ++p) {
+                const u8 ch = static_cast<u8>(*p);
                 if (std::isdigit(ch)) {
                     num = (num * 10) + (ch - '0');
                 }
@@ -8230,23 +11038,7 @@ public:
             return num;
         };
 
-        while (std::getline(status_file, line)) {
-            const int pid = parse_number("Pid:");
-            if (pid == 1) {
-                pid_match = true;
-            }
-
-            const int ppid = parse_number("PPid:");
-            if (ppid == 0) {
-                ppid_match = true;
-            }
-
-            if (pid_match && ppid_match) {
-                return true;
-            }
-        }
-
-        return false;
+        return (parse_number("Pid:") == 1) && (parse_number("PPid:") == 0);
     }
 
 
@@ -8256,10 +11048,10 @@ public:
      * @implements VM::TEMPERATURE
      */
     [[nodiscard]] static bool temperature() {
-        if (util::exists("/sys/class/thermal/cooling_device0")) {
+        if (util::exists(util::file_paths::cooling_device)) {
             return false;
         }
-        return (!util::exists("/sys/class/thermal/thermal_zone0/"));
+        return (!util::exists(util::file_paths::thermal_zone));
     }
 
 
@@ -8269,7 +11061,7 @@ public:
      * @implements VM::CGROUP
      */
     [[nodiscard]] static bool cgroup() {
-        const std::string contents = util::read_file("/proc/self/cgroup");
+        const std::string contents = util::read_file(util::file_paths::self_cgroup);
         
         if (contents.empty()) {
             return false;
@@ -8339,16 +11131,34 @@ public:
      * @implements VM::PROCESSES
      */
     [[nodiscard]] static bool processes() {
-        if (util::is_proc_running("qemu_ga")) {
-            debug("PROCESSES: Detected QEMU guest agent process.");
-            return core::add(brand_enum::QEMU);
+        /* Guest agents and tools daemons, all looked for in the same pass over /proc */
+        static constexpr util::process_entry agents[] = {
+            { "qemu_ga", brand_enum::QEMU },
+            { "qemu-ga", brand_enum::QEMU },
+            { "VBoxService", brand_enum::VBOX },
+            { "VBoxClient", brand_enum::VBOX },
+            { "vmtoolsd", brand_enum::VMWARE },
+            { "hv_kvp_daemon", brand_enum::HYPERV },
+            { "hv_vss_daemon", brand_enum::HYPERV },
+            { "prltoolsd", brand_enum::PARALLELS },
+            { "xe-daemon", brand_enum::XEN }
+        };
+
+        constexpr size_t agent_count = sizeof(agents) / sizeof(agents[0]);
+        const u64 found = util::find_processes(agents, agent_count);
+
+        for (size_t i = 0; i < agent_count; ++i) {
+            if (found & (1ull << i)) {
+                debug("PROCESSES: Detected ", agents[i].name, " process.");
+                return core::add(agents[i].brand);
+            }
         }
 
-        if (util::exists("/proc/xen")) {
+        if (util::exists(util::file_paths::proc_xen)) {
             return core::add(brand_enum::XEN);
         }
 
-        if (util::exists("/proc/vz")) {
+        if (util::exists(util::file_paths::proc_vz)) {
             return core::add(brand_enum::OPENVZ);
         }
 
@@ -8720,50 +11530,117 @@ public:
                     ? true
                     : (arr[i] != nullptr && verify_no_nulls(arr, i + 1));
             }
+
+            static constexpr size_t length(const char* str) {
+                return (*str == '\0') ? 0 : 1 + length(str + 1);
+            }
+
+            /* pattern_set::add() turns down anything shorter than its fingerprint */
+            static constexpr bool verify_lengths(const std::array<const char*, 24>& arr, size_t i) {
+                return (i == arr.size())
+                    ? true
+                    : (length(arr[i]) >= util::pattern_set::fingerprint && verify_lengths(arr, i + 1));
+            }
+        };
+
+        static_assert(targets.size() == brands_map.size(), "FIRMWARE: 'targets' and 'brands_map' must have the same size.");
+        static_assert(array_validator::verify_no_nulls(targets, 0), "FIRMWARE: 'targets' array contains NULLs.");
+        static_assert(array_validator::verify_lengths(targets, 0), "FIRMWARE: every target must be at least 3 bytes long to be scanned for.");
+        static_assert(targets.size() == brands_map.size(), "FIRMWARE: The target string array size must match the brands mapping array size.");
+
+        /*
+         * OperationRegion (DBG, SystemIO, 0x0402, One)
+         * AML byte sequence: ExtOpPrefix (0x5B), OpRegionOp (0x80), 'D', 'B', 'G', '_' (0x5F padding), SystemIO (0x01), WordPrefix (0x0B), 0x02, 0x04, One (0x01)
+         */
+        static constexpr u8 qemu_dbg_opregion[] = { 0x5B, 0x80, 0x44, 0x42, 0x47, 0x5F, 0x01, 0x0B, 0x02, 0x04, 0x01 };
+        static constexpr u8 pnp0a06_eisa[] = { 0x0C, 0x41, 0xD0, 0x0A, 0x06 }; /* EISAID("PNP0A06") */
+
+        /* Search for the exact QEMU HPET period limit: LOr(LEqual(Local1, Zero), LGreater(Local1, 0x05F5E100)) */
+        static constexpr u8 qemu_hpet_signature[] = {
+            0x91, 0x93, 0x61, 0x00, // LOr, LEqual, Local1, Zero
+            0x94, 0x61,             // LGreater, Local1
+            0x0C, 0x00, 0xE1, 0xF5, 0x05 // DWordPrefix, 0x05F5E100
+        };
+
+        /* QEMU dummy SATA controller address: NameOp (0x08) + "_ADR" + DWordPrefix, Device 31, Function 2 */
+        static constexpr u8 sata_addr_dummy[] = { 0x08, 0x5F, 0x41, 0x44, 0x52, 0x0C, 0x02, 0x00, 0x1F, 0x00 };
+
+        /* Every literal the checks below look for, in the order they're added to the set, so each table is swept once */
+        enum signature : u8 {
+            QEMU_DBG_OPREGION, DBUG, DBGB, DRAC, PNP0C01, SMI_RESOURCES, SMI_INTERFACE, PNP0A06_EISA,
+            CPU_HOTPLUG, PCI_HOTPLUG, PRTP, PRTA, HPET, QEMU_HPET_SIGNATURE, LNKE, LNKH, GSIE, GSIH,
+            GPER, PNP0A06, D0FA, SATA_ADDR_DUMMY, PXEN, BOCHS_STRING,
+            FIRST_TARGET
         };
 
-        static_assert(targets.size() == brands_map.size(), "FIRMWARE: 'targets' and 'brands_map' must have the same size.");
-        static_assert(array_validator::verify_no_nulls(targets, 0), "FIRMWARE: 'targets' array contains NULLs.");
-        static_assert(targets.size() == brands_map.size(), "FIRMWARE: The target string array size must match the brands mapping array size.");
+        static_assert(FIRST_TARGET + targets.size() <= util::pattern_set::max_patterns, "FIRMWARE: too many signatures for one pattern set.");
+
+        static const util::pattern_set signatures = [&]() noexcept -> util::pattern_set {
+            util::pattern_set set;
+
+            /*
+             * The checks find each signature by its place in the set, so one that isn't taken
+             * would shift every later one onto the wrong brand. Nothing is scanned for then
+             */
+            size_t next = 0;
+            bool in_order = true;
+            auto add = [&](const void* bytes, const size_t length) noexcept {
+                in_order = (set.add(bytes, length) == next++) && in_order;
+            };
+
+            add(qemu_dbg_opregion, sizeof(qemu_dbg_opregion));
+            add("DBUG", 4);
+            add("DBGB", 4);
+            add("DRAC", 4);
+            add("PNP0C01", 7);
+            add("SMI resources", 13);
+            add("SMI interface", 13);
+            add(pnp0a06_eisa, sizeof(pnp0a06_eisa));
+            add("CPU Hotplug resources", 21);
+            add("PCI Hotplug resources", 21);
+            add("PRTP", 4);
+            add("PRTA", 4);
+            add("HPET", 4);
+            add(qemu_hpet_signature, sizeof(qemu_hpet_signature));
+            add("LNKE", 4);
+            add("LNKH", 4);
+            add("GSIE", 4);
+            add("GSIH", 4);
+            add("GPER", 4);
+            add("PNP0A06", 7);
+            add("D0FA", 4);
+            add(sata_addr_dummy, sizeof(sata_addr_dummy));
+            add("PXEN", 4);
+            add("BOCHS", 5);
+            in_order = (next == FIRST_TARGET) && in_order;
+            for (const char* target : targets) {
+                add(target, strlen(target));
+            }
+
+            if (!in_order) {
+                debug("FIRMWARE: signature table doesn't match the signature enum, skipping the scan");
+                return util::pattern_set();
+            }
+            return set;
+        }();
 
         /* Track cross-table validation parameters sequentially across buffers */
         bool dsdt_scanned = false;
         char dsdt_oem_id[7] = { 0 };
 
         auto scan_buffer = [&](const u8* buffer, const size_t buffer_len, const bool is_acpi) noexcept -> bool {
-            auto find_pattern = [&](const char* pattern, size_t pattern_len) noexcept -> bool {
-                if (pattern_len == 0 || pattern_len > buffer_len) {
-                    return false;
-                }
-                const u8 first_byte = static_cast<u8>(pattern[0]);
-                const u8* base_ptr = buffer;
-                const u8* search_ptr = base_ptr;
-                size_t remaining_bytes = buffer_len;
-
-                while (remaining_bytes >= pattern_len) {
-                    VMAWARE_PREFETCH(search_ptr + 64, _MM_HINT_T0);
-                    const void* match = memchr(search_ptr, first_byte, remaining_bytes);
-                    if (!match) {
-                        return false;
-                    }
-                    const u8* match_ptr = static_cast<const u8*>(match);
-                    const size_t index = static_cast<size_t>(match_ptr - base_ptr);
-                    if (index + pattern_len > buffer_len) {
-                        return false;
-                    }
-                    if (memcmp(match_ptr, pattern, pattern_len) == 0) {
-                        return true;
-                    }
-                    search_ptr = match_ptr + 1;
-                    remaining_bytes = buffer_len - static_cast<size_t>(search_ptr - base_ptr);
-                }
-                return false;
-            };
-
             if (!buffer) {
                 return false;
             }
 
+            /* One sweep finds every signature, the checks below only look at the results */
+            size_t first_match[util::pattern_set::max_patterns];
+            const u64 found = signatures.scan(buffer, buffer_len, first_match);
+
+            auto find_pattern = [&](const u8 id) noexcept -> bool {
+                return ((found >> id) & 1) != 0;
+            };
+
             acpi_header header;
             if (is_acpi) {
                 if (buffer_len < sizeof(acpi_header)) {
@@ -8780,19 +11657,14 @@ public:
 
                 /* 1) AML Bytecode inspection */
                 {
-                    /*
-                     * OperationRegion (DBG, SystemIO, 0x0402, One)
-                     * AML byte sequence: ExtOpPrefix (0x5B), OpRegionOp (0x80), 'D', 'B', 'G', '_' (0x5F padding), SystemIO (0x01), WordPrefix (0x0B), 0x02, 0x04, One (0x01)
-                     */
-                    constexpr u8 qemu_dbg_opregion[] = { 0x5B, 0x80, 0x44, 0x42, 0x47, 0x5F, 0x01, 0x0B, 0x02, 0x04, 0x01 };
-                    if (find_pattern(reinterpret_cast<const char*>(qemu_dbg_opregion), sizeof(qemu_dbg_opregion))) {
+                    if (find_pattern(QEMU_DBG_OPREGION)) {
                         debug("FIRMWARE: Detected QEMU Debug Port OperationRegion at I/O 0x0402");
                         return core::add(brand_enum::QEMU);
                     }
 
                 #if (WINDOWS)
                     /* Alternate QEMU Debug Port: matching "DBUG" method and "DBGB" field definitions together */
-                    if (find_pattern("DBUG", 4) && find_pattern("DBGB", 4)) {
+                    if (find_pattern(DBUG) && find_pattern(DBGB)) {
                         const char* man = nullptr;
                         const char* mod = nullptr;
                         bool is_acer_aspire = false;
@@ -8811,64 +11683,50 @@ public:
                 #endif
 
                     /* QEMU virtual DRAM Controller named "DRAC" with its corresponding System Board PNPID */
-                    if (find_pattern("DRAC", 4) && find_pattern("PNP0C01", 7)) {
+                    if (find_pattern(DRAC) && find_pattern(PNP0C01)) {
                         debug("FIRMWARE: Detected QEMU virtual DRAM controller (DRAC)");
                         return core::add(brand_enum::QEMU);
                     }
 
                     /* QEMU System Management Interrupt Resources/Interface Reservation string or wildcard _UID and PNP0A06 device association */
-                    if (find_pattern("SMI resources", 13) || find_pattern("SMI interface", 13)) {
+                    if (find_pattern(SMI_RESOURCES) || find_pattern(SMI_INTERFACE)) {
                         debug("FIRMWARE: Detected QEMU SMI Resources reservation string");
                         return core::add(brand_enum::QEMU);
                     }
-                    else {
-                        constexpr u8 pnp0a06_eisa[] = { 0x0C, 0x41, 0xD0, 0x0A, 0x06 }; /* EISAID("PNP0A06") */
+                    else if (find_pattern(PNP0A06_EISA)) {
                         constexpr u8 uid_signature[] = { 0x08, 0x5F, 0x55, 0x49, 0x44 }; /* NameOp (0x08) + "_UID" */
 
-                        /* Simple search helper for pnp0a06_eisa sequence */
-                        auto find_eisa = [&]() noexcept -> const u8* {
-                            if (buffer_len < sizeof(pnp0a06_eisa)) return nullptr;
-                            for (size_t i = 0; i <= buffer_len - sizeof(pnp0a06_eisa); ++i) {
-                                if (memcmp(buffer + i, pnp0a06_eisa, sizeof(pnp0a06_eisa)) == 0) {
-                                    return buffer + i;
-                                }
-                            }
-                            return nullptr;
-                        };
+                        const size_t pnp_offset = first_match[PNP0A06_EISA];
+                        /* Search for the _UID name declaration within a 128-byte scope surrounding the HID */
+                        const size_t search_start = pnp_offset >= 64 ? pnp_offset - 64 : 0;
+                        const size_t search_end = pnp_offset + 64 <= buffer_len ? pnp_offset + 64 : buffer_len;
 
-                        const u8* pnp_ptr = find_eisa();
-                        if (pnp_ptr) {
-                            const size_t pnp_offset = static_cast<size_t>(pnp_ptr - buffer);
-                            /* Search for the _UID name declaration within a 128-byte scope surrounding the HID */
-                            const size_t search_start = pnp_offset >= 64 ? pnp_offset - 64 : 0;
-                            const size_t search_end = pnp_offset + 64 <= buffer_len ? pnp_offset + 64 : buffer_len;
-
-                            for (size_t i = search_start; i + 8 < search_end; ++i) {
-                                if (memcmp(buffer + i, uid_signature, sizeof(uid_signature)) == 0) {
-                                    /* Check if the _UID value is a string (represented by 0x0D StringPrefix in AML) starting with "SM" */
-                                    if (buffer[i + 5] == 0x0D && buffer[i + 6] == 'S' && buffer[i + 7] == 'M') {
-                                        debug("FIRMWARE: Detected QEMU generic device containing SMI string unique identifier");
-                                        return core::add(brand_enum::QEMU);
-                                    }
+                        for (size_t i = search_start; i + 8 < search_end; ++i) {
+                            if (memcmp(buffer + i, uid_signature, sizeof(uid_signature)) == 0) {
+                                /* Check if the _UID value is a string (represented by 0x0D StringPrefix in AML) starting with "SM" */
+                                if (buffer[i + 5] == 0x0D && buffer[i + 6] == 'S' && buffer[i + 7] == 'M') {
+                                    debug("FIRMWARE: Detected QEMU generic device containing SMI string unique identifier");
+                                    return core::add(brand_enum::QEMU);
                                 }
                             }
                         }
                     }
 
                     /* QEMU Hotplug Resource Description strings */
-                    if (find_pattern("CPU Hotplug resources", 21)) {
+                    if (find_pattern(CPU_HOTPLUG)) {
                         debug("FIRMWARE: Detected QEMU CPU Hotplug resources string");
                         return core::add(brand_enum::QEMU);
                     }
-                    if (find_pattern("PCI Hotplug resources", 21)) {
+                    if (find_pattern(PCI_HOTPLUG)) {
                         debug("FIRMWARE: Detected QEMU PCI Hotplug resources string");
                         return core::add(brand_enum::QEMU);
                     }
 
                     /* PRTP and PRTA variable-size relative symmetry check (replaces old exact-128 check) */
-                    {
-                        auto get_package_size = [&](const char* name) noexcept -> u8 {
-                            const u8* name_ptr = static_cast<const u8*>(memchr(buffer, name[0], buffer_len));
+                    if (find_pattern(PRTP) && find_pattern(PRTA)) {
+                        /* Every occurrence may be the declaration, so this walks them all from the first one the sweep found */
+                        auto get_package_size = [&](const char* name, const size_t start) noexcept -> u8 {
+                            const u8* name_ptr = buffer + start;
                             while (name_ptr) {
                                 const size_t offset = static_cast<size_t>(name_ptr - buffer);
                                 if (offset + 10 <= buffer_len && memcmp(name_ptr, name, 4) == 0) {
@@ -8892,8 +11750,8 @@ public:
                             return 0;
                         };
 
-                        const u8 prtp_size = get_package_size("PRTP");
-                        const u8 prta_size = get_package_size("PRTA");
+                        const u8 prtp_size = get_package_size("PRTP", first_match[PRTP]);
+                        const u8 prta_size = get_package_size("PRTA", first_match[PRTA]);
 
                         if (prtp_size != 0 && prtp_size == prta_size) {
                             debug("FIRMWARE: Detected QEMU routing symmetry (PRTP and PRTA matching size ", (int)prtp_size, ")");
@@ -8902,42 +11760,25 @@ public:
                     }
 
                     /* HPET dynamic check logic (VEND / PRD threshold) with a constant-agnostic structural _STA check */
-                    /* Search for the exact QEMU HPET period limit: LOr(LEqual(Local1, Zero), LGreater(Local1, 0x05F5E100)) */
-                    static const u8 qemu_hpet_signature[] = {
-                        0x91, 0x93, 0x61, 0x00, // LOr, LEqual, Local1, Zero
-                        0x94, 0x61,             // LGreater, Local1
-                        0x0C, 0x00, 0xE1, 0xF5, 0x05 // DWordPrefix, 0x05F5E100
-                    };
-
-                    if (find_pattern("HPET", 4)) {
-                        const u8* ptr = buffer;
-                        if (buffer_len >= sizeof(qemu_hpet_signature)) {
-                            const size_t end_offset = buffer_len - sizeof(qemu_hpet_signature);
-
-                            for (size_t i = 0; i <= end_offset; ++i) {
-                                if (memcmp(&ptr[i], qemu_hpet_signature, sizeof(qemu_hpet_signature)) == 0) {
-                                    debug("FIRMWARE: Detected QEMU HPET period-validation signature");
-                                    return core::add(brand_enum::QEMU);
-                                }
-                            }
-                        }
+                    if (find_pattern(HPET) && find_pattern(QEMU_HPET_SIGNATURE)) {
+                        debug("FIRMWARE: Detected QEMU HPET period-validation signature");
+                        return core::add(brand_enum::QEMU);
                     }
 
                     /* QEMU PIRQ Routing rotation names */
-                    if (find_pattern("LNKE", 4) && find_pattern("LNKH", 4) && find_pattern("GSIE", 4) && find_pattern("GSIH", 4)) {
+                    if (find_pattern(LNKE) && find_pattern(LNKH) && find_pattern(GSIE) && find_pattern(GSIH)) {
                         debug("FIRMWARE: Detected QEMU sequential PIRQ routing names (LNKE-H, GSIE-H)");
                         return core::add(brand_enum::QEMU);
                     }
 
                     /* Motherboard resources mapped via PNP0A06 generic container on designated "GPER" virtual device */
-                    if (find_pattern("GPER", 4) && find_pattern("PNP0A06", 7)) {
+                    if (find_pattern(GPER) && find_pattern(PNP0A06)) {
                         debug("FIRMWARE: Motherboard resources allocated via PNP0A06 generic container");
                         return core::add(brand_enum::QEMU);
                     }
 
                     /* QEMU dummy SATA controller named D0FA on Device 31, Function 2 */
-                    constexpr u8 sata_addr_dummy[] = { 0x08, 0x5F, 0x41, 0x44, 0x52, 0x0C, 0x02, 0x00, 0x1F, 0x00 };
-                    if (find_pattern("D0FA", 4) && find_pattern(reinterpret_cast<const char*>(sata_addr_dummy), sizeof(sata_addr_dummy))) {
+                    if (find_pattern(D0FA) && find_pattern(SATA_ADDR_DUMMY)) {
                         debug("FIRMWARE: Detected QEMU dummy SATA controller named D0FA on Device 31, Function 2");
                         return core::add(brand_enum::QEMU);
                     }
@@ -8947,17 +11788,11 @@ public:
             /* 2) standard VM-specific firmware signature scanning */
             for (size_t i = 0; i < targets.size(); ++i) {
                 const char* pattern = targets[i];
-                const size_t pattern_len = strlen(pattern);
-                if (pattern_len > buffer_len) {
-                    continue;
-                }
 
-                if (find_pattern(pattern, pattern_len)) {
+                if (find_pattern(static_cast<u8>(FIRST_TARGET + i))) {
                     /* Special handling for Xen: must not have PXEN to prevent false flagging some bare metal systems */
                     if (strcmp(pattern, "Xen") == 0) {
-                        constexpr char pxen[] = "PXEN";
-                        constexpr size_t pxen_len = sizeof(pxen) - 1;
-                        if (!find_pattern(pxen, pxen_len)) {
+                        if (!find_pattern(PXEN)) {
                             return core::add(brand_enum::XEN);
                         }
                         else {
@@ -8967,9 +11802,7 @@ public:
 
                     /* Special handling for BOCHS: if BXPC is detected, check if "BOCHS" is present too */
                     if (strcmp(pattern, "BXPC") == 0) {
-                        constexpr char bochs[] = "BOCHS";
-                        constexpr size_t bochs_len = sizeof(bochs) - 1;
-                        if (!find_pattern(bochs, bochs_len)) {
+                        if (!find_pattern(BOCHS_STRING)) {
                             return core::add(brand_enum::BOCHS);
                         }
                         else {
@@ -9142,8 +11975,8 @@ public:
         };
 
     #if (WINDOWS)
-        /* To minimize heap allocations */
-        std::vector<u8> work_buffer;
+        /* To minimize heap allocations, every table is fetched into the same buffer */
+        util::scratch_buffer work_buffer;
         work_buffer.reserve(65536);
 
         /* Enumerate ACPI tables */
@@ -9173,12 +12006,9 @@ public:
 
             const UINT sz = GetSystemFirmwareTable(acpi_signature, dsdt_swapped, nullptr, 0);
             if (sz > 0) {
-                if (sz > work_buffer.capacity()) {
-                    work_buffer.reserve(sz);
-                }
-                work_buffer.resize(sz);
-                if (GetSystemFirmwareTable(acpi_signature, dsdt_swapped, work_buffer.data(), sz) == sz) {
-                    if (scan_buffer(work_buffer.data(), work_buffer.size(), true)) {
+                u8* data = work_buffer.reserve(sz);
+                if (data && GetSystemFirmwareTable(acpi_signature, dsdt_swapped, data, sz) == sz) {
+                    if (scan_buffer(data, sz, true)) {
                         return true;
                     }
                 }
@@ -9191,16 +12021,12 @@ public:
                 return false;
             }
 
-            if (sz > work_buffer.capacity()) {
-                work_buffer.reserve(sz);
-            }
-            work_buffer.resize(sz);
-
-            if (GetSystemFirmwareTable(provider, table_id, work_buffer.data(), sz) != sz) {
+            u8* data = work_buffer.reserve(sz);
+            if (!data || GetSystemFirmwareTable(provider, table_id, data, sz) != sz) {
                 return false;
             }
 
-            return scan_buffer(work_buffer.data(), sz, is_acpi);
+            return scan_buffer(data, sz, is_acpi);
         };
 
         /* Scan every ACPI table */
@@ -9255,6 +12081,9 @@ public:
         struct dirent* entry{};
         constexpr long MAX_TABLE_SIZE = static_cast<long>(8 * 1024 * 1024);
 
+        /* Every table is read into the same buffer, which only grows when a bigger table comes along */
+        util::scratch_buffer table_buffer;
+
         while ((entry = readdir(raw_dir)) != nullptr) {
             if ((strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0)) {
                 continue;
@@ -9297,18 +12126,15 @@ public:
 
             const size_t file_size_u = static_cast<size_t>(file_size);
 
-            std::vector<u8> buffer;
-            try {
-                buffer.resize(file_size_u);
-            }
-            catch (...) {
+            u8* buffer = table_buffer.reserve(file_size_u);
+            if (!buffer) {
                 debug("FIRMWARE: failed to allocate memory for buffer");
                 continue;
             }
 
             size_t total = 0;
             while (total < file_size_u) {
-                const ssize_t n = read(fdguard.fd, buffer.data() + total, file_size_u - total);
+                const ssize_t n = read(fdguard.fd, buffer + total, file_size_u - total);
                 if (n <= 0) {
                     break;
                 }
@@ -9321,7 +12147,7 @@ public:
                 continue;
             }
 
-            if (scan_buffer(buffer.data(), file_size_u, true)) {
+            if (scan_buffer(buffer, file_size_u, true)) {
                 return true;
             }
         }
@@ -9338,52 +12164,206 @@ public:
      * @implements VM::DEVICES
      */
     [[nodiscard]] static bool pci_devices() {
-        struct pci_device { u16 vendor_id; u32 device_id; };
-        std::vector<pci_device> devices;
+        /* A known VM device, with the vendor id in the upper 16 bits. NULL_BRAND counts as a VM without naming one */
+        struct pci_id {
+            u32 id;
+            brand_enum brand;
+        };
+
+        /* Sorted by id for the binary search below */
+        static constexpr pci_id known_ids[] = {
+            /* QEMU */
+            { 0x06270001, brand_enum::QEMU },
+            /* VMware */
+            { 0x0e0f0001, brand_enum::VMWARE }, { 0x0e0f0002, brand_enum::VMWARE }, { 0x0e0f0003, brand_enum::VMWARE },
+            { 0x0e0f0004, brand_enum::VMWARE }, { 0x0e0f0005, brand_enum::VMWARE }, { 0x0e0f0006, brand_enum::VMWARE },
+            { 0x0e0f000a, brand_enum::VMWARE }, { 0x0e0f8001, brand_enum::VMWARE }, { 0x0e0f8002, brand_enum::VMWARE },
+            { 0x0e0f8003, brand_enum::VMWARE }, { 0x0e0ff80a, brand_enum::VMWARE },
+            /* VGPUs (NVIDIA + others) */
+            { 0x10de0fe7, brand_enum::NULL_BRAND }, { 0x10de0ff7, brand_enum::NULL_BRAND }, { 0x10de118d, brand_enum::NULL_BRAND },
+            { 0x10de11b0, brand_enum::NULL_BRAND },
+            /* VMware */
+            { 0x15ad0710, brand_enum::VMWARE }, { 0x15ad0720, brand_enum::VMWARE }, { 0x15ad0770, brand_enum::VMWARE },
+            { 0x15ad0774, brand_enum::VMWARE }, { 0x15ad0778, brand_enum::VMWARE }, { 0x15ad0779, brand_enum::VMWARE },
+            { 0x15ad0790, brand_enum::VMWARE }, { 0x15ad07a0, brand_enum::VMWARE }, { 0x15ad07b0, brand_enum::VMWARE },
+            { 0x15ad07c0, brand_enum::VMWARE }, { 0x15ad07e0, brand_enum::VMWARE }, { 0x15ad07f0, brand_enum::VMWARE },
+            { 0x15ad0801, brand_enum::VMWARE }, { 0x15ad0820, brand_enum::VMWARE }, { 0x15ad1977, brand_enum::VMWARE },
+            /* Parallels */
+            { 0x1ab84000, brand_enum::PARALLELS }, { 0x1ab84005, brand_enum::PARALLELS }, { 0x1ab84006, brand_enum::PARALLELS },
+            /* Red Hat + Virtio */
+            { 0x1af40022, brand_enum::NULL_BRAND }, { 0x1af41000, brand_enum::NULL_BRAND }, { 0x1af41001, brand_enum::NULL_BRAND },
+            { 0x1af41002, brand_enum::NULL_BRAND }, { 0x1af41003, brand_enum::NULL_BRAND }, { 0x1af41004, brand_enum::NULL_BRAND },
+            { 0x1af41005, brand_enum::NULL_BRAND }, { 0x1af41009, brand_enum::NULL_BRAND }, { 0x1af41041, brand_enum::NULL_BRAND },
+            { 0x1af41042, brand_enum::NULL_BRAND }, { 0x1af41043, brand_enum::NULL_BRAND }, { 0x1af41044, brand_enum::NULL_BRAND },
+            { 0x1af41045, brand_enum::NULL_BRAND }, { 0x1af41048, brand_enum::NULL_BRAND }, { 0x1af41049, brand_enum::NULL_BRAND },
+            { 0x1af41050, brand_enum::NULL_BRAND }, { 0x1af41052, brand_enum::NULL_BRAND }, { 0x1af41053, brand_enum::NULL_BRAND },
+            { 0x1af4105a, brand_enum::NULL_BRAND }, { 0x1af41100, brand_enum::NULL_BRAND }, { 0x1af41110, brand_enum::NULL_BRAND },
+            { 0x1af41b36, brand_enum::NULL_BRAND },
+            /* Red Hat + QEMU */
+            { 0x1b360001, brand_enum::QEMU }, { 0x1b360002, brand_enum::QEMU }, { 0x1b360003, brand_enum::QEMU },
+            { 0x1b360004, brand_enum::QEMU }, { 0x1b360005, brand_enum::QEMU }, { 0x1b360008, brand_enum::QEMU },
+            { 0x1b360009, brand_enum::QEMU }, { 0x1b36000b, brand_enum::QEMU }, { 0x1b36000c, brand_enum::QEMU },
+            { 0x1b36000d, brand_enum::QEMU }, { 0x1b360010, brand_enum::QEMU }, { 0x1b360011, brand_enum::QEMU },
+            { 0x1b360013, brand_enum::QEMU }, { 0x1b360100, brand_enum::QEMU },
+            /* QEMU */
+            { 0x1d1d1f1f, brand_enum::QEMU }, { 0x1d6b0200, brand_enum::QEMU },
+            /* VGPUs (NVIDIA + others) */
+            { 0x1ec6020f, brand_enum::NULL_BRAND },
+            /* Connectix (VirtualPC) */
+            { 0x29556e61, brand_enum::VPC },
+            /* Xen */
+            { 0x58530001, brand_enum::XEN }, { 0x5853c000, brand_enum::XEN }, { 0x5853c110, brand_enum::XEN },
+            { 0x5853c147, brand_enum::XEN }, { 0x5853c200, brand_enum::XEN },
+            /* QEMU */
+            { 0x80865845, brand_enum::QEMU },
+            /* VirtualBox */
+            { 0x80ee0021, brand_enum::VBOX }, { 0x80ee0022, brand_enum::VBOX }, { 0x80eebeef, brand_enum::VBOX },
+            { 0x80eecafe, brand_enum::VBOX },
+            /* Xen */
+            { 0xfffd0101, brand_enum::XEN },
+            /* VMware */
+            { 0xfffe0710, brand_enum::VMWARE }
+        };
+
+        /* Devices with 32 bit device ids, as they show up in Windows subsystem ids */
+        static constexpr std::pair<u64, brand_enum> known_wide_ids[] = {
+            { 0x0000000010131100ULL, brand_enum::QEMU }, { 0x0000000010221100ULL, brand_enum::QEMU },
+            { 0x0000000010331100ULL, brand_enum::QEMU }, { 0x00000000106b1100ULL, brand_enum::QEMU },
+            { 0x0000000010ec1100ULL, brand_enum::QEMU }, { 0x0000000011061100ULL, brand_enum::QEMU },
+            { 0x0000000015ad0800ULL, brand_enum::VMWARE }, /* Hypervisor ROM Interface */
+            { 0x000000001af41100ULL, brand_enum::QEMU }, { 0x000000001b361100ULL, brand_enum::QEMU },
+            { 0x0000000080861100ULL, brand_enum::QEMU }
+        };
+
+        constexpr size_t known_count = sizeof(known_ids) / sizeof(known_ids[0]);
+
+        struct table_validator {
+            static constexpr bool verify_sorted(const pci_id* ids, size_t count) {
+                return (count < 2)
+                    ? true
+                    : (ids[0].id < ids[1].id && verify_sorted(ids + 1, count - 1));
+            }
+        };
+
+        static_assert(table_validator::verify_sorted(known_ids, known_count), "DEVICES: 'known_ids' must be sorted by id, without duplicates, for the binary search.");
+
+        /* Add the brand of a known device, and say whether it was one */
+        const auto match = [](const u16 vendor_id, const u32 device_id, bool& result) -> bool {
+            const u32 id32 = (static_cast<u32>(vendor_id) << 16) | device_id;
+
+            size_t low = 0;
+            size_t high = known_count;
+            while (low < high) {
+                const size_t mid = low + (high - low) / 2;
+                if (known_ids[mid].id < id32) {
+                    low = mid + 1;
+                }
+                else {
+                    high = mid;
+                }
+            }
+
+            if (low < known_count && known_ids[low].id == id32) {
+                debug("DEVICES: Detected VM device -> 0x", std::hex, id32);
+                result = (known_ids[low].brand == brand_enum::NULL_BRAND) ? true : core::add(known_ids[low].brand);
+                return true;
+            }
+
+            const u64 id64 = (static_cast<u64>(vendor_id) << 32) | device_id;
+            for (const auto& wide : known_wide_ids) {
+                if (wide.first == id64) {
+                    debug("DEVICES: Detected VM device -> 0x", std::hex, id64);
+                    result = core::add(wide.second);
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        bool result = false;
 
         #if (LINUX)
-            const std::string pci_path = "/sys/bus/pci/devices";
-            #if (VMAWARE_CPP >= 17)
-                /* Std::filesystem throws exceptions when directories don't exist (SIGSEGV) */
-                std::error_code ec;
-                auto dir_iter = std::filesystem::directory_iterator(pci_path, ec);
-
-                if (!ec) {
-                    for (const auto& entry : dir_iter) {
-                        std::ifstream vf(entry.path() / "vendor");
-                        std::ifstream df(entry.path() / "device");
-
-                        if (!vf || !df) {
-                            continue;
-                        }
+            /*
+             * The vendor and device ids are the first 4 bytes of each device's config space, which
+             * anyone can read, so that's one pread() per device relative to the directory, and the
+             * walk stops at the first known one. uevent's PCI_ID= line is the fallback.
+             */
+            DIR* dir = opendir("/sys/bus/pci/devices");
+            if (dir == nullptr) {
+                return false;
+            }
+
+            const int dir_fd = dirfd(dir);
+            char path[NAME_MAX + 16];
+            bool found = false;
+
+            while (!found) {
+                const struct dirent* entry = readdir(dir);
+                if (entry == nullptr) {
+                    break;
+                }
+                if (entry->d_name[0] == '.') {
+                    continue;
+                }
+
+                const size_t length = std::strlen(entry->d_name);
+                std::memcpy(path, entry->d_name, length);
+                std::memcpy(path + length, "/config", sizeof("/config"));
 
-                        u16 vid = 0; u32 did = 0;
-                        vf >> std::hex >> vid;
-                        df >> std::hex >> did;
-                        devices.push_back({ vid, did });
+                u16 vendor_id = 0;
+                u16 device_id = 0;
+
+                int fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+                if (fd >= 0) {
+                    u8 header[4];
+                    const ssize_t n = pread(fd, header, sizeof(header), 0);
+                    close(fd);
+
+                    if (n == static_cast<ssize_t>(sizeof(header))) {
+                        /* Config space is little-endian */
+                        vendor_id = static_cast<u16>(header[0] | (header[1] << 8));
+                        device_id = static_cast<u16>(header[2] | (header[3] << 8));
                     }
                 }
-            #else
-                std::unique_ptr<DIR, decltype(&closedir)> dir(opendir(pci_path.c_str()), closedir);
-                if (dir) {
-                    while (struct dirent* ent = readdir(dir.get())) {
-                        std::string name = ent->d_name;
-                        if (name == "." || name == "..") {
-                            continue;
-                        }
-                        std::string base = pci_path + "/" + name;
-                        std::ifstream vf(base + "/vendor"), df(base + "/device");
-                        if (!vf || !df) {
-                            continue;
-                        }
-                        u16 vid = 0; u32 did = 0;
-                        vf >> std::hex >> vid;
-                        df >> std::hex >> did;
-                        devices.push_back({ vid, did });
+
+                if (vendor_id == 0) {
+                    std::memcpy(path + length, "/uevent", sizeof("/uevent"));
+                    fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+                    if (fd < 0) {
+                        continue;
+                    }
+
+                    char uevent[512];
+                    const ssize_t n = pread(fd, uevent, sizeof(uevent) - 1, 0);
+                    close(fd);
+                    if (n <= 0) {
+                        continue;
+                    }
+                    uevent[n] = '\0';
+
+                    const char* pci_id = std::strstr(uevent, "PCI_ID=");
+                    if (pci_id == nullptr) {
+                        continue;
+                    }
+
+                    char* end = nullptr;
+                    vendor_id = static_cast<u16>(std::strtoul(pci_id + 7, &end, 16));
+                    if (end == nullptr || *end != ':') {
+                        continue;
                     }
+                    device_id = static_cast<u16>(std::strtoul(end + 1, nullptr, 16));
                 }
-            #endif
+
+                found = match(vendor_id, device_id, result);
+            }
+
+            closedir(dir);
+            return result;
         #elif (WINDOWS)
+            struct pci_device { u16 vendor_id; u32 device_id; };
+            std::vector<pci_device> devices;
+
             constexpr DWORD MAX_MULTI_SZ = 64 * 1024;
 
             auto hex_val = [](wchar_t c) noexcept -> int {
@@ -9551,96 +12531,15 @@ public:
                 }
                 SetupDiDestroyDeviceInfoList(h_dev_info);
             }
-        #endif
-
-        for (const auto d : devices) {
-            const u64 id64 = (static_cast<u64>(d.vendor_id) << 32) | d.device_id;
-            const u32 id32 = (static_cast<u32>(d.vendor_id) << 16) | static_cast<u32>(d.device_id);
-
-            switch (id32) {
-                /* Red Hat + Virtio */
-                case 0x1af40022: case 0x1af41000: case 0x1af41001: case 0x1af41002:
-                case 0x1af41003: case 0x1af41004: case 0x1af41005: case 0x1af41009:
-                case 0x1af41041: case 0x1af41042: case 0x1af41043: case 0x1af41044:
-                case 0x1af41045: case 0x1af41048: case 0x1af41049: case 0x1af41050:
-                case 0x1af41052: case 0x1af41053: case 0x1af4105a: case 0x1af41100:
-                case 0x1af41110: case 0x1af41b36:
-                    debug("DEVICES: Detected Red Hat + Virtio device -> 0x", std::hex, id32);
-                    return true;
-
-                /* VMware */
-                case 0x15ad0710: case 0x15ad0720: case 0x15ad0770: case 0x15ad0774: 
-                case 0x15ad0778: case 0x15ad0779: case 0x15ad0790: case 0x15ad07a0: 
-                case 0x15ad07b0: case 0x15ad07c0: case 0x15ad07e0: case 0x15ad07f0: 
-                case 0x15ad0801: case 0x15ad0820: case 0x15ad1977: case 0xfffe0710: 
-                case 0x0e0f0001: case 0x0e0f0002: case 0x0e0f0003: case 0x0e0f0004: 
-                case 0x0e0f0005: case 0x0e0f0006: case 0x0e0f000a: case 0x0e0f8001: 
-                case 0x0e0f8002: case 0x0e0f8003: case 0x0e0ff80a:
-                    debug("DEVICES: Detected VMWARE device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::VMWARE);
-
-                /* Red Hat + QEMU */
-                case 0x1b360001: case 0x1b360002: case 0x1b360003: case 0x1b360004:
-                case 0x1b360005: case 0x1b360008: case 0x1b360009: case 0x1b36000b:
-                case 0x1b36000c: case 0x1b36000d: case 0x1b360010: case 0x1b360011:
-                case 0x1b360013: case 0x1b360100:
-                    debug("DEVICES: Detected Red Hat + QEMU device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::QEMU);
-
-                /* QEMU */
-                case 0x06270001: case 0x1d1d1f1f: case 0x80865845: case 0x1d6b0200:
-                    debug("DEVICES: Detected QEMU device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::QEMU);
-
-                /* VGPUs (NVIDIA + others) */
-                case 0x10de0fe7: case 0x10de0ff7: case 0x10de118d: case 0x10de11b0:
-                case 0x1ec6020f:
-                    debug("DEVICES: Detected virtual gpu device -> 0x", std::hex, id32);
-                    return true;
 
-                /* VirtualBox */
-                case 0x80ee0021: case 0x80ee0022: case 0x80eebeef: case 0x80eecafe:
-                    debug("DEVICES: Detected VirtualBox device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::VBOX);
-
-                /* Parallels */
-                case 0x1ab84000: case 0x1ab84005: case 0x1ab84006:
-                    debug("DEVICES: Detected Parallels device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::PARALLELS);
-
-                /* Xen */
-                case 0x5853c000: case 0xfffd0101: case 0x5853c147:
-                case 0x5853c110: case 0x5853c200: case 0x58530001:
-                    debug("DEVICES: Detected Xen device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::XEN);
-
-                /* Connectix (VirtualPC) */
-                case 0x29556e61:
-                    debug("DEVICES: Detected VirtualPC device -> 0x", std::hex, id32);
-                    return core::add(brand_enum::VPC);
-            }
-
-            /* Devices with 32 bit device ids */
-            switch (id64) {
-                case 0x0000000011061100ULL:
-                case 0x000000001af41100ULL:
-                case 0x000000001b361100ULL:
-                case 0x0000000010ec1100ULL:
-                case 0x0000000010331100ULL:
-                case 0x0000000080861100ULL:
-                case 0x0000000010131100ULL:
-                case 0x00000000106b1100ULL:
-                case 0x0000000010221100ULL:
-                    debug("DEVICES: Detected QEMU device -> 0x", std::hex, id64);
-                    return core::add(brand_enum::QEMU);
-    
-                case 0x0000000015ad0800ULL:  /* Hypervisor ROM Interface */
-                    debug("DEVICES: Detected Hypervisor ROM interface -> 0x", std::hex, id64);
-                    return core::add(brand_enum::VMWARE);
+            for (const auto d : devices) {
+                if (match(d.vendor_id, d.device_id, result)) {
+                    return result;
+                }
             }
-        }
-        
-        return false;
+        #endif
+
+        return result;
     }
 
 
@@ -11432,15 +14331,15 @@ public:
      */
     [[nodiscard]] static bool virtual_processors() {
     #if (x86)
-        int regs[4];
-        __cpuid(regs, cpu::leaf::hypervisor);
+        i32 regs[4];
+        cpu::cpuid(regs, cpu::leaf::hypervisor);
 
         const u32 max_leaf = static_cast<u32>(regs[0]);
         if (max_leaf < cpu::leaf::hv_processors) {
             return false;
         }
 
-        __cpuid(regs, cpu::leaf::hv_processors);
+        cpu::cpuid(regs, cpu::leaf::hv_processors);
         const u32 max_virtual_processors = static_cast<u32>(regs[0]);
         const u32 max_logical_processors = static_cast<u32>(regs[1]);
 
@@ -15532,12 +18431,40 @@ public:
      *                                                                                                *
      * ============================================================================================== */
     struct core {
+        /*
+         * Rough run time classes for the technique table, in microseconds. They only have
+         * to be right within an order of magnitude, since they're solely used to decide
+         * which techniques go first when a SHORTCUT can end the run early
+         */
+        static constexpr u16 COST_CPU = 1;        /* a few instructions, like cpuid */
+        static constexpr u16 COST_LIGHT = 20;     /* a handful of syscalls, small file or registry reads */
+        static constexpr u16 COST_HEAVY = 500;    /* directory walks, device enumeration, large firmware tables */
+        static constexpr u16 COST_SPAWN = 5000;   /* spawns a process */
+        static constexpr u16 COST_SLEEP = 50000;  /* deliberately sleeps or runs long timing loops */
+
+        /*
+         * How long a technique's answer holds, which decides what VM::refresh() drops and what
+         * memo::disk_cache keeps across processes. Most of them read hardware, firmware or the
+         * hypervisor and can't change before a reboot
+         */
+        enum volatility_class : u8 {
+            PER_BOOT = 0,   /* CPUID, firmware tables, devices, DMI... */
+            PER_PROCESS,    /* depends on the calling process: its container, user, loaded modules */
+            TIME_VARYING    /* running processes, cgroups, network interfaces, timing */
+        };
+
         struct technique {
             u8 points = 0;                /* this is the certainty score between 0 and 100 */
             bool(*run)();                 /* this is the technique function itself */
+            u16 cost = COST_LIGHT;        /* one of the COST_* classes above */
+            u8 max_points = 0;            /* the most the technique can score, for those overriding their points through core::add(brand, score) */
+            volatility_class volatility = PER_BOOT;
 
             constexpr technique() : run(nullptr) {}
-            constexpr technique(u8 points, bool(*run)()) : points(points), run(run) {}
+            constexpr technique(u8 points, bool(*run)(), u16 cost = COST_LIGHT, u8 max_points = 0)
+                : points(points), run(run), cost(cost), max_points(max_points > points ? max_points : points) {}
+            constexpr technique(u8 points, bool(*run)(), u16 cost, volatility_class volatility, u8 max_points = 0)
+                : points(points), run(run), cost(cost), max_points(max_points > points ? max_points : points), volatility(volatility) {}
         };
 
         struct custom_technique { /* for custom techniques the user can implement */
@@ -15564,14 +18491,288 @@ public:
          */
         static std::array<technique, enum_size + 1> technique_table;
 
+        /*
+         * The list technique_table is filled from. It's constexpr (see the definition near
+         * the end of the file), so VM::detect<...>() can look its techniques up at compile
+         * time and never refer to the table, which leaves the unused techniques to the linker
+         */
+        static const technique_entry technique_entries[];
+
+        static constexpr technique find_technique(const technique_entry* entry, const size_t count, const enum_flags id) {
+            return (count == 0) ? technique() : ((entry->id == id) ? entry->tech : find_technique(entry + 1, count - 1, id));
+        }
+
+        /* C++11 has no std::index_sequence, this is the same thing for building technique_table at compile time */
+        template <size_t ...ids> struct technique_ids {};
+        template <size_t n, size_t ...ids> struct make_technique_ids : make_technique_ids<n - 1, n - 1, ids...> {};
+        template <size_t ...ids> struct make_technique_ids<0, ids...> { using type = technique_ids<ids...>; };
+
+        template <size_t ...ids>
+        static constexpr std::array<technique, enum_size + 1> make_technique_table(technique_ids<ids...>);
+
+        static constexpr bool is_listed(const technique_entry* entry, const size_t count, const enum_flags id) {
+            return (count != 0) && ((entry->id == id) || is_listed(entry + 1, count - 1, id));
+        }
+
+        /*
+         * Add the points of a technique picked at compile time, unless the threshold is
+         * reached already. Techniques that aren't available on this platform score nothing
+         */
+        template <enum_flags flag>
+        static bool fixed_run(u16& points, const u16 threshold);
+
+        static constexpr bool fixed_flags_valid(const enum_flags* flags, const size_t count) {
+            return (count == 0) || ((flags[0] < technique_end || flags[0] == HIGH_THRESHOLD) && fixed_flags_valid(flags + 1, count - 1));
+        }
+
+        static constexpr bool fixed_flags_contain(const enum_flags* flags, const size_t count, const enum_flags flag) {
+            return (count != 0) && ((flags[0] == flag) || fixed_flags_contain(flags + 1, count - 1, flag));
+        }
+
+        /*
+         * Run a single built-in technique through the technique cache, or fetch its
+         * result if it ran already (waiting for it if another thread is running it).
+         * This is what VM::check() and VM::detect<...>() have in common
+         */
+        static memo::data_t run_cached(const enum_flags id, const technique& tech) {
+            for (;;) {
+                const memo::data_t data = memo::cache_fetch(id);
+                if (data.cached) {
+                    return data;
+                }
+
+                /* Otherwise the result was dropped before it could be fetched, so claim the slot again */
+                if (memo::claim(id)) {
+                    break;
+                }
+            }
+
+            memo::claim_guard claim(id);
+
+            last_detected_brand = brand_enum::NULL_BRAND;
+            last_detected_score = 0;
+
+            const bool result = tech.run();
+            const u8 points_to_add = result ? ((last_detected_score > 0) ? last_detected_score : tech.points) : 0;
+
+            if (result) {
+                std::lock_guard<std::mutex> lock(scoreboard_mutex);
+                detected_count_num++;
+            }
+
+            memo::cache_store(id, result, points_to_add, last_detected_brand);
+            claim.dismiss();
+            return { result, points_to_add, true, last_detected_brand };
+        }
+
         static std::vector<VM::core::custom_technique> custom_table; /* users should not have a limit of how many functions they should add, this is the only exception of a heap-allocated object in our core */
         static size_t custom_table_size;
 
-        static std::array<brand_entry, MAX_BRANDS> brand_scoreboard;
+        static std::array<brand_entry, MAX_BRANDS> brand_scoreboard;
+
+        /* Temporary storage to capture which brand was detected by the currently running technique. */
+        static thread_local brand_enum last_detected_brand;
+        static thread_local u8 last_detected_score;
+
+        /*
+         * Scoreboard increments made by a technique while the engine is collecting them
+         * for a single run (including VM::PARALLEL worker threads). These are kept aside
+         * and only published to brand_scoreboard once the run is over, since the
+         * scoreboard itself is shared between every thread calling into the library
+         */
+        using brand_hits_t = std::array<brand_score_t, MAX_BRANDS>;
+        static thread_local brand_hits_t* brand_capture;
+
+        /* Guards brand_scoreboard and detected_count_num while a run is being published */
+        static std::mutex scoreboard_mutex;
+
+        /* Totals of a single run_all() pass */
+        struct run_result {
+            u16 points;
+            u8 detected_count;
+            brand_hits_t hits;
+            flagset detected; /* built-in techniques that found a VM */
+            flagset skipped;  /* built-in techniques left out because they didn't fit in the deadline */
+            u32 skipped_points; /* the most those, and any skipped custom technique, could have added */
+        };
+
+        /* 150, or 300 with VM::HIGH_THRESHOLD */
+        static u16 threshold(const flagset& flags) noexcept {
+            return core::is_enabled(flags, HIGH_THRESHOLD) ? high_threshold_score : threshold_score;
+        }
+
+        /* How VM::percentage() maps a score */
+        static u8 to_percentage(const u16 points, const flagset& flags) noexcept {
+            if (points >= threshold(flags)) {
+                return 100;
+            }
+            if (points >= 100) {
+                return 99;
+            }
+            return static_cast<u8>(std::min<u16>(points, 99));
+        }
+
+        /*
+         * Per-technique records of the last run_all() made by the current thread, indexed
+         * by technique id. Being thread-local, recording them never needs a lock and
+         * concurrent callers only ever see their own run through VM::profile()
+         */
+        struct profile_table {
+            std::array<technique_profile, enum_size + 1> entries;
+            flagset recorded;
+        };
+        static thread_local profile_table last_profile;
+
+        /*
+         * Where VM::run_stream() wants the records of the run made by the current thread.
+         * Each one is handed to the callback as soon as record() has it, and a false return
+         * ends run_all() before the next technique. Whatever the callback throws is kept
+         * aside and rethrown by VM::run_stream() once the run is over
+         */
+        struct stream_sink {
+            bool (*deliver)(stream_sink& sink, const technique_profile& entry) noexcept;
+            void* callback;
+            bool stopped;
+            std::exception_ptr error;
+        };
+        static thread_local stream_sink* stream;
+
+        template <typename Callback>
+        static bool stream_deliver(stream_sink& sink, const technique_profile& entry) noexcept {
+            try {
+                return (*static_cast<Callback*>(sink.callback))(entry);
+            }
+            catch (...) {
+                sink.error = std::current_exception();
+                return false;
+            }
+        }
+
+        /*
+         * A run that the callback makes itself, like a VM::detect() call, is a run of its own.
+         * Its records don't come back to this callback, and this run's profile is left as it was
+         */
+        static void stream_record(const u16 id) noexcept {
+            stream_sink& sink = *stream;
+            const profile_table outer = last_profile;
+
+            stream = nullptr;
+            const bool go_on = sink.deliver(sink, outer.entries[id]);
+            stream = &sink;
+            last_profile = outer;
+
+            if (!go_on) {
+                sink.stopped = true;
+            }
+        }
+
+        static bool stream_stopped() noexcept {
+            return stream && stream->stopped;
+        }
+
+        static u64 profile_clock() noexcept {
+            return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count());
+        }
+
+        static void record(const u16 id, const u64 ns, const bool from_cache, const memo::data_t& data) noexcept {
+            if (id > enum_size) {
+                return;
+            }
+
+            last_profile.entries[id] = { static_cast<enum_flags>(id), ns, from_cache, data.result, data.points, data.brand_name };
+            last_profile.recorded.set(id);
+
+            if (stream && !stream->stopped) {
+                stream_record(id);
+            }
+
+            if (!from_cache) {
+                const u64 us = ns / 1000;
+                measured_cost[id].store(static_cast<u32>(us == 0 ? 1 : (us > 0xFFFFFFFFull ? 0xFFFFFFFFull : us)), std::memory_order_relaxed);
+            }
+        }
+
+        /*
+         * Measured run time of every technique that actually ran in this process, in
+         * microseconds (0 if it never ran). These take over from the static COST_* class
+         * when ordering techniques, which matters once cached results are dropped and
+         * techniques have to run a second time
+         */
+        static std::array<std::atomic<u32>, enum_size + 1> measured_cost;
+
+        static u32 expected_cost(const u8 id) noexcept {
+            const u32 measured = measured_cost[id].load(std::memory_order_relaxed);
+            return measured ? measured : technique_table[id].cost;
+        }
+
+        /*
+         * Fill the order in which run_all() visits the enabled techniques, and return how many
+         * there are. Without a SHORTCUT every enabled technique ends up running anyway, so the
+         * table order is kept. With one, cached results go first since they're free, and the
+         * rest are sorted by expected points per microsecond so the threshold is reached with
+         * as little work as possible. The score is a plain sum, so whenever the threshold isn't
+         * reached the outcome is identical to running in table order.
+         */
+        static size_t schedule(const flagset& flags, const flagset& skip, const bool shortcut, std::array<u8, enum_size + 1>& order) noexcept {
+            size_t count = 0;
+
+            for (size_t i = technique_begin; i < technique_end; ++i) {
+                if (!technique_table[i].run || core::is_disabled(flags, static_cast<u8>(i)) || skip.test(i)) {
+                    continue;
+                }
+                order[count++] = static_cast<u8>(i);
+            }
+
+            if (!shortcut) {
+                return count;
+            }
+
+            /* Cached techniques to the front, their relative order doesn't matter */
+            size_t ready = 0;
+            for (size_t n = 0; n < count; ++n) {
+                if (memo::is_cached(order[n])) {
+                    std::swap(order[ready++], order[n]);
+                }
+            }
+
+            /*
+             * Insertion sort of the rest, which is stable (ties stay in table order) and doesn't
+             * allocate. a goes before b when points_a / cost_a > points_b / cost_b, compared
+             * through cross-multiplication to keep it in integers
+             */
+            for (size_t n = ready + 1; n < count; ++n) {
+                const u8 id = order[n];
+                const u64 id_points = technique_table[id].points;
+                const u64 id_cost = expected_cost(id);
+
+                size_t k = n;
+                while (k > ready) {
+                    const u8 prev = order[k - 1];
+                    if (id_points * expected_cost(prev) <= static_cast<u64>(technique_table[prev].points) * id_cost) {
+                        break;
+                    }
+                    order[k] = prev;
+                    --k;
+                }
+                order[k] = id;
+            }
+
+            return count;
+        }
+
+        /* Make a finished run visible through brand_scoreboard and detected_count_num */
+        static void publish(const run_result& run) noexcept {
+            std::lock_guard<std::mutex> lock(scoreboard_mutex);
 
-        /* Temporary storage to capture which brand was detected by the currently running technique. */
-        static brand_enum last_detected_brand;
-        static u8 last_detected_score;
+            for (size_t i = 0; i < MAX_BRANDS; ++i) {
+                brand_scoreboard[i].name = static_cast<brand_enum>(i);
+                brand_scoreboard[i].score = run.hits[i];
+            }
+
+            detected_count_num = run.detected_count;
+        }
 
         /* 1. One brand, custom score */
         static bool add(const brand_enum p_brand, const u8 score) noexcept {
@@ -15594,9 +18795,21 @@ public:
             VMAWARE_ASSUME(p_brand <= brand_enum::NULL_BRAND); /* If we maintain the invariant that the parameters are always valid brand_enum values */
 
             const u8 p_idx = static_cast<u8>(p_brand);
-            brand_scoreboard[p_idx].score++;
-            
             const u8 e_idx = static_cast<u8>(extra_brand);
+
+            if (brand_capture) {
+                (*brand_capture)[p_idx]++;
+                if (extra_brand != brand_enum::NULL_BRAND) {
+                    (*brand_capture)[e_idx]++;
+                }
+                return true;
+            }
+
+            /* Only reached by techniques run outside of the engine, like VM::check() */
+            std::lock_guard<std::mutex> lock(scoreboard_mutex);
+
+            brand_scoreboard[p_idx].score++;
+
             if (extra_brand != brand_enum::NULL_BRAND) {
                 brand_scoreboard[e_idx].score++;
             }
@@ -15648,58 +18861,395 @@ public:
             return (flags & get_settings_mask()).any();
         }
 
-        /* Run every VM detection mechanism in the technique table */
-        static u16 run_all(const flagset& flags, const bool shortcut = false) noexcept {
-            u16 points = 0;
-            detected_count_num = 0;
+        /*
+         * util::hyper_x() scores 150 for a hypervisor spoofing Hyper-V through whichever
+         * technique happens to call it first, so until its state is known, any remaining
+         * technique might score that much regardless of its own points
+         */
+        static u16 pending_override() noexcept {
+        #if (WINDOWS)
+            return memo::hyperx::is_cached() ? 0 : 150;
+        #else
+            return 0;
+        #endif
+        }
 
-            /* Reset scoreboard at the start of a run to prevent score leakage */
-            for (size_t i = 0; i < MAX_BRANDS; ++i) {
-                brand_scoreboard[i].score = 0;
-                brand_scoreboard[i].name = static_cast<brand_enum>(i);
+        /*
+         * Worker pool for VM::PARALLEL. Every eligible technique gets a slot, which is
+         * claimed in the memo cache by the calling thread before the pool starts. Workers
+         * take slots through an atomic index and publish each result to the memo cache as
+         * soon as it's known, so other threads waiting on those techniques never depend on
+         * the calling thread's progress. Brand hits stay in the slots until the engine
+         * merges them, nothing is written to the brand scoreboard from a worker thread.
+         */
+        struct parallel_run {
+            struct slot {
+                enum_flags id;
+                bool ran;
+                bool result;
+                u8 points;
+                brand_enum brand;
+                u64 ns;
+                brand_hits_t hits;
+            };
+
+            static constexpr size_t MAX_WORKERS = 8;
+
+            std::array<slot, parallel_techniques.size()> slots{};
+            size_t count = 0;
+            std::atomic<size_t> next{ 0 };
+            std::atomic<u32> points{ 0 };
+            std::atomic<bool> stop{ false };
+            std::array<std::thread, MAX_WORKERS> workers{};
+            size_t worker_count = 0;
+            u16 threshold = 0;
+            bool shortcut = false;
+
+            /*
+             * For VM::detect()'s pruning, the most the whole run could still end up with: what
+             * was actually scored so far, plus the max_points of everything not settled yet.
+             * It lives here so the workers and the calling thread tighten the same bound
+             */
+            bool prune = false;
+            std::atomic<u32> bound{ 0 };
+
+            void add(const enum_flags id) noexcept {
+                slot& s = slots[count++];
+                s.id = id;
+                s.ran = false;
+                s.result = false;
+                s.points = 0;
+                s.brand = brand_enum::NULL_BRAND;
+                s.ns = 0;
+                s.hits.fill(0);
+            }
+
+            /* Account for points gathered outside the pool so the SHORTCUT cutoff sees the whole run */
+            void add_points(const u16 p) noexcept {
+                const u32 total = points.fetch_add(p) + p;
+                if (shortcut && total >= threshold) {
+                    stop.store(true);
+                }
             }
 
-            const u16 threshold_points = core::is_enabled(flags, HIGH_THRESHOLD) ? high_threshold_score : threshold_score;
+            bool reached() const noexcept {
+                return shortcut && (points.load() >= threshold);
+            }
 
-            const size_t tech_limit = technique_table.size(); /* (enum_size + 1) */
-            for (size_t i = technique_begin; i < technique_end; ++i) {
-                VMAWARE_ASSUME(i < tech_limit);
+            bool unreachable() const noexcept {
+                return prune && (bound.load() + pending_override() < threshold);
+            }
 
-                const enum_flags technique_macro = static_cast<enum_flags>(i);
-                const technique& technique_data = technique_table[i];
+            /* A technique's actual score is known, so swap its max_points in the bound for it */
+            void settle(const u8 max_points, const u8 scored) noexcept {
+                if (!prune) {
+                    return;
+                }
+                bound.fetch_sub(static_cast<u32>(max_points - (scored < max_points ? scored : max_points)));
+                if (unreachable()) {
+                    stop.store(true);
+                }
+            }
 
-                /* Skip empty entries */
-                if (!technique_data.run) {
-                    continue;
+            void drain() noexcept {
+                while (true) {
+                    const size_t i = next.fetch_add(1);
+                    if (i >= count) {
+                        return;
+                    }
+
+                    slot& s = slots[i];
+                    const technique& technique_data = technique_table[s.id];
+                    memo::claim_guard claim(s.id);
+
+                    /*
+                     * Once the run stops, whatever is left is given back right away instead of
+                     * when the caller joins, since another caller can be waiting on it while
+                     * this caller waits on one of its slots
+                     */
+                    if (stop.load()) {
+                        continue;
+                    }
+
+                    brand_capture = &s.hits;
+                    last_detected_brand = brand_enum::NULL_BRAND;
+                    last_detected_score = 0;
+
+                    bool result = false;
+                    const u64 started = profile_clock();
+                    try {
+                        result = technique_data.run();
+                    }
+                    catch (...) {
+                        /* Left without a result like in a sequential run, so the next call runs it again */
+                        debug("PARALLEL: technique ", static_cast<int>(s.id), " threw an exception");
+                        brand_capture = nullptr;
+                        continue;
+                    }
+                    s.ns = profile_clock() - started;
+
+                    brand_capture = nullptr;
+
+                    s.result = result;
+                    s.points = result ? ((last_detected_score > 0) ? last_detected_score : technique_data.points) : 0;
+                    s.brand = result ? last_detected_brand : brand_enum::NULL_BRAND;
+                    s.ran = true;
+
+                    memo::cache_store(s.id, s.result, s.points, s.brand);
+                    claim.dismiss();
+                    add_points(s.points);
+                    settle(technique_data.max_points, s.points);
+                }
+            }
+
+            bool start() noexcept {
+                if (count == 0) {
+                    return false;
+                }
+
+                const size_t hw = static_cast<size_t>(memo::thread_count::fetch());
+                size_t wanted = std::min<size_t>(std::min<size_t>(hw > 1 ? hw - 1 : 1, count), static_cast<size_t>(MAX_WORKERS));
+
+                /* The workers read files for this run, so they take from the file cache what it would */
+                const u64 generation = memo::file_cache::run_generation;
+
+                for (; worker_count < wanted; ++worker_count) {
+                    try {
+                        workers[worker_count] = std::thread([this, generation]() noexcept {
+                            memo::file_cache::run_generation = generation;
+                            drain();
+                        });
+                    }
+                    catch (...) {
+                        debug("PARALLEL: failed to spawn worker thread");
+                        break;
+                    }
+                }
+
+                return worker_count > 0;
+            }
+
+            /* Give back every claimed slot, used when the pool couldn't start at all */
+            void abandon() noexcept {
+                for (size_t i = 0; i < count; ++i) {
+                    memo::release(slots[i].id);
+                }
+                count = 0;
+            }
+
+            void join() noexcept {
+                drain();
+                for (size_t i = 0; i < worker_count; ++i) {
+                    if (workers[i].joinable()) {
+                        workers[i].join();
+                    }
+                }
+                worker_count = 0;
+            }
+        };
+
+        /*
+         * Run every VM detection mechanism in the technique table. The totals are
+         * accumulated into the caller's run_result, and nothing shared is touched
+         * apart from the memo cache, so this can be called from several threads.
+         *
+         * With prune, the run also stops as soon as the threshold can't be reached
+         * anymore, even if every technique left were to detect something. That's only
+         * meant for boolean queries like VM::detect(), since the returned points are
+         * then just known to be below the threshold rather than the full total.
+         *
+         * With a deadline (a profile_clock() value, 0 for none), a technique that isn't
+         * cached only runs if its expected cost still fits before the deadline, and is
+         * otherwise left unclaimed so a later run can still fill its cache entry. Nothing
+         * waits on another thread either, and the worker pool isn't used, since neither
+         * could be bounded in time.
+         */
+        static u16 run_all(const flagset& flags, const bool shortcut, run_result& run, const bool prune = false, const u64 deadline = 0) noexcept {
+            run.points = 0;
+            run.detected_count = 0;
+            run.hits.fill(0);
+            run.detected.reset();
+            run.skipped.reset();
+            run.skipped_points = 0;
+            last_profile.recorded.reset();
+
+            u16& points = run.points;
+
+            /* Route every brand hit of this run into the run's own tally */
+            brand_hits_t* const previous_capture = brand_capture;
+            brand_capture = &run.hits;
+
+            struct capture_guard {
+                brand_hits_t* previous;
+                ~capture_guard() { brand_capture = previous; }
+            } guard{ previous_capture };
+
+            /* Files read by the techniques are shared between them until the last concurrent run ends */
+            struct file_guard {
+                u64 outer;
+                ~file_guard() { memo::file_cache::end_run(outer); }
+            } files{ memo::file_cache::begin_run() };
+
+        #if (VMAWARE_PERSISTENT_CACHE_SUPPORTED)
+            /* With VMAWARE_PERSISTENT_CACHE, whatever this run found is handed on to the next processes of the boot */
+            struct disk_guard {
+                ~disk_guard() { memo::disk_cache::flush(VMAWARE_PERSISTENT_CACHE_DIR); }
+            } disk;
+        #endif
+
+        #if (LINUX)
+            /* With VMAWARE_IO_URING, the file probes of the whole run go through one batch up front */
+            if (deadline == 0) {
+                util::prefetch_files(flags);
+            }
+        #endif
+
+            const u16 threshold_points = threshold(flags);
+
+            /*
+             * With VM::PARALLEL, the uncached I/O-bound techniques are handed to the worker
+             * pool first so they overlap with the rest of the table, which still runs in
+             * order on this thread. Their results are merged below after the pool is joined.
+             * Techniques that another thread is already running stay on this thread, which
+             * will wait for them like any other cached entry.
+             */
+            const bool parallel = core::is_enabled(flags, PARALLEL) && (deadline == 0);
+            parallel_run pool;
+            flagset offloaded;
+
+            pool.threshold = threshold_points;
+            pool.shortcut = shortcut;
+            pool.prune = prune;
+
+            if (parallel) {
+                for (const enum_flags id : parallel_techniques) {
+                    if (!technique_table[id].run || core::is_disabled(flags, id) || !memo::try_claim(id)) {
+                        continue;
+                    }
+                    pool.add(id);
+                    offloaded.set(id);
+                }
+
+                if (!pool.start()) {
+                    pool.abandon();
+                    offloaded.reset();
+                }
+            }
+
+            /* Empty, disabled and offloaded techniques are left out of the order altogether */
+            std::array<u8, enum_size + 1> order{};
+            const size_t order_count = schedule(flags, offloaded, shortcut || prune, order);
+
+            /* Before anything has run, the bound is simply every candidate detecting something */
+            if (prune) {
+                u32 bound = 0;
+                for (size_t n = 0; n < order_count; ++n) {
+                    bound += technique_table[order[n]].max_points;
+                }
+                for (size_t i = 0; i < pool.count; ++i) {
+                    bound += technique_table[pool.slots[i].id].max_points;
+                }
+                for (const auto& technique : core::custom_table) {
+                    bound += technique.points;
+                }
+                pool.bound.store(bound);
+            }
+
+            for (size_t n = 0; n < order_count; ++n) {
+                const enum_flags technique_macro = static_cast<enum_flags>(order[n]);
+                const technique& technique_data = technique_table[technique_macro];
+
+                if (pool.unreachable() || stream_stopped()) {
+                    if (!parallel) {
+                        return points;
+                    }
+                    pool.stop.store(true);
+                    break;
+                }
+
+                if (parallel && pool.reached()) {
+                    break;
+                }
+
+                /*
+                 * Check if the technique is cached already, or being run by another thread.
+                 * Only the slow path is timed, so plain cache hits stay as cheap as before.
+                 * A result that VM::invalidate() or VM::refresh() drops between the claim
+                 * and the fetch just sends it around the loop again
+                 */
+                u64 started = 0;
+                bool owned = false;
+                bool out_of_time = false;
+                memo::data_t data = memo::cache_fetch(technique_macro);
+
+                while (!data.cached) {
+                    if (started == 0) {
+                        started = profile_clock();
+                    }
+
+                    if (deadline == 0) {
+                        owned = memo::claim(technique_macro);
+                    }
+                    else if (started + static_cast<u64>(expected_cost(technique_macro)) * 1000 <= deadline) {
+                        owned = memo::try_claim(technique_macro);
+                    }
+
+                    if (owned) {
+                        break;
+                    }
+
+                    data = memo::cache_fetch(technique_macro);
+
+                    /* Either out of time, or another thread is running it and there's no time to wait */
+                    if (!data.cached && deadline != 0) {
+                        out_of_time = true;
+                        break;
+                    }
                 }
 
-                /* Check if the technique is disabled */
-                if (core::is_disabled(flags, technique_macro)) {
+                /*
+                 * It stays in the pruning bound, since the verdict isn't settled just because
+                 * there was no time to look
+                 */
+                if (out_of_time) {
+                    run.skipped.set(technique_macro);
+                    run.skipped_points += technique_data.max_points;
                     continue;
                 }
 
-                /* Check if the technique is cached already */
-                if (memo::is_cached(technique_macro)) {
-                    const memo::data_t data = memo::cache_fetch(technique_macro);
+                if (!owned) {
+                    record(technique_macro, started ? (profile_clock() - started) : 0, true, data);
+                    pool.settle(technique_data.max_points, data.result ? data.points : 0);
 
                     if (data.result) {
                         points += data.points;
-                        detected_count_num++;
+                        run.detected_count++;
+                        run.detected.set(technique_macro);
 
                         if (data.brand_name != brand_enum::NULL_BRAND) {
                             add(data.brand_name);
                         }
+
+                        if (parallel) {
+                            pool.add_points(data.points);
+                        }
+                        else if (shortcut && (points >= threshold_points)) {
+                            return points;
+                        }
                     }
 
                     continue;
                 }
 
+                memo::claim_guard claim(technique_macro);
+
                 /* Reset the last detected brand before running */
                 last_detected_brand = brand_enum::NULL_BRAND;
                 last_detected_score = 0;
 
                 /* Run the technique */
                 const bool result = technique_data.run();
+                const u64 elapsed = profile_clock() - started;
 
                 if (result) {
                     /* Determine which points to use: Override or Default */
@@ -15710,15 +19260,30 @@ public:
                      * This is specific to VM::detected_count() which
                      * returns the number of techniques that found a VM.
                      */
-                    detected_count_num++;
+                    run.detected_count++;
+                    run.detected.set(technique_macro);
 
                     /* Retrieve the brand that was set during execution (if any) */
                     const enum brand_enum detected_brand = last_detected_brand;
                     /* Store the current technique result to the cache */
                     memo::cache_store(technique_macro, result, points_to_add, detected_brand);
+                    claim.dismiss();
+                    record(technique_macro, elapsed, false, { result, points_to_add, true, detected_brand });
+                    pool.settle(technique_data.max_points, points_to_add);
+
+                    if (parallel) {
+                        pool.add_points(points_to_add);
+                    }
                 }
                 else {
                     memo::cache_store(technique_macro, false, 0);
+                    claim.dismiss();
+                    record(technique_macro, elapsed, false, { false, 0, true, brand_enum::NULL_BRAND });
+                    pool.settle(technique_data.max_points, 0);
+                }
+
+                if (parallel) {
+                    continue;
                 }
 
                 /*
@@ -15733,27 +19298,90 @@ public:
                 }
             }
 
+            if (parallel) {
+                pool.join();
+
+                /*
+                 * Merge the slots in the order they were queued, which is parallel_techniques order,
+                 * not technique_table or schedule() order. Only the order of the profile records
+                 * depends on it, the totals are plain sums and come out the same either way
+                 */
+                for (size_t i = 0; i < pool.count; ++i) {
+                    const parallel_run::slot& s = pool.slots[i];
+
+                    if (!s.ran) {
+                        continue; /* cancelled by the SHORTCUT threshold before it started, or it threw */
+                    }
+
+                    for (size_t b = 0; b < MAX_BRANDS; ++b) {
+                        run.hits[b] = static_cast<brand_score_t>(run.hits[b] + s.hits[b]);
+                    }
+
+                    if (s.result) {
+                        points += s.points;
+                        run.detected_count++;
+                        run.detected.set(s.id);
+                    }
+
+                    record(s.id, s.ns, false, { s.result, s.points, true, s.brand });
+                }
+
+                if (shortcut && (points >= threshold_points)) {
+                    return points;
+                }
+            }
+
+            if (pool.unreachable() || stream_stopped()) {
+                return points;
+            }
+
             /* For custom VM techniques, won't be used most of the time */
             if (VMAWARE_UNLIKELY(!core::custom_table.empty())) {
                 for (const auto& technique : core::custom_table) {
-                    /* If cached, return that result */
-                    if (memo::is_cached(technique.id)) {
-                        const memo::data_t data = memo::cache_fetch(technique.id);
+                    if (deadline != 0 && profile_clock() >= deadline) {
+                        run.skipped_points += technique.points;
+                        continue;
+                    }
+
+                    /*
+                     * If cached, use that result. With a deadline, one that another thread is
+                     * still running is skipped rather than waited for, like a built-in technique
+                     */
+                    bool owned = false;
+                    memo::data_t data = memo::cache_fetch(technique.id);
+
+                    while (!data.cached) {
+                        owned = (deadline == 0) ? memo::claim(technique.id) : memo::try_claim(technique.id);
+                        if (owned) {
+                            break;
+                        }
+
+                        data = memo::cache_fetch(technique.id);
+                        if (!data.cached && deadline != 0) {
+                            break;
+                        }
+                    }
 
-                        if (data.result) {
+                    if (!owned) {
+                        if (!data.cached) {
+                            run.skipped_points += technique.points;
+                        }
+                        else if (data.result) {
                             points += data.points;
-                            detected_count_num++;
+                            run.detected_count++;
                         }
                         continue;
                     }
 
+                    memo::claim_guard claim(technique.id);
+
                     /* Run the custom technique */
                     const bool result = technique.run();
 
                     /* Accumulate a few important values */
                     if (result) {
                         points += technique.points;
-                        detected_count_num++;
+                        run.detected_count++;
                     }
 
                     /* Cache the result */
@@ -15762,12 +19390,21 @@ public:
                         result,
                         technique.points
                     );
+                    claim.dismiss();
                 }
             }
 
             return points;
         }
 
+        /* Same as above, but the run also becomes visible through brand_scoreboard and detected_count_num */
+        static u16 run_all(const flagset& flags, const bool shortcut = false) noexcept {
+            run_result run;
+            const u16 points = run_all(flags, shortcut, run);
+            publish(run);
+            return points;
+        }
+
         static flagset flag_collector;
         static flagset disabled_flag_collector;
 
@@ -15813,6 +19450,7 @@ public:
                 f.reset(NULL_ARG);
                 f.reset(DYNAMIC);
                 f.reset(MULTIPLE);
+                f.reset(PARALLEL);
                 f.reset(ALL);
 
                 return f;
@@ -15910,6 +19548,26 @@ public:
             return collector;
         }
 
+        /*
+         * For VM::run_stream(flags..., callback), which can't take the flags as a trailing
+         * pack. The arguments go round one at a time until the callback is in front, and the
+         * flags behind it are then in the order they were given
+         */
+        template <typename T, typename... Rest>
+        static u16 stream_rotate(T head, Rest... rest) {
+            return stream_step(std::is_same<typename std::decay<T>::type, enum_flags>{}, head, rest...);
+        }
+
+        template <typename... Rest>
+        static u16 stream_step(std::true_type, const enum_flags flag, Rest... rest) {
+            return stream_rotate(rest..., flag);
+        }
+
+        template <typename Callback, typename... Rest>
+        static u16 stream_step(std::false_type, Callback callback, Rest... rest) {
+            return VM::run_stream(arg_handler(rest...), callback);
+        }
+
         /* Same as above but for VM::disable which only accepts technique flags */
         template <typename... Args>
         static void disabled_arg_handler(Args... args) {
@@ -15948,7 +19606,9 @@ public:
         VMAWARE_UNUSED(loc);
     #endif
         if (VMAWARE_UNLIKELY(util::is_unsupported(flag_bit))) {
-            memo::cache_store(flag_bit, false, 0);
+            if (memo::try_claim(flag_bit)) {
+                memo::cache_store(flag_bit, false, 0);
+            }
             return false;
         }
 
@@ -15973,15 +19633,16 @@ public:
         if (
             (flag_bit == HIGH_THRESHOLD) ||
             (flag_bit == DYNAMIC) ||
-            (flag_bit == MULTIPLE)
+            (flag_bit == MULTIPLE) ||
+            (flag_bit == PARALLEL)
         ) {
             throw_error("Flag argument must be a technique flag and not a settings flag");
         }
 
         /* If the technique is already cached, return the cached value instead */
-        if (memo::is_cached(flag_bit)) {
-            const memo::data_t data = memo::cache_fetch(flag_bit);
-            return data.result;
+        const memo::data_t cached = memo::cache_fetch(flag_bit);
+        if (cached.cached) {
+            return cached.result;
         }
 
         if (flag_bit >= technique_end) {
@@ -15991,19 +19652,8 @@ public:
         /* VMAWARE_ASSUME(flag_bit < core::technique_table.size()); */
         const core::technique& pair = core::technique_table.at(flag_bit);
 
-        if (auto run_fn = pair.run) {
-            core::last_detected_brand = brand_enum::NULL_BRAND;
-            core::last_detected_score = 0;
-
-            const bool result = run_fn();
-            const u8 points_to_add = (core::last_detected_score > 0) ? core::last_detected_score : pair.points;
-
-            if (result) {
-                detected_count_num++;
-            }
-
-            memo::cache_store(flag_bit, result, result ? points_to_add : 0, core::last_detected_brand);
-            return result;
+        if (pair.run) {
+            return core::run_cached(flag_bit, pair).result;
         }
 
         throw_error("Flag is not known or not implemented");
@@ -16034,12 +19684,95 @@ public:
         /* Is the multiple setting flag enabled? */
         const bool is_multiple = core::is_enabled(flags, MULTIPLE);
 
-        if (is_multiple) {
-            return brands::brand_multiple(flags);
-        }
+        if (is_multiple) {
+            return brands::brand_multiple(flags);
+        }
+
+        const enum brand_enum b = brands::brand_single(flags);
+        return brands::brand_enum_to_string(b);
+    }
+
+
+    /**
+     * @brief Fetch the ranked VM brands in a fixed-capacity list, without any heap allocation
+     * @param any flag combination in VM structure or nothing
+     * @return VM::brand_set
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-allocation-free-api
+     */
+    template <typename ...Args>
+    static brand_set brand_ranking(const Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return brand_ranking(flags);
+    }
+
+
+    static brand_set brand_ranking(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return brand_ranking(flags);
+    }
+
+
+    static brand_set brand_ranking(const flagset& flags = core::generate_default()) noexcept {
+        /*
+         * The string and vector caches in memo would
+         * copy onto the heap, so this works off a fresh
+         * tally instead. The techniques themselves still
+         * come out of the technique cache after the first run
+         */
+        core::run_result run;
+        const u16 points = core::run_all(flags, false, run);
+
+        brand_set ranked;
+        brands::rank(run.hits, points, ranked);
+        return ranked;
+    }
+
+
+    /**
+     * @brief Fetch the most likely VM brand as an enum, without any heap allocation
+     * @param any flag combination in VM structure or nothing
+     * @return VM::brand_enum
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-allocation-free-api
+     */
+    template <typename ...Args>
+    static brand_enum brand_id(const Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return brand_id(flags);
+    }
+
+
+    static brand_enum brand_id(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return brand_id(flags);
+    }
+
+
+    static brand_enum brand_id(const flagset& flags = core::generate_default()) noexcept {
+        return brand_ranking(flags).front().first;
+    }
+
+
+    /**
+     * @brief Fetch the most likely VM brand as a static string, without any heap allocation
+     * @param any flag combination in VM structure or nothing (VM::MULTIPLE is ignored, use VM::brand_ranking() for every brand)
+     * @return const char*
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-allocation-free-api
+     */
+    template <typename ...Args>
+    static const char* brand_name(const Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return brand_name(flags);
+    }
+
+
+    static const char* brand_name(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return brand_name(flags);
+    }
 
-        const enum brand_enum b = brands::brand_single(flags);
-        return brands::brand_enum_to_string(b);
+
+    static const char* brand_name(const flagset& flags = core::generate_default()) noexcept {
+        return brands::brand_enum_to_string(brand_id(flags));
     }
 
 
@@ -16066,9 +19799,16 @@ public:
     static bool detect(const flagset &flags = core::generate_default()) {
         /*
          * Run all the techniques based on the
-         * flags above, and get a total score
+         * flags above, and get a total score.
+         * Nothing shared is written apart from
+         * the technique cache, so this is safe
+         * to call from as many threads as needed.
+         * Only the verdict matters here, so the
+         * run can also stop once it's clear the
+         * threshold can't be reached anymore
          */
-        const u16 points = core::run_all(flags, SHORTCUT);
+        core::run_result run;
+        const u16 points = core::run_all(flags, SHORTCUT, run, PRUNE);
 
         u16 threshold = threshold_score;
 
@@ -16088,6 +19828,110 @@ public:
     }
 
 
+    /**
+     * @brief Detect if running inside a VM with a set of techniques chosen at compile time
+     * @param technique flags as template arguments, and optionally VM::HIGH_THRESHOLD
+     * @return bool
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#vmdetect
+     */
+    template <enum_flags first, enum_flags ...rest>
+    static bool detect() {
+        static constexpr enum_flags flags[] = { first, rest... };
+        static constexpr size_t count = sizeof...(rest) + 1;
+
+        static_assert(core::fixed_flags_valid(flags, count), "VM::detect<...>() only takes technique flags and VM::HIGH_THRESHOLD");
+
+        static constexpr u16 threshold = core::fixed_flags_contain(flags, count, HIGH_THRESHOLD) ? high_threshold_score : threshold_score;
+
+        /*
+         * Each technique is called directly in the order given, with no
+         * flagset and no technique table involved. Once the threshold is
+         * reached the rest are left out, the verdict can't change anymore
+         */
+        u16 points = 0;
+        const bool ran[] = { core::fixed_run<first>(points, threshold), core::fixed_run<rest>(points, threshold)... };
+        VMAWARE_UNUSED(ran);
+
+        return (points >= threshold);
+    }
+
+
+    /**
+     * @brief Detect if running inside a VM, spending no more than a given budget on techniques that aren't cached yet
+     * @param a deadline on std::chrono::steady_clock or a budget in microseconds, then any flag combination in VM structure or nothing
+     * @return VM::budgeted_result
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmdetect_within
+     */
+    template <typename ...Args>
+    static budgeted_result detect_within(const std::chrono::microseconds budget, const Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return detect_within(budget, flags);
+    }
+
+
+    static budgeted_result detect_within(const std::chrono::microseconds budget, const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return detect_within(budget, flags);
+    }
+
+
+    static budgeted_result detect_within(const std::chrono::microseconds budget, const flagset& flags = core::generate_default()) noexcept {
+        return detect_within(std::chrono::steady_clock::now() + budget, flags);
+    }
+
+
+    template <typename ...Args>
+    static budgeted_result detect_within(const std::chrono::steady_clock::time_point deadline, const Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return detect_within(deadline, flags);
+    }
+
+
+    static budgeted_result detect_within(const std::chrono::steady_clock::time_point deadline, const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return detect_within(deadline, flags);
+    }
+
+
+    static budgeted_result detect_within(const std::chrono::steady_clock::time_point deadline, const flagset& flags = core::generate_default()) noexcept {
+        /* Same clock as core::profile_clock(), and 0 is reserved for "no deadline" */
+        const auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+        const u64 deadline_ns = (since_epoch > 0) ? static_cast<u64>(since_epoch) : 1;
+
+        /*
+         * The SHORTCUT order puts the most points per microsecond first,
+         * so whatever the budget leaves out is the least valuable part
+         */
+        core::run_result run;
+        const u16 points = core::run_all(flags, SHORTCUT, run, PRUNE, deadline_ns);
+        const u16 threshold = core::threshold(flags);
+
+        budgeted_result result;
+        result.points = points;
+        result.is_vm = (points >= threshold);
+        result.skipped = run.skipped;
+        result.confidence = 100;
+
+        /* Only a verdict that the skipped points could still flip is uncertain */
+        if (!result.is_vm && (static_cast<u32>(points) + run.skipped_points >= threshold)) {
+            u32 possible = 0;
+            for (u8 i = technique_begin; i < technique_end; ++i) {
+                if (!core::is_disabled(flags, i) && core::technique_table[i].run) {
+                    possible += core::technique_table[i].max_points;
+                }
+            }
+            for (const auto& technique : core::custom_table) {
+                possible += technique.points;
+            }
+
+            const u32 evaluated = (possible > run.skipped_points) ? (possible - run.skipped_points) : 0;
+            result.confidence = static_cast<u8>((possible == 0) ? 100 : (evaluated * 100) / possible);
+        }
+
+        return result;
+    }
+
+
     /**
      * @brief Get the percentage of how likely it's a VM
      * @param any flag combination in VM structure or nothing
@@ -16111,27 +19955,15 @@ public:
     static u8 percentage(const flagset &flags = core::generate_default()) {
         /*
          * Run all the techniques based on the
-         * flags above, and get a total score
+         * flags above, and get a total score.
+         * Nothing shared is written apart from
+         * the technique cache, so this is safe
+         * to call from as many threads as needed
          */
-        const u16 points = core::run_all(flags, SHORTCUT);
-
-        u8 percent = 0;
-        u16 threshold = threshold_score;
-
-        /* Set to 300 if high threshold is enabled */
-        if (core::is_enabled(flags, HIGH_THRESHOLD)) {
-            threshold = high_threshold_score;
-        }
-
-        if (points >= threshold) {
-            percent = 100;
-        } else if (points >= 100) {
-            percent = 99;
-        } else {
-            percent = static_cast<u8>(std::min<u16>(points, 99));
-        }
+        core::run_result run;
+        const u16 points = core::run_all(flags, SHORTCUT, run);
 
-        return percent;
+        return core::to_percentage(points, flags);
     }
 
 
@@ -16184,6 +20016,82 @@ public:
     }
 
 
+    /**
+     * @brief Drop the cached results of the given techniques, or of every technique if none is given, so they run again on the next call
+     * @param technique flag(s) only, or nothing
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vminvalidate-and-vmrefresh
+     * @return how many cached results were dropped
+     */
+    template <typename ...Args>
+    static u16 invalidate(const Args ...args) {
+        static_assert(core::verify_flags<Args...>(), "VM::invalidate() only accepts enum_flags variables");
+
+        const enum_flags list[] = { args..., static_cast<enum_flags>(technique_end) };
+        constexpr size_t count = sizeof...(args);
+
+        for (size_t i = 0; i < count; ++i) {
+            if (list[i] >= technique_end) {
+                throw std::invalid_argument("VM::invalidate() only takes technique flags");
+            }
+        }
+
+        u16 dropped = 0;
+        bool per_boot = false;
+
+        for (u16 id = technique_begin; id < technique_end; ++id) {
+            if (count != 0 && std::find(list, list + count, static_cast<enum_flags>(id)) == list + count) {
+                continue;
+            }
+            if (memo::forget(id)) {
+                per_boot |= (core::technique_table[id].volatility == core::PER_BOOT);
+                ++dropped;
+            }
+        }
+
+        if (dropped) {
+            memo::forget_results();
+        }
+
+    #if (LINUX)
+        /* Make the disk cache take the new per-boot results, whatever they turn out to be */
+        if (per_boot) {
+            memo::disk_cache::saved.store(0, std::memory_order_relaxed);
+        }
+    #else
+        VMAWARE_UNUSED(per_boot);
+    #endif
+
+        return dropped;
+    }
+
+
+    /**
+     * @brief Drop the cached results of time-varying techniques (running processes, cgroups, network interfaces, timing...) that are older than max_age, keeping the per-boot and per-process ones
+     * @param the oldest a time-varying result may be, or nothing to drop all of them
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vminvalidate-and-vmrefresh
+     * @return how many cached results were dropped
+     */
+    static u16 refresh(const std::chrono::milliseconds max_age = std::chrono::milliseconds(0)) noexcept {
+        const u64 limit = (max_age.count() > 0) ? static_cast<u64>(max_age.count()) : 0;
+        u16 dropped = 0;
+
+        for (u16 id = technique_begin; id < technique_end; ++id) {
+            if (core::technique_table[id].volatility != core::TIME_VARYING || !memo::is_cached(id)) {
+                continue;
+            }
+            if (memo::age_ms(id) >= limit && memo::forget(id)) {
+                ++dropped;
+            }
+        }
+
+        if (dropped) {
+            memo::forget_results();
+        }
+
+        return dropped;
+    }
+
+
     /**
      * @brief disable the provided technique flags so they are not counted to the overall result
      * @param technique flag(s) only
@@ -16297,6 +20205,7 @@ public:
             case HIGH_THRESHOLD: return "HIGH_THRESHOLD"; 
             case DYNAMIC: return "DYNAMIC"; 
             case MULTIPLE: return "MULTIPLE"; 
+            case PARALLEL: return "PARALLEL"; 
             default: return "Unknown flag";
         }
     }
@@ -16339,6 +20248,107 @@ public:
     }
 
 
+    /**
+     * @brief Fetch all the techniques that were detected as a bitset, without any heap allocation
+     * @param any flag combination in VM structure or nothing
+     * @return VM::flagset
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-allocation-free-api
+     */
+    template <typename ...Args>
+    static flagset detected_flags(const Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return detected_flags(flags);
+    }
+
+
+    static flagset detected_flags(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return detected_flags(flags);
+    }
+
+
+    static flagset detected_flags(const flagset& flags = core::generate_default()) noexcept {
+        core::run_result run;
+        core::run_all(flags, false, run);
+        return run.detected;
+    }
+
+
+    /**
+     * @brief Fetch the timing and outcome of every technique visited by the last run on the calling thread
+     * @param none
+     * @return VM::profile_list_t
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmprofile
+     */
+    static profile_list_t profile() {
+        profile_list_t tmp;
+        tmp.reserve(core::last_profile.recorded.count());
+
+        /* Techniques cut off by a SHORTCUT or left disabled were never visited and have no record */
+        for (u8 i = technique_begin; i < technique_end; ++i) {
+            if (core::last_profile.recorded.test(i)) {
+                tmp.push_back(core::last_profile.entries[i]);
+            }
+        }
+
+        return tmp;
+    }
+
+
+    /**
+     * @brief Run the techniques and hand each one's outcome to a callback as soon as it's known
+     * @param any flag combination in VM structure or nothing, then a callable taking a const VM::technique_profile& that returns false to stop the run there
+     * @return std::uint16_t points scored by the techniques that ran
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmrun_stream
+     */
+    template <typename Callback>
+    static u16 run_stream(Callback callback) {
+        return run_stream(core::generate_default(), callback);
+    }
+
+
+    /* The flags come first and the callback last, so the callback is rotated to the front to tell them apart */
+    template <typename ...Args>
+    static u16 run_stream(const enum_flags first, const Args ...rest) {
+        static_assert(!core::verify_flags<Args...>(), "VM::run_stream() takes a callback after the flags");
+        return core::stream_rotate(rest..., first);
+    }
+
+
+    template <typename Callback>
+    static u16 run_stream(const settings& settings, Callback callback) {
+        const flagset flags = settings.flag_collector;
+        return run_stream(flags, callback);
+    }
+
+
+    template <typename Callback>
+    static u16 run_stream(const flagset& flags, Callback callback) {
+        /* VM::PARALLEL is left out, so every callback comes from this thread right after its technique */
+        flagset serial = flags;
+        serial.reset(PARALLEL);
+
+        core::stream_sink sink{ &core::stream_deliver<Callback>, &callback, false, nullptr };
+
+        /* The sink lives on this stack frame, so it's unhooked however the run ends */
+        struct stream_guard {
+            core::stream_sink* previous;
+            ~stream_guard() { core::stream = previous; }
+        } guard{ core::stream };
+
+        core::stream = &sink;
+
+        core::run_result run;
+        const u16 points = core::run_all(serial, false, run);
+
+        if (sink.error) {
+            std::rethrow_exception(sink.error);
+        }
+
+        return points;
+    }
+
+
     /**
      * @brief Fetch the total number of detected techniques
      * @param any flag combination in VM structure or nothing
@@ -16358,8 +20368,10 @@ public:
 
 
     static u8 detected_count(const flagset& flags = core::generate_default()) {
-        core::run_all(flags); /* run all the techniques, which will set the detected_count variable */
-        return detected_count_num;
+        core::run_result run;
+        core::run_all(flags, false, run);
+        core::publish(run); /* so the detected_count_num variable reflects this call */
+        return run.detected_count;
     }
 
 
@@ -16383,91 +20395,31 @@ public:
 
     static std::string type(const flagset &flags = core::generate_default()) {
         const brand_list_t& list = brands::brand_list(flags);
+        return brands::brand_type(list, core::is_enabled(flags, MULTIPLE));
+    }
 
-        if (core::is_enabled(flags, MULTIPLE)) {
-            if (list.size() > 1) {
-                return "Unknown";
-            }
-        }
-    
-        const enum brand_enum brand = brands::brand_single(list);
-
-        switch (brand) {
-            case brand_enum::XEN: return "Hypervisor (Type 1)";
-            case brand_enum::VMWARE_ESX: return "Hypervisor (Type 1)";
-            case brand_enum::ACRN: return "Hypervisor (Type 1)";
-            case brand_enum::QNX: return "Hypervisor (Type 1)";
-            case brand_enum::HYPERV: return "Hypervisor (Type 2)"; /* to clarify you're running under a Hyper-V guest VM */
-            case brand_enum::AZURE_HYPERV: return "Hypervisor (Type 1)";
-            case brand_enum::KVM: return "Hypervisor (Type 1)";
-            case brand_enum::KVM_HYPERV: return "Hypervisor (Type 1)";
-            case brand_enum::QEMU_KVM_HYPERV: return "Hypervisor (Type 1)";
-            case brand_enum::QEMU_KVM: return "Hypervisor (Type 1)";
-            case brand_enum::INTEL_KGT: return "Hypervisor (Type 1)";
-            case brand_enum::SIMPLEVISOR: return "Hypervisor (Type 1)";
-            case brand_enum::OPENSTACK: return "Hypervisor (Type 1)";
-            case brand_enum::KUBEVIRT: return "Hypervisor (Type 1)";
-            case brand_enum::POWERVM: return "Hypervisor (Type 1)";
-            case brand_enum::AWS_NITRO: return "Hypervisor (Type 1)";
-            case brand_enum::LKVM: return "Hypervisor (Type 1)";
-            case brand_enum::NOIRVISOR: return "Hypervisor (Type 1)";
-            case brand_enum::WSL: return "Hypervisor (Type 1)";  /* Type 1-derived lightweight VM system */
-            case brand_enum::DBVM: return "Hypervisor (Type 1)" ;
-            case brand_enum::BHYVE: return "Hypervisor (Type 2)";
-            case brand_enum::VBOX: return "Hypervisor (Type 2)";
-            case brand_enum::VMWARE: return "Hypervisor (Type 2)";
-            case brand_enum::VMWARE_EXPRESS: return "Hypervisor (Type 2)";
-            case brand_enum::VMWARE_GSX: return "Hypervisor (Type 2)";
-            case brand_enum::VMWARE_WORKSTATION: return "Hypervisor (Type 2)";
-            case brand_enum::VMWARE_FUSION: return "Hypervisor (Type 2)";
-            case brand_enum::PARALLELS: return "Hypervisor (Type 2)";
-            case brand_enum::VPC: return "Hypervisor (Type 2)";
-            case brand_enum::NVMM: return "Hypervisor (Type 2)";
-            case brand_enum::BSD_VMM: return "Hypervisor (Type 2)";
-            case brand_enum::HYPERV_VPC: return "Hypervisor (Type 2)";
-            case brand_enum::VMWARE_HARD: return "Hypervisor (Type 2)";
-            case brand_enum::UTM: return "Hypervisor (Type 2)";
-            case brand_enum::INTEL_HAXM: return "Hosted hypervisor / accelerator (Type 2)";
-            case brand_enum::CUCKOO: return "Sandbox";
-            case brand_enum::SANDBOXIE: return "Sandbox";
-            case brand_enum::HYBRID: return "Sandbox";
-            case brand_enum::CWSANDBOX: return "Sandbox";
-            case brand_enum::JOEBOX: return "Sandbox";
-            case brand_enum::ANUBIS: return "Sandbox";
-            case brand_enum::COMODO: return "Sandbox";
-            case brand_enum::THREATEXPERT: return "Sandbox";
-            case brand_enum::QIHOO: return "Sandbox";
-            case brand_enum::BOCHS: return "Emulator";
-            case brand_enum::BLUESTACKS: return "Emulator";
-            case brand_enum::NEKO_PROJECT: return "Emulator";
-            case brand_enum::COMPAQ: return "Emulator";
-            case brand_enum::INSIGNIA: return "Emulator";
-            case brand_enum::CONNECTIX: return "Emulator";
-            case brand_enum::QEMU: return "Emulator/Hypervisor (Type 2)";
-            case brand_enum::JAILHOUSE: return "Partitioning Hypervisor";
-            case brand_enum::UNISYS: return "Partitioning Hypervisor";
-            case brand_enum::DOCKER: return "Container";
-            case brand_enum::PODMAN: return "Container";
-            case brand_enum::OPENVZ: return "Container";
-            case brand_enum::CONTAINERD: return "Container";
-            case brand_enum::LMHS: return "Hypervisor (unknown type)";
-            case brand_enum::WINE: return "Compatibility layer";
-            case brand_enum::INTEL_TDX: return "Trusted Domain";
-            case brand_enum::APPLE_VZ: return "Unknown";
-            case brand_enum::UML: return "Paravirtualised/Hypervisor (Type 2)";
-            case brand_enum::AMD_SEV: return "VM encryptor";
-            case brand_enum::AMD_SEV_ES: return "VM encryptor";
-            case brand_enum::AMD_SEV_SNP: return "VM encryptor";
-            case brand_enum::GCE: return "Cloud VM service";
-            case brand_enum::BAREVISOR: return "Hypervisor (Type 1)";
-            case brand_enum::HYPERPLATFORM: return "Hypervisor (Type 1)";
-            case brand_enum::MINIVISOR: return "Hypervisor (Type 1)";
-            case brand_enum::HYPERV_ROOT: return "Host machine"; /* this refers to the type 1 hypervisor where Windows normally runs under, we put "Host machine" to clarify you're not running under a traditional VM if this is detected */
-            case brand_enum::NULL_BRAND: return "Unknown";
-            case brand_enum::INVALID: return "Invalid";
-        }
-
-        return "Invalid";
+
+    /**
+     * @brief Fetch the VM type as a static string, without any heap allocation
+     * @param any flag combination in VM structure or nothing
+     * @return const char*
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-allocation-free-api
+     */
+    template <typename ...Args>
+    static const char* type_name(const Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return type_name(flags);
+    }
+
+
+    static const char* type_name(const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return type_name(flags);
+    }
+
+
+    static const char* type_name(const flagset& flags = core::generate_default()) noexcept {
+        return brands::brand_type(brand_ranking(flags), core::is_enabled(flags, MULTIPLE));
     }
 
 
@@ -16490,98 +20442,111 @@ public:
 
 
     static std::string conclusion(const flagset& flags = core::generate_default()) {
-        if (memo::conclusion::is_cached(flags)) {
-            return memo::conclusion::fetch();
+        std::string cached_conclusion;
+        if (memo::conclusion::fetch(flags, cached_conclusion)) {
+            return cached_conclusion;
         }
 
-        const u8 percent_tmp = percentage(flags);
-        
-        constexpr const char* very_unlikely = "Very unlikely";
-        constexpr const char* unlikely = "Unlikely";
-        constexpr const char* potentially = "Potentially";
-        constexpr const char* might = "Might be";
-        constexpr const char* likely = "Likely";
-        constexpr const char* very_likely = "Very likely";
-        constexpr const char* inside_vm = "Running inside";
-        
-        auto make_conclusion = [&](const char* category) -> std::string {
-            const brand_list_t& list = brands::brand_list(flags);
+        const u8 percent = percentage(flags);
+        const std::string result = brands::conclusion(flags, percent, brands::brand_list(flags));
 
-            const brand_enum first_brand = brands::brand_single(list);
+        memo::conclusion::store(result.c_str(), flags);
+        return result;
+    }
 
-            const char* addition = " a ";
 
-            /*
-             * This basically just fixes the grammatical syntax
-             * by either having "a" or "an" before the VM brand
-             * name. It would look weird if the conclusion
-             * message was "an VirtualBox" or "a Anubis"
-             */
-            if 
-            ( 
-                (first_brand == brand_enum::ACRN)        ||
-                (first_brand == brand_enum::ANUBIS)      ||
-                (first_brand == brand_enum::BSD_VMM)     ||
-                (first_brand == brand_enum::INTEL_HAXM)  ||
-                (first_brand == brand_enum::APPLE_VZ)    ||
-                (first_brand == brand_enum::INTEL_KGT)   ||
-                (first_brand == brand_enum::POWERVM)     ||
-                (first_brand == brand_enum::OPENSTACK)   ||
-                (first_brand == brand_enum::AWS_NITRO)   ||
-                (first_brand == brand_enum::OPENVZ)      ||
-                (first_brand == brand_enum::INTEL_TDX)   ||
-                (first_brand == brand_enum::AMD_SEV)     ||
-                (first_brand == brand_enum::AMD_SEV_ES)  ||
-                (first_brand == brand_enum::AMD_SEV_SNP) ||
-                (first_brand == brand_enum::NULL_BRAND)              
-            )   
-            {             addition = " an ";             }
-
-            std::string brand_str;
+    /**
+     * @brief Write the conclusion message into a caller-provided buffer, without any heap allocation
+     * @param a buffer and its size, then any flag combination in VM structure or nothing
+     * @return std::size_t length of the whole message, which was cut short to fit if it's not below the buffer size
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-allocation-free-api
+     */
+    template <typename ...Args>
+    static size_t conclusion_into(char* buffer, const size_t capacity, const Args ...args) {
+        const flagset flags = core::arg_handler(args...);
+        return conclusion_into(buffer, capacity, flags);
+    }
 
-            /*
-             * This is basically just to remove the capital "U",
-             * since it doesn't make sense to see "an Unknown"
-             */
-            if (first_brand == brand_enum::NULL_BRAND) {
-                brand_str = "unknown";
-            } 
-            else {
-                if (core::is_enabled(flags, MULTIPLE)) {
-                    brand_str = brands::brand_multiple(flags);
-                } 
-                else {
-                    brand_str = brands::brand_enum_to_string(first_brand);
-                }
-            }
 
-            const std::string result = 
-                std::string(category) + 
-                addition + 
-                brand_str + 
-                /* Hyper-V artifacts are an exception due to how unique the circumstance is */
-                (first_brand == brand_enum::HYPERV_ROOT ? "" : " VM");
+    static size_t conclusion_into(char* buffer, const size_t capacity, const settings& settings) {
+        const flagset flags = settings.flag_collector;
+        return conclusion_into(buffer, capacity, flags);
+    }
 
-            memo::conclusion::store(result.c_str(), flags);
 
-            return result;
-        };
+    static size_t conclusion_into(char* buffer, const size_t capacity, const flagset& flags = core::generate_default()) noexcept {
+        /* Like brand_ranking(), off a fresh tally, and the percentage comes out of the same run */
+        core::run_result run;
+        const u16 points = core::run_all(flags, false, run);
+
+        brand_set ranked;
+        brands::rank(run.hits, points, ranked);
+
+        return brands::conclusion(buffer, capacity, flags, core::to_percentage(points, flags), ranked);
+    }
 
-        if (core::is_enabled(flags, DYNAMIC)) {
-            if (percent_tmp == 0)  { return "Running on bare metal";        }
-            if (percent_tmp <= 20) { return make_conclusion(very_unlikely); }
-            if (percent_tmp <= 35) { return make_conclusion(unlikely);      }
-            if (percent_tmp < 50)  { return make_conclusion(potentially);   }
-            if (percent_tmp <= 62) { return make_conclusion(might);         }
-            if (percent_tmp <= 75) { return make_conclusion(likely);        }
-            if (percent_tmp < 100) { return make_conclusion(very_likely);   }
+
+    /**
+     * @brief Evaluate several flag combinations at once, running each technique only a single time
+     * @param a pointer to the flag combinations and how many there are, or a vector of them
+     * @return std::vector<VM::evaluation>, in the same order as the flag combinations
+     * @link https://github.com/NotRequiem/VMAware/blob/main/docs/documentation.md#advanced-vmevaluate_many
+     */
+    static std::vector<evaluation> evaluate_many(const flagset* configs, const std::size_t count) {
+        std::vector<evaluation> results;
+        if (configs == nullptr || count == 0) {
+            return results;
+        }
+
+        /*
+         * Run the union of every technique that any of the combinations
+         * asks for. After that, every technique is in the technique cache,
+         * so each combination is just a tally over cached results and
+         * none of them runs anything again
+         */
+        flagset needed;
+        for (std::size_t i = 0; i < count; ++i) {
+            needed |= configs[i];
         }
 
-        if (percent_tmp == 100) {
-            return make_conclusion(inside_vm);
+        core::run_result shared;
+        core::run_all(needed, false, shared);
+
+        /* Keep the timings of the run that did the work, not of the last tally */
+        const core::profile_table shared_profile = core::last_profile;
+
+        results.reserve(count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const flagset& flags = configs[i];
+
+            core::run_result run;
+            const u16 points = core::run_all(flags, false, run);
+
+            const bool multiple = core::is_enabled(flags, MULTIPLE);
+
+            evaluation result;
+            result.flags = flags;
+            result.points = points;
+            result.is_vm = (points >= core::threshold(flags));
+            result.percentage = core::to_percentage(points, flags);
+            result.detected_count = run.detected_count;
+            result.detected = run.detected;
+            result.brands = brands::brand_list(run.hits, points);
+            result.brand = multiple ? brands::brand_multiple(result.brands) : std::string(brands::brand_enum_to_string(brands::brand_single(result.brands)));
+            result.type = brands::brand_type(result.brands, multiple);
+            result.conclusion = brands::conclusion(flags, result.percentage, result.brands);
+
+            results.push_back(std::move(result));
         }
 
-        return "Running on bare metal";
+        core::last_profile = shared_profile;
+        return results;
+    }
+
+
+    static std::vector<evaluation> evaluate_many(const std::vector<flagset>& configs) {
+        return evaluate_many(configs.data(), configs.size());
     }
 
 
@@ -16614,27 +20579,43 @@ public:
             initialise(flags);
         }
 
-        /* Having this design avoids some niche errors */
+        /*
+         * Every field is derived from one full run of the engine, instead of each public
+         * function re-entering it on its own. The run doesn't take the SHORTCUT, since the
+         * brand needs every technique anyway, so all fields agree with each other.
+         */
         void initialise(const flagset& flags) {
-            brand = VM::brand(flags);
-            type = VM::type(flags);
-            conclusion = VM::conclusion(flags);
-            is_vm = VM::detect(flags);
+            core::run_result run;
+            const u16 points = core::run_all(flags, false, run);
+            core::publish(run);
+
+            brand_list_t list;
+            if (!memo::brand_list::fetch(flags, list)) {
+                list = brands::brand_list(run.hits, points);
+                memo::brand_list::store(list, flags);
+            }
+
+            const bool multiple = core::is_enabled(flags, MULTIPLE);
+
+            brand = multiple ? brands::brand_multiple(list) : std::string(brands::brand_enum_to_string(brands::brand_single(list)));
+            type = brands::brand_type(list, multiple);
+            is_vm = (points >= core::threshold(flags));
             is_hardened = false;
-            percentage = VM::percentage(flags);
-            detected_count = VM::detected_count(flags);
+            percentage = core::to_percentage(points, flags);
+            conclusion = brands::conclusion(flags, percentage, list);
+            detected_count = run.detected_count;
             technique_count = VM::technique_count;
-            detected_techniques = VM::detected_enums(flags);
-            detected_technique_strings = [&]() -> std::vector<std::string> {
-                std::vector<std::string> tmp{};
-                tmp.reserve(detected_techniques.size());
 
-                for (const auto technique : detected_techniques) {
-                    tmp.push_back(VM::flag_to_string(technique));
-                }
+            detected_techniques.clear();
+            detected_technique_strings.clear();
 
-                return tmp;
-            }();
+            for (u8 i = technique_begin; i < technique_end; ++i) {
+                if (run.detected.test(i)) {
+                    const enum_flags technique_enum = static_cast<enum_flags>(i);
+                    detected_techniques.push_back(technique_enum);
+                    detected_technique_strings.push_back(VM::flag_to_string(technique_enum));
+                }
+            }
 
             disabled_techniques = VM::disabled_techniques;
         }
@@ -16647,8 +20628,6 @@ public:
  * These are added here due to warnings related to C++17 inline variables for C++ standards that are under 17
  * It's easier to just group them together rather than having C++17<= preprocessors with inline stuff
  */
-char VM::memo::conclusion::cache[512] = { 0 };
-bool VM::memo::conclusion::cached = false;
 
 /* Scoreboard list of brands, if a VM detection technique detects a brand, that will be incremented here as a single point */
 std::array<VM::core::brand_entry, VM::MAX_BRANDS> VM::core::brand_scoreboard = []() {
@@ -16664,31 +20643,53 @@ std::array<VM::core::brand_entry, VM::MAX_BRANDS> VM::core::brand_scoreboard = [
 static_assert(VM::core::brand_scoreboard.size() == VM::MAX_BRANDS, "brand_scoreboard size must match MAX_BRANDS.");
 
 /* Initial definitions for cache items because C++ forbids in-class initializations */
-VM::flagset VM::memo::conclusion::cached_flags{};
-VM::flagset VM::memo::single_brand::cached_flags{};
-VM::flagset VM::memo::multi_brand::cached_flags{};
-VM::flagset VM::memo::brand_list::cached_flags{};
-VM::brand_list_t VM::memo::brand_list::cache = {};
-VM::hyperx_state VM::memo::hyperx::state = VM::HYPERV_UNKNOWN;
-VM::u32 VM::memo::thread_count::thread_count_cache = 0;
+VM::memo::result_cache<VM::memo::conclusion::text_t> VM::memo::conclusion::entries{};
+VM::memo::result_cache<VM::brand_enum> VM::memo::single_brand::entries{};
+VM::memo::result_cache<std::string> VM::memo::multi_brand::entries{};
+VM::memo::result_cache<VM::brand_list_t> VM::memo::brand_list::entries{};
+std::atomic<VM::hyperx_state> VM::memo::hyperx::state{ VM::HYPERV_UNKNOWN };
+std::atomic<VM::u32> VM::memo::thread_count::thread_count_cache{ 0 };
 std::array<VM::memo::cache_entry, VM::enum_size + 1> VM::memo::cache_table{};
-std::array<VM::memo::leaf_entry, VM::memo::leaf_cache::CAPACITY> VM::memo::leaf_cache::table{};
-std::string VM::memo::multi_brand::brand_cache;
-std::size_t VM::memo::leaf_cache::count = 0;
-std::size_t VM::memo::leaf_cache::next_index = 0;
-enum VM::brand_enum VM::memo::single_brand::brand_cache = brand_enum::NULL_BRAND;
+std::mutex VM::memo::wait_mutex;
+std::condition_variable VM::memo::wait_cv;
+std::mutex VM::memo::result_mutex;
+std::array<VM::memo::file_cache::entry, VM::memo::file_cache::CAPACITY> VM::memo::file_cache::table{};
+std::size_t VM::memo::file_cache::count = 0;
+VM::memo::file_cache::stats_t VM::memo::file_cache::totals{};
+std::atomic<VM::u32> VM::memo::file_cache::active_runs{ 0 };
+std::atomic<VM::u64> VM::memo::file_cache::generation{ 0 };
+thread_local VM::u64 VM::memo::file_cache::run_generation = 0;
+std::mutex VM::memo::file_cache::mutex;
+std::mutex VM::memo::cpu_brand::mutex;
+std::mutex VM::memo::cpuid_snapshot::mutex;
+std::mutex VM::core::scoreboard_mutex;
+constexpr VM::u32 VM::memo::cpuid_snapshot::subleaf_leaves[4];
+VM::u32 VM::memo::cpuid_snapshot::table[VM::memo::cpuid_snapshot::SLOTS][4] = {};
+std::atomic<bool> VM::memo::cpuid_snapshot::valid[VM::memo::cpuid_snapshot::SLOTS] = {};
+std::atomic<bool> VM::memo::cpuid_snapshot::loaded{ false };
+#if (LINUX)
+std::mutex VM::memo::disk_cache::mutex;
+std::atomic<VM::u32> VM::memo::disk_cache::saved{ 0 };
+#endif
 char VM::memo::cpu_brand::brand_cache[128] = { 0 };
 char VM::memo::bios_info::manufacturer[256] = { 0 };
 char VM::memo::bios_info::model[128] = { 0 };
-bool VM::memo::single_brand::cached = false;
-bool VM::memo::multi_brand::cached = false;
-bool VM::memo::cpu_brand::cached = false;
-bool VM::memo::bios_info::cached = false;
-bool VM::memo::hyperx::cached = false;
-bool VM::memo::brand_list::cached = false;
+std::atomic<bool> VM::memo::cpu_brand::cached{ false };
+std::atomic<bool> VM::memo::bios_info::cached{ false };
+std::atomic<bool> VM::memo::hyperx::cached{ false };
+
+#if (VMAWARE_CPP < 17)
+/* Both arrays are odr-used by range-for loops, and static constexpr members are only implicitly inline since C++17 */
+constexpr std::array<VM::enum_flags, 1> VM::experimental_techniques;
+constexpr std::array<VM::enum_flags, 25> VM::parallel_techniques;
+#endif
 
-enum VM::brand_enum VM::core::last_detected_brand = VM::brand_enum::NULL_BRAND;
-VM::u8 VM::core::last_detected_score = 0;
+thread_local enum VM::brand_enum VM::core::last_detected_brand = VM::brand_enum::NULL_BRAND;
+thread_local VM::u8 VM::core::last_detected_score = 0;
+thread_local VM::core::brand_hits_t* VM::core::brand_capture = nullptr;
+thread_local VM::core::profile_table VM::core::last_profile{};
+thread_local VM::core::stream_sink* VM::core::stream = nullptr;
+std::array<std::atomic<VM::u32>, VM::enum_size + 1> VM::core::measured_cost{};
 
 /*
  * These are basically the base values for the core::arg_handler function.
@@ -16715,122 +20716,145 @@ std::vector<VM::core::custom_technique> VM::core::custom_table = {};
 size_t VM::core::custom_table_size = 0;
 
 /* The points are debatable, but we think it's fine how it is. Feel free to disagree */
-std::array<VM::core::technique, VM::enum_size + 1> VM::core::technique_table = []() {
-    std::array<VM::core::technique, VM::enum_size + 1> table{};
-    /* FORMAT: { VM::<ID>, { certainty%, function pointer } }, */
-    const VM::core::technique_entry entries[] = {
-        // START OF TECHNIQUE TABLE
-        #if (WINDOWS)
-            {VM::TRAP, {150, VM::trap}},
-            {VM::KVM_INTERCEPTION, {150, VM::kvm_interception}},
-            {VM::SVM_EXCEPTIONS, {35, VM::svm_exceptions}},
-            {VM::MEASURED_BOOT, {150, VM::measured_boot}},
-            {VM::INTERRUPT_SHADOW, {150, VM::interrupt_shadow}},
-            {VM::EIP_OVERFLOW, {150, VM::eip_overflow}},
-            {VM::HYPERVISOR_HOOK, {150, VM::hypervisor_hook}},
-            {VM::SINGLE_STEP, {150, VM::single_step}},
-            {VM::TPM, {45, VM::tpm}},
-            {VM::NVRAM, {100, VM::nvram}},
-            {VM::CPU_HEURISTIC, {90, VM::cpu_heuristic}},
-            {VM::ACPI_SIGNATURE, {100, VM::acpi_signature}},
-            {VM::CLOCK, {45, VM::clock}},
-            {VM::POWER_CAPABILITIES, {25, VM::power_capabilities}},
-            {VM::GPU_CAPABILITIES, {20, VM::gpu_capabilities}},
-            {VM::MSR, {100, VM::msr}},
-            {VM::VIRTUAL_PROCESSORS, {100, VM::virtual_processors}},
-            {VM::WINE, {150, VM::wine}},
-            {VM::DBVM, {150, VM::dbvm}},
-            {VM::UD, {100, VM::ud}},
-            {VM::DRIVERS, {100, VM::drivers}},
-            {VM::HANDLES, {100, VM::device_handles}},
-            {VM::KERNEL_OBJECTS, {100, VM::kernel_objects}},
-            {VM::DLL, {50, VM::dll}},
-            {VM::AUDIO, {25, VM::audio}},
-            {VM::DISPLAY, {25, VM::display}},
-            {VM::VIRTUAL_REGISTRY, {90, VM::virtual_registry}},
-            {VM::MUTEX, {100, VM::mutex}},
-            {VM::VPC_INVALID, {75, VM::vpc_invalid}},
-            {VM::VMWARE_STR, {35, VM::vmware_str}},
-            {VM::GAMARUE, {30, VM::gamarue}},
-            {VM::CUCKOO, {30, VM::cuckoo}},
-        #endif
+/* FORMAT: { VM::<ID>, { certainty%, function pointer, cost class[, volatility class if not per-boot][, max score if core::add() overrides the certainty] } }, */
+constexpr VM::core::technique_entry VM::core::technique_entries[] = {
+    // START OF TECHNIQUE TABLE
+    #if (WINDOWS)
+        {VM::TRAP, {150, VM::trap, VM::core::COST_CPU}},
+        {VM::KVM_INTERCEPTION, {150, VM::kvm_interception, VM::core::COST_CPU}},
+        {VM::SVM_EXCEPTIONS, {35, VM::svm_exceptions, VM::core::COST_CPU, 150}},
+        {VM::MEASURED_BOOT, {150, VM::measured_boot, VM::core::COST_HEAVY}},
+        {VM::INTERRUPT_SHADOW, {150, VM::interrupt_shadow, VM::core::COST_CPU}},
+        {VM::EIP_OVERFLOW, {150, VM::eip_overflow, VM::core::COST_CPU}},
+        {VM::HYPERVISOR_HOOK, {150, VM::hypervisor_hook, VM::core::COST_HEAVY}},
+        {VM::SINGLE_STEP, {150, VM::single_step, VM::core::COST_CPU}},
+        {VM::TPM, {45, VM::tpm, VM::core::COST_HEAVY}},
+        {VM::NVRAM, {100, VM::nvram, VM::core::COST_HEAVY}},
+        {VM::CPU_HEURISTIC, {90, VM::cpu_heuristic, VM::core::COST_CPU}},
+        {VM::ACPI_SIGNATURE, {100, VM::acpi_signature, VM::core::COST_HEAVY}},
+        {VM::CLOCK, {45, VM::clock, VM::core::COST_HEAVY}},
+        {VM::POWER_CAPABILITIES, {25, VM::power_capabilities, VM::core::COST_LIGHT}},
+        {VM::GPU_CAPABILITIES, {20, VM::gpu_capabilities, VM::core::COST_HEAVY}},
+        {VM::MSR, {100, VM::msr, VM::core::COST_LIGHT}},
+        {VM::VIRTUAL_PROCESSORS, {100, VM::virtual_processors, VM::core::COST_CPU}},
+        {VM::WINE, {150, VM::wine, VM::core::COST_LIGHT}},
+        {VM::DBVM, {150, VM::dbvm, VM::core::COST_CPU}},
+        {VM::UD, {100, VM::ud, VM::core::COST_CPU}},
+        {VM::DRIVERS, {100, VM::drivers, VM::core::COST_HEAVY}},
+        {VM::HANDLES, {100, VM::device_handles, VM::core::COST_LIGHT}},
+        {VM::KERNEL_OBJECTS, {100, VM::kernel_objects, VM::core::COST_HEAVY}},
+        {VM::DLL, {50, VM::dll, VM::core::COST_LIGHT, VM::core::PER_PROCESS}},
+        {VM::AUDIO, {25, VM::audio, VM::core::COST_HEAVY}},
+        {VM::DISPLAY, {25, VM::display, VM::core::COST_LIGHT, VM::core::PER_PROCESS}},
+        {VM::VIRTUAL_REGISTRY, {90, VM::virtual_registry, VM::core::COST_HEAVY}},
+        {VM::MUTEX, {100, VM::mutex, VM::core::COST_LIGHT, VM::core::TIME_VARYING}},
+        {VM::VPC_INVALID, {75, VM::vpc_invalid, VM::core::COST_CPU}},
+        {VM::VMWARE_STR, {35, VM::vmware_str, VM::core::COST_CPU}},
+        {VM::GAMARUE, {30, VM::gamarue, VM::core::COST_LIGHT}},
+        {VM::CUCKOO, {30, VM::cuckoo, VM::core::COST_LIGHT, VM::core::PER_PROCESS}},
+    #endif
 
-        #if (LINUX || WINDOWS)
-            {VM::FIRMWARE, {100, VM::firmware}},
-            {VM::DEVICES, {95, VM::pci_devices}},
-            {VM::SYSTEM_REGISTERS, {50, VM::system_registers}},
-            {VM::AZURE, {30, VM::azure}},
-            {VM::BOOT_LOGO, {90, VM::boot_logo}},
-            {VM::DISK, {150, VM::disk}},
-        #endif
+    #if (LINUX || WINDOWS)
+        {VM::FIRMWARE, {100, VM::firmware, VM::core::COST_HEAVY}},
+        {VM::DEVICES, {95, VM::pci_devices, VM::core::COST_HEAVY}},
+        {VM::SYSTEM_REGISTERS, {50, VM::system_registers, VM::core::COST_CPU, 100}},
+        {VM::AZURE, {30, VM::azure, VM::core::COST_LIGHT}},
+        {VM::BOOT_LOGO, {90, VM::boot_logo, VM::core::COST_HEAVY}},
+        {VM::DISK, {150, VM::disk, VM::core::COST_LIGHT}},
+    #endif
 
-        #if (LINUX)
-            {VM::SMBIOS_VM_BIT, {50, VM::smbios_vm_bit}},
-            {VM::KMSG, {5, VM::kmsg}},
-            {VM::CVENDOR, {65, VM::chassis_vendor}},
-            {VM::QEMU_FW_CFG, {70, VM::qemu_fw_cfg}},
-            {VM::SYSTEMD, {35, VM::systemd_virt}},
-            {VM::CTYPE, {20, VM::chassis_type}},
-            {VM::DOCKERENV, {100, VM::dockerenv}},
-            {VM::DMIDECODE, {55, VM::dmidecode}},
-            {VM::DMESG, {55, VM::dmesg}},
-            {VM::HWMON, {35, VM::hwmon}},
-            {VM::LINUX_USER_HOST, {10, VM::linux_user_host}},
-            {VM::QEMU_VIRTUAL_DMI, {40, VM::qemu_virtual_dmi}},
-            {VM::QEMU_USB, {20, VM::qemu_usb}},
-            {VM::HYPERVISOR_DIR, {20, VM::hypervisor_dir}},
-            {VM::UML_CPU, {80, VM::uml_cpu}},
-            {VM::VBOX_MODULE, {15, VM::vbox_module}},
-            {VM::SYSINFO_PROC, {15, VM::sysinfo_proc}},
-            {VM::DMI_SCAN, {50, VM::dmi_scan}},
-            {VM::PODMAN_FILE, {5, VM::podman_file}},
-            {VM::WSL_PROC, {30, VM::wsl_proc_subdir}},
-            {VM::FILE_ACCESS_HISTORY, {15, VM::file_access_history}},
-            {VM::MAC, {20, VM::mac_address_check}},
-            {VM::CONTAINER_PID, {75, VM::container_proc_id}},
-            {VM::BLUESTACKS_FOLDERS, {5, VM::bluestacks}},
-            {VM::AMD_SEV_MSR, {50, VM::amd_sev_msr}},
-            {VM::TEMPERATURE, {20, VM::temperature}},
-            {VM::CGROUP, {70, VM::cgroup}},
-            {VM::PROCESSES, {40, VM::processes}},
-        #endif    
+    #if (LINUX)
+        {VM::SMBIOS_VM_BIT, {50, VM::smbios_vm_bit, VM::core::COST_LIGHT}},
+        {VM::KMSG, {5, VM::kmsg, VM::core::COST_HEAVY}},
+        {VM::CVENDOR, {65, VM::chassis_vendor, VM::core::COST_LIGHT}},
+        {VM::QEMU_FW_CFG, {70, VM::qemu_fw_cfg, VM::core::COST_LIGHT}},
+        {VM::SYSTEMD, {35, VM::systemd_virt, VM::core::COST_LIGHT, VM::core::PER_PROCESS}},
+        {VM::CTYPE, {20, VM::chassis_type, VM::core::COST_LIGHT}},
+        {VM::DOCKERENV, {100, VM::dockerenv, VM::core::COST_LIGHT, VM::core::PER_PROCESS}},
+        {VM::DMIDECODE, {55, VM::dmidecode, VM::core::COST_LIGHT}},
+        {VM::DMESG, {55, VM::dmesg, VM::core::COST_HEAVY}},
+        {VM::HWMON, {35, VM::hwmon, VM::core::COST_LIGHT}},
+        {VM::LINUX_USER_HOST, {10, VM::linux_user_host, VM::core::COST_LIGHT, VM::core::PER_PROCESS}},
+        {VM::QEMU_VIRTUAL_DMI, {40, VM::qemu_virtual_dmi, VM::core::COST_LIGHT}},
+        {VM::QEMU_USB, {20, VM::qemu_usb, VM::core::COST_HEAVY}},
+        {VM::HYPERVISOR_DIR, {20, VM::hypervisor_dir, VM::core::COST_LIGHT}},
+        {VM::UML_CPU, {80, VM::uml_cpu, VM::core::COST_LIGHT}},
+        {VM::VBOX_MODULE, {15, VM::vbox_module, VM::core::COST_LIGHT}},
+        {VM::SYSINFO_PROC, {15, VM::sysinfo_proc, VM::core::COST_LIGHT}},
+        {VM::DMI_SCAN, {50, VM::dmi_scan, VM::core::COST_LIGHT}},
+        {VM::PODMAN_FILE, {5, VM::podman_file, VM::core::COST_LIGHT, VM::core::PER_PROCESS}},
+        {VM::WSL_PROC, {30, VM::wsl_proc_subdir, VM::core::COST_LIGHT}},
+        {VM::FILE_ACCESS_HISTORY, {15, VM::file_access_history, VM::core::COST_LIGHT, VM::core::TIME_VARYING}},
+        {VM::MAC, {20, VM::mac_address_check, VM::core::COST_LIGHT, VM::core::TIME_VARYING}},
+        {VM::CONTAINER_PID, {75, VM::container_proc_id, VM::core::COST_LIGHT, VM::core::TIME_VARYING}},
+        {VM::BLUESTACKS_FOLDERS, {5, VM::bluestacks, VM::core::COST_LIGHT, VM::core::TIME_VARYING}},
+        {VM::AMD_SEV_MSR, {50, VM::amd_sev_msr, VM::core::COST_LIGHT}},
+        {VM::TEMPERATURE, {20, VM::temperature, VM::core::COST_LIGHT}},
+        {VM::CGROUP, {70, VM::cgroup, VM::core::COST_LIGHT, VM::core::TIME_VARYING}},
+        {VM::PROCESSES, {40, VM::processes, VM::core::COST_HEAVY, VM::core::TIME_VARYING}},
+    #endif    
+
+    #if (LINUX || APPLE)
+        {VM::THREAD_COUNT, {35, VM::thread_count, VM::core::COST_CPU}},
+    #endif
 
-        #if (LINUX || APPLE)
-            {VM::THREAD_COUNT, {35, VM::thread_count}},
-        #endif
+    #if (APPLE)
+        {VM::MAC_MEMSIZE, {15, VM::hw_memsize, VM::core::COST_SPAWN}},
+        {VM::MAC_IOKIT, {100, VM::io_kit, VM::core::COST_SPAWN}},
+        {VM::MAC_SIP, {100, VM::mac_sip, VM::core::COST_SPAWN}},
+        {VM::IOREG_GREP, {100, VM::ioreg_grep, VM::core::COST_SPAWN}},
+        {VM::HWMODEL, {100, VM::hwmodel, VM::core::COST_LIGHT}},
+        {VM::MAC_SYS, {100, VM::mac_sys, VM::core::COST_SPAWN}},
+    #endif
 
-        #if (APPLE)
-            {VM::MAC_MEMSIZE, {15, VM::hw_memsize}},
-            {VM::MAC_IOKIT, {100, VM::io_kit}},
-            {VM::MAC_SIP, {100, VM::mac_sip}},
-            {VM::IOREG_GREP, {100, VM::ioreg_grep}},
-            {VM::HWMODEL, {100, VM::hwmodel}},
-            {VM::MAC_SYS, {100, VM::mac_sys}},
-        #endif
+    {VM::TIMER, {100, VM::timer, VM::core::COST_SLEEP, VM::core::TIME_VARYING}},
+    {VM::THREAD_MISMATCH, {45, VM::thread_mismatch, VM::core::COST_CPU}},
+    {VM::VMID, {100, VM::vmid, VM::core::COST_CPU}},
+    {VM::CPU_BRAND, {95, VM::cpu_brand, VM::core::COST_CPU}},
+    {VM::CPUID_SIGNATURE, {95, VM::cpuid_signature, VM::core::COST_CPU}},
+    {VM::HYPERVISOR_STR, {150, VM::hypervisor_str, VM::core::COST_CPU}},
+    {VM::HYPERVISOR_BIT, {150, VM::hypervisor_bit, VM::core::COST_CPU}},
+    {VM::BOCHS_CPU, {100, VM::bochs_cpu, VM::core::COST_CPU}},
+    {VM::KGT_SIGNATURE, {80, VM::intel_kgt_signature, VM::core::COST_CPU}}
+    /* END OF TECHNIQUE TABLE */
+};
 
-        {VM::TIMER, {100, VM::timer}},
-        {VM::THREAD_MISMATCH, {45, VM::thread_mismatch}},
-        {VM::VMID, {100, VM::vmid}},
-        {VM::CPU_BRAND, {95, VM::cpu_brand}},
-        {VM::CPUID_SIGNATURE, {95, VM::cpuid_signature}},
-        {VM::HYPERVISOR_STR, {150, VM::hypervisor_str}},
-        {VM::HYPERVISOR_BIT, {150, VM::hypervisor_bit}},
-        {VM::BOCHS_CPU, {100, VM::bochs_cpu}},
-        {VM::KGT_SIGNATURE, {80, VM::intel_kgt_signature}}
-        /* END OF TECHNIQUE TABLE */
-    };
+template <size_t ...ids>
+constexpr std::array<VM::core::technique, VM::enum_size + 1> VM::core::make_technique_table(technique_ids<ids...>) {
+    return {{ find_technique(technique_entries, sizeof(technique_entries) / sizeof(technique_entries[0]), static_cast<enum_flags>(ids))... }};
+}
 
-    /* Fill the table based on ID */
-    for (const auto& entry : entries) {
-        if (entry.id < table.size()) {
-            table.at(entry.id) = entry.tech;
-        }
+/*
+ * Every slot is looked up in the list above at compile time, so the table is constant-initialized
+ * and the linker can still drop it (with every technique) from programs that never use it
+ */
+std::array<VM::core::technique, VM::enum_size + 1> VM::core::technique_table =
+    VM::core::make_technique_table(VM::core::make_technique_ids<VM::enum_size + 1>::type());
+
+template <VM::enum_flags flag>
+bool VM::core::fixed_run(u16& points, const u16 threshold) {
+    static constexpr size_t count = sizeof(technique_entries) / sizeof(technique_entries[0]);
+    static constexpr technique tech = find_technique(technique_entries, count, flag);
+    static constexpr bool listed = is_listed(technique_entries, count, flag);
+
+    if (!listed || points >= threshold) {
+        return false;
     }
-    return table;
-}();
+
+    const memo::data_t data = run_cached(flag, tech);
+    if (data.result) {
+        points = static_cast<u16>(points + data.points);
+    }
+    return true;
+}
 
 static_assert(VM::core::technique_table.size() == VM::enum_size + 1, "technique_table must map to every enum value.");
 
+#if (VMAWARE_PERSISTENT_CACHE_SUPPORTED)
+/* Loaded once technique_table is there, since the file is checked against it */
+const bool VM::memo::disk_cache::started = VM::memo::disk_cache::start();
+#endif
+
 #undef WINDOWS
 #undef LINUX
 #undef APPLE